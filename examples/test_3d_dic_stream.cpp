@@ -0,0 +1,318 @@
+/*
+ This example demonstrates how to use OpenCorr to realize real-time 3D/stereo
+ DIC with a streaming pipeline. The initial guess of POIs in the two views is
+ obtained by the epipolar constraint aided method on the reference pair, then
+ the pairs of target images are fed into StereoStream, where they are matched
+ with the ICGN algorithm with the 1st order shape function, taking the results
+ of last frame as initial guess, and reconstructed in three dimensions.
+*/
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "opencorr.h"
+
+using namespace opencorr;
+using namespace std;
+
+int main()
+{
+	//set paths of images.
+	//in this example, the right image of initial state is used as the reference image
+	string ref_view1_image_path = "d:/dic_tests/3d_dic/GT4-0000_0.tif"; //replace it with the path on your computer
+	string ref_view2_image_path = "d:/dic_tests/3d_dic/GT4-0000_1.tif"; //replace it with the path on your computer
+
+	//the frames fed into the stream, in the order of recording. Only the first and the last frames of the series are
+	//provided in the folder, which are too far apart to be tracked from one to the other, thus the reference pair is
+	//fed repeatedly, simulating a live feed of the specimen at rest. With the full series, list its frames in order
+	vector<string> frame_view1_path;
+	vector<string> frame_view2_path;
+	int frame_count = 30;
+	for (int i = 0; i < frame_count; i++)
+	{
+		frame_view1_path.push_back(ref_view1_image_path);
+		frame_view2_path.push_back(ref_view2_image_path);
+	}
+	double frame_interval = 0.1; //in seconds, i.e. a camera running at 10 frames per second
+
+	//create the instances of images
+	Image2D ref_view1_img(ref_view1_image_path);
+	Image2D ref_view2_img(ref_view2_image_path);
+
+	//create instances to read and write csv files
+	string delimiter = ",";
+	ofstream csv_out; //instance for output calculation time
+	IO2D in_out; //instance for input and output DIC data
+	in_out.setDelimiter(delimiter);
+	in_out.setHeight(ref_view1_img.height);
+	in_out.setWidth(ref_view1_img.width);
+
+	//load the coordinates of POIs in principal view
+	string file_path = "d:/dic_tests/3d_dic/GT4-POIs.csv"; //replace it with the path on your computer
+	vector<Point2D> ref_view1_pt_queue = in_out.loadPoint2D(file_path);
+	int queue_length = (int)ref_view1_pt_queue.size();
+
+	//initialize papameters for timing
+	double timer_tic, timer_toc, consumed_time;
+	vector<double> computation_time;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//set OpenMP parameters
+	int cpu_thread_number = omp_get_num_procs() - 1;
+	cpu_thread_number = cpu_thread_number < 1 ? 1 : cpu_thread_number;
+	omp_set_num_threads(cpu_thread_number);
+
+	//create the instances of camera parameters
+	CameraIntrinsics view1_cam_intrinsics, view2_cam_intrinsics;
+	CameraExtrinsics view1_cam_extrinsics, view2_cam_extrinsics;
+	view1_cam_intrinsics.fx = 6673.315918f;
+	view1_cam_intrinsics.fy = 6669.302734f;
+	view1_cam_intrinsics.fs = 0.f;
+	view1_cam_intrinsics.cx = 872.15778f;
+	view1_cam_intrinsics.cy = 579.95532f;
+	view1_cam_intrinsics.k1 = 0.032258954f;
+	view1_cam_intrinsics.k2 = -1.01141417f;
+	view1_cam_intrinsics.k3 = 29.78838921f;
+	view1_cam_intrinsics.k4 = 0;
+	view1_cam_intrinsics.k5 = 0;
+	view1_cam_intrinsics.k6 = 0;
+	view1_cam_intrinsics.p1 = 0;
+	view1_cam_intrinsics.p2 = 0;
+
+	view1_cam_extrinsics.tx = 0;
+	view1_cam_extrinsics.ty = 0;
+	view1_cam_extrinsics.tz = 0;
+	view1_cam_extrinsics.rx = 0;
+	view1_cam_extrinsics.ry = 0;
+	view1_cam_extrinsics.rz = 0;
+
+	view2_cam_intrinsics.fx = 6607.618164f;
+	view2_cam_intrinsics.fy = 6602.857422f;
+	view2_cam_intrinsics.fs = 0.f;
+	view2_cam_intrinsics.cx = 917.9733887f;
+	view2_cam_intrinsics.cy = 531.6352539f;
+	view2_cam_intrinsics.k1 = 0.064598486f;
+	view2_cam_intrinsics.k2 = -4.531373978f;
+	view2_cam_intrinsics.k3 = 29.78838921f;
+	view2_cam_intrinsics.k4 = 0;
+	view2_cam_intrinsics.k5 = 0;
+	view2_cam_intrinsics.k6 = 0;
+	view2_cam_intrinsics.p1 = 0;
+	view2_cam_intrinsics.p2 = 0;
+
+	view2_cam_extrinsics.tx = 122.24886f;
+	view2_cam_extrinsics.ty = 1.8488892f;
+	view2_cam_extrinsics.tz = 17.624638f;
+	view2_cam_extrinsics.rx = 0.00307711f;
+	view2_cam_extrinsics.ry = -0.33278773f;
+	view2_cam_extrinsics.rz = 0.00524556f;
+
+	//create the instances for stereovision
+	Calibration cam_view1_calib(view1_cam_intrinsics, view1_cam_extrinsics);
+	Calibration cam_view2_calib(view2_cam_intrinsics, view2_cam_extrinsics);
+	cam_view1_calib.prepare(ref_view1_img.height, ref_view1_img.width);
+	cam_view2_calib.prepare(ref_view2_img.height, ref_view2_img.width);
+	Stereovision stereo_reconstruction(&cam_view1_calib, &cam_view2_calib, cpu_thread_number);
+	stereo_reconstruction.prepare();
+
+	//create the queues of POIs for matching
+	Point2D point_2d;
+	POI2D poi_2d(point_2d);
+	vector<POI2D> view1_poi_queue(queue_length, poi_2d);
+	vector<POI2D> view2_poi_queue(queue_length, poi_2d);
+	vector<Point2D> ref_view2_pt_queue(queue_length, point_2d);
+
+	//assign the coordinates to POI queues
+#pragma omp parallel for
+	for (int i = 0; i < queue_length; i++)
+	{
+		view1_poi_queue[i].x = ref_view1_pt_queue[i].x;
+		view1_poi_queue[i].y = ref_view1_pt_queue[i].y;
+		view2_poi_queue[i].x = ref_view1_pt_queue[i].x;
+		view2_poi_queue[i].y = ref_view1_pt_queue[i].y;
+	}
+
+	//set DIC parameters
+	int subset_radius_x = 16;
+	int subset_radius_y = 16;
+	float conv_criterion = 0.001f;
+	int stop_condition = 10;
+
+	//initialize ICGN with the 1st order shape function for the stereo matching of reference pair
+	ICGN2D1* icgn1 = new ICGN2D1(subset_radius_x, subset_radius_y, conv_criterion, stop_condition, cpu_thread_number);
+
+	//create an instance for epipolar constraint aided matching
+	EpipolarSearch* epipolar_search = new EpipolarSearch(cam_view1_calib, cam_view2_calib, cpu_thread_number);
+
+	//set search parameters in epipolar constraint aided matching
+	Point2D parallax_guess(-30, -40);
+	epipolar_search->setParallax(parallax_guess);
+	int search_radius = 30;
+	int search_step = 5;
+	epipolar_search->setSearch(search_radius, search_step);
+
+	//initialize an ICGN2D1 instance in epipolar constraint aided matching
+	epipolar_search->createICGN(20, 20, 0.05f, 5);
+
+	//distribute the CPU threads among the stages of stream, the matching takes the most
+	int prepare_threads = cpu_thread_number / 4 < 1 ? 1 : cpu_thread_number / 4;
+	int output_threads = 1;
+	int match_threads = cpu_thread_number - prepare_threads - output_threads;
+	match_threads = match_threads < 1 ? 1 : match_threads;
+	int frame_number = 4; //frames in flight
+
+	//create an instance of stream, the POIs matched with ZNCC lower than 0.8 do not update the initial guess of next frame
+	StereoStream* stream = new StereoStream(subset_radius_x, subset_radius_y, conv_criterion, (float)stop_condition,
+		prepare_threads, match_threads, output_threads, frame_number);
+	stream->setTracking(0.8f);
+	stream->setStereovision(&stereo_reconstruction);
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //0
+
+	//display the time of initialization on screen
+	cout << "Initialization with " << queue_length << " POIs takes " << consumed_time << " sec, " << cpu_thread_number << " CPU threads launched." << std::endl;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//stereo matching between reference view1 and reference view2, which gives the initial guess of view2
+	epipolar_search->setImages(ref_view1_img, ref_view2_img);
+	epipolar_search->prepare();
+	epipolar_search->compute(view2_poi_queue);
+
+	icgn1->setImages(ref_view1_img, ref_view2_img);
+	icgn1->prepare();
+	icgn1->compute(view2_poi_queue);
+
+#pragma omp parallel for
+	for (int i = 0; i < queue_length; i++)
+	{
+		Point2D current_location(view2_poi_queue[i].x, view2_poi_queue[i].y);
+		Point2D current_offset(view2_poi_queue[i].deformation.u, view2_poi_queue[i].deformation.v);
+		ref_view2_pt_queue[i] = current_location + current_offset;
+	}
+
+	//reconstruct the 3D coordinates of reference state
+	vector<Point3D> ref_pt_3d_queue(queue_length, Point3D());
+	stereo_reconstruction.reconstruct(ref_view1_pt_queue, ref_view2_pt_queue, ref_pt_3d_queue);
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //1
+
+	//display the time of processing on the screen
+	cout << "Stereo matching between reference view1 and view2 takes " << consumed_time << " sec." << std::endl;
+
+	//the output of each completed frame, called in the output stage of stream. The displacement of POIs is
+	//summarized here, a real application may display the results or save them to disk instead
+	vector<int> frame_index;
+	vector<int> frame_valid_pois;
+	vector<float> frame_mean_w, frame_rms_w;
+	stream->setOutput([&](StreamFrame& frame)
+		{
+			int valid_pois = 0;
+			double sum_w = 0., sum_w2 = 0.;
+			for (int i = 0; i < queue_length; i++)
+			{
+				if (isnan(frame.space_z[i]) || view2_poi_queue[i].result.zncc < 0.8f)
+				{
+					continue;
+				}
+				double w = frame.space_z[i] - ref_pt_3d_queue[i].z;
+				sum_w += w;
+				sum_w2 += w * w;
+				valid_pois++;
+			}
+			float mean_w = valid_pois > 0 ? (float)(sum_w / valid_pois) : 0.f;
+			float rms_w = valid_pois > 0 ? (float)sqrt(sum_w2 / valid_pois) : 0.f;
+
+			frame_index.push_back(frame.index);
+			frame_valid_pois.push_back(valid_pois);
+			frame_mean_w.push_back(mean_w);
+			frame_rms_w.push_back(rms_w);
+		});
+
+	//the gradient maps of reference image are calculated once here
+	stream->setReference(ref_view1_img, view1_poi_queue, view2_poi_queue);
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//feed the frames at the rate of camera, a frame is dropped if all the frames are in flight
+	stream->start();
+	for (int i = 0; i < frame_count; i++)
+	{
+		Image2D tar_view1_img(frame_view1_path[i]);
+		Image2D tar_view2_img(frame_view2_path[i]);
+
+		double next_frame_time = timer_tic + (i + 1) * frame_interval;
+		double wait_time = next_frame_time - omp_get_wtime();
+		if (wait_time > 0)
+		{
+			this_thread::sleep_for(chrono::microseconds((long long)(wait_time * 1e6)));
+		}
+
+		stream->push(tar_view1_img, tar_view2_img);
+	}
+	stream->finish();
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //2
+
+	//display the time of processing on the screen
+	cout << "Streaming of " << frame_count << " frames takes " << consumed_time << " sec." << std::endl;
+
+	//display the statistics of stream
+	StreamStatistics statistics = stream->getStatistics();
+	cout << "Pushed frames: " << statistics.pushed_frames << ", completed frames: " << statistics.completed_frames
+		<< ", dropped frames: " << statistics.dropped_frames << ", skipped POIs: " << statistics.dropped_pois << std::endl;
+	cout << "Throughput: " << statistics.throughput << " frames per sec." << std::endl;
+	cout << "Latency (sec), mean: " << statistics.latency_mean << ", median: " << statistics.latency_p50
+		<< ", 90th percentile: " << statistics.latency_p90 << ", 99th percentile: " << statistics.latency_p99
+		<< ", max: " << statistics.latency_max << std::endl;
+
+	//save the summary of frames
+	file_path = ref_view1_image_path.substr(0, ref_view1_image_path.find_last_of(".")) + "_stream.csv";
+	csv_out.open(file_path);
+	if (csv_out.is_open())
+	{
+		csv_out << "frame" << delimiter << "valid POIs" << delimiter << "mean w" << delimiter << "RMS w" << endl;
+		for (int i = 0; i < (int)frame_index.size(); i++)
+		{
+			csv_out << frame_index[i] << delimiter << frame_valid_pois[i] << delimiter << frame_mean_w[i] << delimiter << frame_rms_w[i] << endl;
+		}
+	}
+	csv_out.close();
+
+	//save the computation time and the statistics of stream
+	file_path = ref_view1_image_path.substr(0, ref_view1_image_path.find_last_of(".")) + "_stream_time.csv";
+	csv_out.open(file_path);
+	if (csv_out.is_open())
+	{
+		csv_out << "POI number" << delimiter << "Initialization" << delimiter << "r1_to_r2" << delimiter << "Streaming"
+			<< delimiter << "Completed frames" << delimiter << "Dropped frames" << delimiter << "Throughput"
+			<< delimiter << "Latency mean" << delimiter << "Latency p99" << endl;
+		csv_out << queue_length << delimiter << computation_time[0] << delimiter << computation_time[1] << delimiter << computation_time[2]
+			<< delimiter << statistics.completed_frames << delimiter << statistics.dropped_frames << delimiter << statistics.throughput
+			<< delimiter << statistics.latency_mean << delimiter << statistics.latency_p99 << endl;
+	}
+	csv_out.close();
+
+	delete stream;
+	delete icgn1;
+	delete epipolar_search;
+
+	cout << "Press any key to exit..." << std::endl;
+	cin.get();
+
+	return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ This example demonstrates how to use OpenCorr to process a sequence of stereo
+ image pairs with a pipeline of stages. The profile of specimen in each frame
+ is measured with the epipolar constraint aided method, the ICGN algorithm with
+ the 1st order shape function, and stereo reconstruction. The stages run in
+ their own threads, so the loading and matching of next frame overlap with the
+ reconstruction and output of current frame.
+*/
+
+#include <fstream>
+
+#include "opencorr.h"
+
+using namespace opencorr;
+using namespace std;
+
+int main()
+{
+	//set the frames of sequence, only the first and the last frames of the series are provided in the folder,
+	//the frames in between can be inserted in the same way
+	string image_folder = "d:/dic_tests/3d_dic/"; //replace it with the path on your computer
+	vector<string> frame_names = { "GT4-0000", "GT4-0273" };
+	int frame_count = (int)frame_names.size();
+
+	//get the dimensions of images from the first frame
+	Image2D first_img(image_folder + frame_names[0] + "_0.tif");
+	int image_width = first_img.width;
+	int image_height = first_img.height;
+
+	//create instances to read and write csv files
+	string delimiter = ",";
+	ofstream csv_out; //instance for output calculation time
+	IO2D in_out; //instance for input and output DIC data
+	in_out.setDelimiter(delimiter);
+	in_out.setHeight(image_height);
+	in_out.setWidth(image_width);
+
+	//load the coordinates of POIs in principal view
+	string file_path = image_folder + "GT4-POIs.csv";
+	vector<Point2D> view1_pt_queue = in_out.loadPoint2D(file_path);
+	int queue_length = (int)view1_pt_queue.size();
+
+	//initialize papameters for timing
+	double timer_tic, timer_toc, consumed_time;
+	vector<double> computation_time;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//set OpenMP parameters
+	int cpu_thread_number = omp_get_num_procs() - 1;
+	cpu_thread_number = cpu_thread_number < 1 ? 1 : cpu_thread_number;
+
+	//create the instances of camera parameters
+	CameraIntrinsics view1_cam_intrinsics, view2_cam_intrinsics;
+	CameraExtrinsics view1_cam_extrinsics, view2_cam_extrinsics;
+	view1_cam_intrinsics.fx = 6673.315918f;
+	view1_cam_intrinsics.fy = 6669.302734f;
+	view1_cam_intrinsics.fs = 0.f;
+	view1_cam_intrinsics.cx = 872.15778f;
+	view1_cam_intrinsics.cy = 579.95532f;
+	view1_cam_intrinsics.k1 = 0.032258954f;
+	view1_cam_intrinsics.k2 = -1.01141417f;
+	view1_cam_intrinsics.k3 = 29.78838921f;
+	view1_cam_intrinsics.k4 = 0;
+	view1_cam_intrinsics.k5 = 0;
+	view1_cam_intrinsics.k6 = 0;
+	view1_cam_intrinsics.p1 = 0;
+	view1_cam_intrinsics.p2 = 0;
+
+	view1_cam_extrinsics.tx = 0;
+	view1_cam_extrinsics.ty = 0;
+	view1_cam_extrinsics.tz = 0;
+	view1_cam_extrinsics.rx = 0;
+	view1_cam_extrinsics.ry = 0;
+	view1_cam_extrinsics.rz = 0;
+
+	view2_cam_intrinsics.fx = 6607.618164f;
+	view2_cam_intrinsics.fy = 6602.857422f;
+	view2_cam_intrinsics.fs = 0.f;
+	view2_cam_intrinsics.cx = 917.9733887f;
+	view2_cam_intrinsics.cy = 531.6352539f;
+	view2_cam_intrinsics.k1 = 0.064598486f;
+	view2_cam_intrinsics.k2 = -4.531373978f;
+	view2_cam_intrinsics.k3 = 29.78838921f;
+	view2_cam_intrinsics.k4 = 0;
+	view2_cam_intrinsics.k5 = 0;
+	view2_cam_intrinsics.k6 = 0;
+	view2_cam_intrinsics.p1 = 0;
+	view2_cam_intrinsics.p2 = 0;
+
+	view2_cam_extrinsics.tx = 122.24886f;
+	view2_cam_extrinsics.ty = 1.8488892f;
+	view2_cam_extrinsics.tz = 17.624638f;
+	view2_cam_extrinsics.rx = 0.00307711f;
+	view2_cam_extrinsics.ry = -0.33278773f;
+	view2_cam_extrinsics.rz = 0.00524556f;
+
+	//create the instances of camera calibration
+	Calibration cam_view1_calib(view1_cam_intrinsics, view1_cam_extrinsics);
+	Calibration cam_view2_calib(view2_cam_intrinsics, view2_cam_extrinsics);
+	cam_view1_calib.prepare(image_height, image_width);
+	cam_view2_calib.prepare(image_height, image_width);
+
+	//the data of frames in flight, indexed with slot. Each stage works on one frame at a time, thus the modules
+	//are shared by the frames and created once for each stage
+	vector<Image2D*> view1_img, view2_img;
+	vector<vector<POI2D>> poi_queue;
+	vector<vector<Point2D>> view2_pt_queue;
+	vector<vector<Point3D>> pt_3d_queue;
+
+	EpipolarSearch* epipolar_search = nullptr;
+	ICGN2D1* icgn1 = nullptr;
+	Stereovision* stereo_reconstruction = nullptr;
+
+	//create a pipeline with at most three frames in flight
+	int frame_number = 3;
+	FramePipeline* pipeline = new FramePipeline(frame_number);
+
+	//the two views are loaded in parallel branches
+	int load_view1 = pipeline->addStage("load view1", [&](PipelineFrame& frame)
+		{
+			view1_img[frame.slot]->load(image_folder + frame_names[frame.index] + "_0.tif");
+		}, 1);
+
+	int load_view2 = pipeline->addStage("load view2", [&](PipelineFrame& frame)
+		{
+			view2_img[frame.slot]->load(image_folder + frame_names[frame.index] + "_1.tif");
+		}, 1);
+
+	//coarse stereo matching
+	int search = pipeline->addStage("epipolar search", [&](PipelineFrame& frame)
+		{
+			vector<POI2D>& current_queue = poi_queue[frame.slot];
+			for (int i = 0; i < queue_length; i++)
+			{
+				current_queue[i] = POI2D(view1_pt_queue[i]);
+			}
+
+			epipolar_search->setImages(*view1_img[frame.slot], *view2_img[frame.slot]);
+			epipolar_search->prepare();
+			epipolar_search->compute(current_queue);
+		}, cpu_thread_number, { load_view1, load_view2 });
+
+	//refined stereo matching
+	int refine = pipeline->addStage("ICGN", [&](PipelineFrame& frame)
+		{
+			icgn1->setImages(*view1_img[frame.slot], *view2_img[frame.slot]);
+			icgn1->prepare();
+			icgn1->compute(poi_queue[frame.slot]);
+		}, cpu_thread_number, { search });
+
+	//reconstruct the 3D coordinates in world coordinate system
+	int reconstruct = pipeline->addStage("reconstruction", [&](PipelineFrame& frame)
+		{
+			vector<POI2D>& current_queue = poi_queue[frame.slot];
+#pragma omp parallel for
+			for (int i = 0; i < queue_length; i++)
+			{
+				Point2D current_location(current_queue[i].x, current_queue[i].y);
+				Point2D current_offset(current_queue[i].deformation.u, current_queue[i].deformation.v);
+				view2_pt_queue[frame.slot][i] = current_location + current_offset;
+			}
+			stereo_reconstruction->reconstruct(view1_pt_queue, view2_pt_queue[frame.slot], pt_3d_queue[frame.slot]);
+		}, 2, { refine });
+
+	//save the results of each frame
+	pipeline->addStage("output", [&](PipelineFrame& frame)
+		{
+			vector<POI2D>& current_queue = poi_queue[frame.slot];
+			vector<POI2DS> poi_result_queue(queue_length, POI2DS(0, 0));
+			for (int i = 0; i < queue_length; i++)
+			{
+				poi_result_queue[i].x = current_queue[i].x;
+				poi_result_queue[i].y = current_queue[i].y;
+				poi_result_queue[i].result.r2_x = view2_pt_queue[frame.slot][i].x;
+				poi_result_queue[i].result.r2_y = view2_pt_queue[frame.slot][i].y;
+				poi_result_queue[i].result.r1r2_zncc = current_queue[i].result.zncc;
+				poi_result_queue[i].ref_coor = pt_3d_queue[frame.slot][i];
+			}
+
+			in_out.setPath(image_folder + frame_names[frame.index] + "_reconstruction_pipeline.csv");
+			in_out.saveTable2DS(poi_result_queue);
+		}, 1, { reconstruct });
+
+	//the threads of stages are reduced in proportion to fit the CPU, then the data of slots are allocated
+	pipeline->setCoreBudget(cpu_thread_number);
+	int slot_number = pipeline->getSlotNumber();
+	for (int i = 0; i < slot_number; i++)
+	{
+		view1_img.push_back(new Image2D(image_width, image_height));
+		view2_img.push_back(new Image2D(image_width, image_height));
+	}
+	poi_queue.assign(slot_number, vector<POI2D>(queue_length, POI2D(0, 0)));
+	view2_pt_queue.assign(slot_number, vector<Point2D>(queue_length, Point2D()));
+	pt_3d_queue.assign(slot_number, vector<Point3D>(queue_length, Point3D()));
+
+	//create an instance for epipolar constraint aided matching
+	epipolar_search = new EpipolarSearch(cam_view1_calib, cam_view2_calib, pipeline->getStageThreads(search));
+
+	//set search parameters in epipolar constraint aided matching
+	Point2D parallax_guess(-30, -40);
+	epipolar_search->setParallax(parallax_guess);
+	int search_radius = 30;
+	int search_step = 5;
+	epipolar_search->setSearch(search_radius, search_step);
+
+	//initialize an ICGN2D1 instance in epipolar constraint aided matching
+	epipolar_search->createICGN(20, 20, 0.05f, 5);
+
+	//initialize ICGN with the 1st order shape function
+	int subset_radius_x = 16;
+	int subset_radius_y = 16;
+	float conv_criterion = 0.001f;
+	float stop_condition = 10;
+	icgn1 = new ICGN2D1(subset_radius_x, subset_radius_y, conv_criterion, stop_condition, pipeline->getStageThreads(refine));
+
+	//create the instance for stereovision
+	stereo_reconstruction = new Stereovision(&cam_view1_calib, &cam_view2_calib, pipeline->getStageThreads(reconstruct));
+	stereo_reconstruction->prepare();
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //0
+
+	//display the time of initialization on screen
+	cout << "Initialization with " << queue_length << " POIs takes " << consumed_time << " sec, " << cpu_thread_number << " CPU threads launched." << std::endl;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//process the sequence
+	try
+	{
+		pipeline->run(frame_count);
+	}
+	catch (string& error)
+	{
+		cout << "Error: " << error << std::endl;
+	}
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //1
+
+	//display the time of processing on the screen
+	cout << "Processing of " << frame_count << " frames takes " << consumed_time << " sec." << std::endl;
+
+	//display the statistics of pipeline
+	PipelineStatistics statistics = pipeline->getStatistics();
+	cout << "Completed frames: " << statistics.completed_frames << ", throughput: " << statistics.throughput
+		<< " frames per sec, latency mean: " << statistics.latency_mean << " sec, max: " << statistics.latency_max << " sec." << std::endl;
+	for (int i = 0; i < (int)statistics.stages.size(); i++)
+	{
+		PipelineStageStatistics& stage = statistics.stages[i];
+		cout << "Stage " << stage.name << " (" << stage.threads << " threads): " << stage.frames << " frames, busy "
+			<< stage.busy_time << " sec, mean " << stage.mean_time << " sec, max " << stage.max_time << " sec"
+			<< (i == statistics.bottleneck ? ", bottleneck" : "") << std::endl;
+	}
+
+	//save the computation time and the statistics of stages
+	file_path = image_folder + frame_names[0] + "_reconstruction_pipeline_time.csv";
+	csv_out.open(file_path);
+	if (csv_out.is_open())
+	{
+		csv_out << "POI number" << delimiter << "Frames" << delimiter << "Initialization" << delimiter << "Processing" << delimiter << "Throughput" << endl;
+		csv_out << queue_length << delimiter << frame_count << delimiter << computation_time[0] << delimiter << computation_time[1] << delimiter << statistics.throughput << endl;
+		csv_out << "Stage" << delimiter << "Threads" << delimiter << "Busy time" << delimiter << "Mean time" << delimiter << "Max time" << endl;
+		for (auto& stage : statistics.stages)
+		{
+			csv_out << stage.name << delimiter << stage.threads << delimiter << stage.busy_time << delimiter << stage.mean_time << delimiter << stage.max_time << endl;
+		}
+	}
+	csv_out.close();
+
+	//destroy the instances
+	delete pipeline;
+	delete epipolar_search;
+	delete icgn1;
+	delete stereo_reconstruction;
+	for (int i = 0; i < slot_number; i++)
+	{
+		delete view1_img[i];
+		delete view2_img[i];
+	}
+
+	cout << "Press any key to exit..." << std::endl;
+	cin.get();
+
+	return 0;
+}
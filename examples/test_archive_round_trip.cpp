@@ -0,0 +1,179 @@
+/*
+ This example demonstrates how to use OpenCorr to archive the results of a
+ sequence of frames with ArchiveWriter, and read them back with ArchiveReader.
+ Synthetic sequences of POI2D, POI2DS and POI3D are written, including frames
+ without POIs in the middle and at the end of sequence, and the frames read
+ back are checked bit by bit against the original ones.
+*/
+
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "opencorr.h"
+
+using namespace opencorr;
+using namespace std;
+
+//set all the archived fields of a frame. The fields drift slowly from frame to frame with noise of the order
+//of 0.01, and a few special values (NaN, infinity and negative zero) are mixed in
+template <typename T>
+void createFrame(vector<T>& poi_queue, int poi_number, int frame, T empty_poi, mt19937& generator)
+{
+	vector<string> field_names;
+	vector<size_t> field_offsets;
+	getColumnarFields(empty_poi, field_names, field_offsets);
+
+	normal_distribution<float> noise(0.f, 0.01f);
+	poi_queue.assign(poi_number, empty_poi);
+	for (int i = 0; i < poi_number; i++)
+	{
+		char* poi_data = (char*)&poi_queue[i];
+		for (int f = 0; f < (int)field_names.size(); f++)
+		{
+			float value = (float)(i % 97) + 0.5f * f + 0.1f * frame + noise(generator);
+			if (i % 1013 == 5)
+			{
+				value = numeric_limits<float>::quiet_NaN();
+			}
+			else if (i % 1013 == 6)
+			{
+				value = f % 2 == 0 ? numeric_limits<float>::infinity() : -0.f;
+			}
+			memcpy(poi_data + field_offsets[f], &value, sizeof(float));
+		}
+	}
+}
+
+//compare the archived fields of two frames bit by bit, return the number of mismatched values
+template <typename T>
+long long compareFrame(vector<T>& poi_queue, vector<T>& read_queue, T empty_poi)
+{
+	vector<string> field_names;
+	vector<size_t> field_offsets;
+	getColumnarFields(empty_poi, field_names, field_offsets);
+
+	if (poi_queue.size() != read_queue.size())
+	{
+		return (long long)max(poi_queue.size(), read_queue.size()) * field_names.size();
+	}
+
+	long long mismatch = 0;
+	for (size_t i = 0; i < poi_queue.size(); i++)
+	{
+		const char* poi_data = (const char*)&poi_queue[i];
+		const char* read_data = (const char*)&read_queue[i];
+		for (size_t f = 0; f < field_names.size(); f++)
+		{
+			if (memcmp(poi_data + field_offsets[f], read_data + field_offsets[f], sizeof(float)) != 0)
+			{
+				mismatch++;
+			}
+		}
+	}
+	return mismatch;
+}
+
+//write a sequence into an archive, then read it back in order and in reverse order, return the number of
+//mismatched values
+template <typename T>
+long long testRoundTrip(string file_path, string type_name, int poi_number, int dimension[3], T empty_poi)
+{
+	//the number of POIs in each frame, frames 2, 8 and 9 have no POIs, and frames 5 and 6 have a different number
+	//of POIs, which starts a new keyframe interval
+	int frame_sizes[10] = { poi_number, poi_number, 0, poi_number, poi_number, poi_number / 2 + 7, poi_number / 2 + 7, poi_number, 0, 0 };
+	int frame_count = 10;
+
+	mt19937 generator(2024);
+	vector<vector<T>> sequence(frame_count);
+	for (int t = 0; t < frame_count; t++)
+	{
+		createFrame(sequence[t], frame_sizes[t], t, empty_poi, generator);
+	}
+
+	//write the sequence, small blocks and a short keyframe interval are used to exercise both of the predictions
+	ArchiveWriter writer;
+	writer.setPath(file_path);
+	writer.setBlockSize(1000);
+	writer.setKeyframeInterval(4);
+	writer.setDimension(dimension[0], dimension[1], dimension[2]);
+	writer.open();
+	for (int t = 0; t < frame_count; t++)
+	{
+		writer.append(sequence[t]);
+	}
+	writer.close();
+
+	//read the frames back, in order and then in reverse order for random access
+	ArchiveReader reader;
+	reader.open(file_path);
+
+	long long mismatch = 0;
+	if (reader.getFrameNumber() != frame_count)
+	{
+		cout << type_name << ": " << reader.getFrameNumber() << " frames read instead of " << frame_count << std::endl;
+		mismatch++;
+	}
+
+	vector<T> read_queue;
+	for (int t = 0; t < frame_count && t < reader.getFrameNumber(); t++)
+	{
+		reader.readFrame(t, read_queue);
+		mismatch += compareFrame(sequence[t], read_queue, empty_poi);
+	}
+	for (int t = min(frame_count, reader.getFrameNumber()) - 1; t >= 0; t--)
+	{
+		reader.readFrame(t, read_queue);
+		mismatch += compareFrame(sequence[t], read_queue, empty_poi);
+	}
+	reader.close();
+
+	cout << type_name << ": " << frame_count << " frames, compression ratio " << writer.getCompressionRatio()
+		<< ", " << mismatch << " mismatched values." << std::endl;
+
+	return mismatch;
+}
+
+int main()
+{
+	//set the path of archives
+	string file_path = "d:/dic_tests/archive/round_trip"; //replace it with the path on your computer
+
+	//set OpenMP parameters
+	int cpu_thread_number = omp_get_num_procs() - 1;
+	cpu_thread_number = cpu_thread_number < 1 ? 1 : cpu_thread_number;
+	omp_set_num_threads(cpu_thread_number);
+
+	//initialize papameters for timing
+	double timer_tic, timer_toc, consumed_time;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	long long mismatch = 0;
+	try
+	{
+		int dimension_2d[3] = { 500, 400, 1 };
+		int dimension_3d[3] = { 100, 100, 100 };
+		mismatch += testRoundTrip(file_path + "_poi2d.octc", "POI2D", 5000, dimension_2d, POI2D(0, 0));
+		mismatch += testRoundTrip(file_path + "_poi2ds.octc", "POI2DS", 5000, dimension_2d, POI2DS(0, 0));
+		mismatch += testRoundTrip(file_path + "_poi3d.octc", "POI3D", 4000, dimension_3d, POI3D(0, 0, 0));
+	}
+	catch (string& error)
+	{
+		cout << "Error: " << error << std::endl;
+		return 1;
+	}
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+
+	//display the result on screen
+	cout << "Round trips take " << consumed_time << " sec, " << (mismatch == 0 ? "all frames are bit-exact." : "mismatch found!") << std::endl;
+
+	cout << "Press any key to exit..." << std::endl;
+	cin.get();
+
+	return mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/*
+ This example demonstrates how to use OpenCorr to realize domain-decomposed
+ DVC across processes. The volume is divided into blocks, which are processed
+ by the FFT-CC algorithm and the ICGN algorithm (with the 1st order shape
+ function) in a coordinator and two worker processes. The results are compared
+ with those obtained in a single process on the whole volume. PipeTransport
+ forks the workers on the local machine, which is not available on Windows.
+*/
+
+#include <cfloat>
+#include <fstream>
+
+#include "opencorr.h"
+
+using namespace opencorr;
+using namespace std;
+
+int main()
+{
+	//fork the workers before any OpenMP region, each process continues from here with its own rank
+	PipeTransport transport;
+	int worker_number = 2;
+	try
+	{
+		transport.spawn(worker_number);
+	}
+	catch (string& error)
+	{
+		cout << "Error: " << error << std::endl;
+		return 1;
+	}
+
+	//set files to process
+	string ref_image_path = "d:/dic_tests/dvc/al_foam4_0.bin"; //replace it with the path on your computer
+	string tar_image_path = "d:/dic_tests/dvc/al_foam4_1.bin"; //replace it with the path on your computer
+
+	//set OpenMP parameters, the CPU threads are shared by the coordinator and the workers
+	int cpu_thread_number = (omp_get_num_procs() - 1) / (worker_number + 1);
+	cpu_thread_number = cpu_thread_number < 1 ? 1 : cpu_thread_number;
+	omp_set_num_threads(cpu_thread_number);
+
+	//set DVC parameters
+	int subset_radius_x = 30;
+	int subset_radius_y = 30;
+	int subset_radius_z = 30;
+	int max_iteration = 20;
+	float max_deformation_norm = 0.001f;
+
+	//create the instance of distributed DVC in every process
+	DistributedDVC* distributed_dvc = new DistributedDVC(subset_radius_x, subset_radius_y, subset_radius_z, max_deformation_norm, max_iteration, cpu_thread_number);
+
+	//the workers process the blocks sent by the coordinator until they are released
+	if (transport.getRank() != 0)
+	{
+		distributed_dvc->serve(transport);
+		delete distributed_dvc;
+		return 0;
+	}
+
+	//initialize papameters for timing
+	double timer_tic, timer_toc, consumed_time;
+	vector<double> computation_time;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//create instances to read and write csv files
+	string file_path;
+	string delimiter = ",";
+	ofstream csv_out; //instance for output calculation time
+	IO3D in_out; //instance for input and output DIC data
+	in_out.setDelimiter(delimiter);
+	int dimension[3];
+	Image3D::getBinDimension(ref_image_path, dimension[0], dimension[1], dimension[2]);
+	in_out.setDimX(dimension[0]);
+	in_out.setDimY(dimension[1]);
+	in_out.setDimZ(dimension[2]);
+
+	//set POIs, the grid crosses the faces of blocks (x = 50, y = 50 and z = 353 for a grid of 2 x 2 x 2 blocks),
+	//thus many POIs lie within the halo of neighboring blocks
+	Point3D upper_left_point(35, 35, 60);
+	vector<POI3D> poi_queue;
+	int poi_number_x = 7;
+	int poi_number_y = 7;
+	int poi_number_z = 30;
+	int grid_space_xy = 5;
+	int grid_space_z = 20;
+
+	//store POIs in a queue
+	for (int i = 0; i < poi_number_z; i++)
+	{
+		for (int j = 0; j < poi_number_y; j++)
+		{
+			for (int k = 0; k < poi_number_x; k++)
+			{
+				Point3D offset(k * grid_space_xy, j * grid_space_xy, i * grid_space_z);
+				Point3D current_point = upper_left_point + offset;
+				POI3D current_poi(current_point);
+				poi_queue.push_back(current_poi);
+			}
+		}
+	}
+	int queue_length = (int)poi_queue.size();
+	vector<POI3D> single_poi_queue = poi_queue;
+
+	//divide the volume into 2 x 2 x 2 blocks, the reseeding of POIs from their neighbors is disabled to compare
+	//the results with the single process
+	int block_number[3] = { 2, 2, 2 };
+	distributed_dvc->setBlocks(block_number[0], block_number[1], block_number[2]);
+	distributed_dvc->setSeedExchange(0.8f, 0);
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //0
+
+	//display the time of initialization on screen
+	cout << "Initialization with " << queue_length << " POIs takes " << consumed_time << " sec, " << worker_number + 1 << " processes with " << cpu_thread_number << " CPU threads each launched." << std::endl;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//distributed DVC, the coordinator loads only the regions of its own blocks
+	try
+	{
+		distributed_dvc->compute(transport, ref_image_path, tar_image_path, poi_queue);
+	}
+	catch (string& error)
+	{
+		cout << "Error: " << error << std::endl;
+	}
+
+	//release the workers and wait for their exit
+	distributed_dvc->stop(transport);
+	transport.close();
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //1
+
+	//display the time of processing and the report on the screen
+	DistributedReport report = distributed_dvc->getReport();
+	cout << "Distributed DVC with " << report.block_number << " blocks takes " << consumed_time << " sec, loading "
+		<< (double)report.loaded_voxels / report.volume_voxels << " times the voxels of a volume." << std::endl;
+
+	//get the time of start
+	timer_tic = omp_get_wtime();
+
+	//DVC in a single process on the whole volume, with the same parameters
+	omp_set_num_threads(cpu_thread_number * (worker_number + 1));
+	Image3D ref_img(ref_image_path);
+	Image3D tar_img(tar_image_path);
+
+	FFTCC3D* fftcc = new FFTCC3D(subset_radius_x, subset_radius_y, subset_radius_z, cpu_thread_number * (worker_number + 1));
+	fftcc->setImages(ref_img, tar_img);
+	fftcc->compute(single_poi_queue);
+
+	ICGN3D1* icgn1 = new ICGN3D1(subset_radius_x, subset_radius_y, subset_radius_z, max_deformation_norm, max_iteration, cpu_thread_number * (worker_number + 1));
+	icgn1->setImages(ref_img, tar_img);
+	icgn1->prepare();
+	icgn1->compute(single_poi_queue);
+
+	//get the time of end
+	timer_toc = omp_get_wtime();
+	consumed_time = timer_toc - timer_tic;
+	computation_time.push_back(consumed_time); //2
+
+	//display the time of processing on screen
+	cout << "Single process DVC takes " << consumed_time << " sec." << std::endl;
+
+	//compare the results, the POIs within HALO_BORDER of a face between blocks are counted separately, as their
+	//subsets and the B-spline coefficients around them rely most on the halo loaded from the neighboring blocks
+	int near_face_number = 0;
+	int mismatched_number = 0;
+	float max_difference_near_face = 0.f;
+	float max_difference_inner = 0.f;
+	for (int i = 0; i < queue_length; i++)
+	{
+		POI3D& distributed_poi = poi_queue[i];
+		POI3D& single_poi = single_poi_queue[i];
+
+		float location[3] = { distributed_poi.x, distributed_poi.y, distributed_poi.z };
+		float face_distance = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int face = 1; face < block_number[axis]; face++)
+			{
+				float face_location = (float)dimension[axis] * face / block_number[axis];
+				face_distance = min(face_distance, fabs(location[axis] - face_location));
+			}
+		}
+		bool near_face = face_distance < DistributedDVC::HALO_BORDER;
+		near_face_number += near_face ? 1 : 0;
+
+		//POIs failed in one run but not the other
+		if ((distributed_poi.result.zncc < 0) != (single_poi.result.zncc < 0))
+		{
+			mismatched_number++;
+			continue;
+		}
+
+		float difference = max(fabs(distributed_poi.deformation.u - single_poi.deformation.u),
+			max(fabs(distributed_poi.deformation.v - single_poi.deformation.v), fabs(distributed_poi.deformation.w - single_poi.deformation.w)));
+		if (near_face)
+		{
+			max_difference_near_face = max(max_difference_near_face, difference);
+		}
+		else
+		{
+			max_difference_inner = max(max_difference_inner, difference);
+		}
+	}
+
+	//display the comparison on screen
+	cout << "Maximum difference of displacement between distributed and single process DVC: " << max_difference_near_face
+		<< " voxel for " << near_face_number << " POIs within " << DistributedDVC::HALO_BORDER << " voxels of block faces, "
+		<< max_difference_inner << " voxel for the others, " << mismatched_number << " POIs failed in only one of them." << std::endl;
+
+	//save the calculated results
+	file_path = tar_image_path.substr(0, tar_image_path.find_last_of(".")) + "_distributed_r30.csv";
+	in_out.setPath(file_path);
+	in_out.saveTable3D(poi_queue);
+
+	//save the computation time
+	file_path = tar_image_path.substr(0, tar_image_path.find_last_of(".")) + "_distributed_r30_time.csv";
+	csv_out.open(file_path);
+	if (csv_out.is_open())
+	{
+		csv_out << "POI number" << delimiter << "Initialization" << delimiter << "Distributed" << delimiter << "Single process" << delimiter << "Max difference near faces" << delimiter << "Max difference inner" << endl;
+		csv_out << queue_length << delimiter << computation_time[0] << delimiter << computation_time[1] << delimiter << computation_time[2] << delimiter << max_difference_near_face << delimiter << max_difference_inner << endl;
+	}
+	csv_out.close();
+
+	//destroy the instances
+	delete distributed_dvc;
+	delete fftcc;
+	delete icgn1;
+
+	cout << "Press any key to exit..." << std::endl;
+	cin.get();
+
+	return 0;
+}
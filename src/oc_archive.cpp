@@ -0,0 +1,730 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <omp.h>
+
+#include "oc_archive.h"
+#include "oc_io.h"
+
+namespace opencorr
+{
+	const uint32_t ARCHIVE_VERSION = 2;
+	const int ARCHIVE_GROUP = 128; //number of values sharing a bit width
+
+	//prediction of a field in chunk
+	enum ArchivePrediction
+	{
+		PREDICT_BLOCK = 0, //XOR with the previous POI in block
+		PREDICT_FRAME = 1 //XOR with the same POI in previous frame
+	};
+
+	static inline int bitWidth(uint32_t value)
+	{
+		int width = 0;
+		while (value != 0)
+		{
+			value >>= 1;
+			width++;
+		}
+		return width;
+	}
+
+	//number of trailing zero bits shared by a group, i.e. the trailing zeros of OR of the group
+	static inline int bitShift(uint32_t bits)
+	{
+		int shift = 0;
+		while (bits != 0 && (bits & 1u) == 0)
+		{
+			bits >>= 1;
+			shift++;
+		}
+		return shift;
+	}
+
+	static inline uint32_t predictResidual(const uint32_t* values, const uint32_t* reference, int i)
+	{
+		return values[i] ^ (reference != nullptr ? reference[i] : (i > 0 ? values[i - 1] : 0));
+	}
+
+	//size of a field packed with the given prediction, reference is nullptr for the prediction within block
+	static size_t packedSize(const uint32_t* values, const uint32_t* reference, int value_number)
+	{
+		size_t packed_size = 0;
+		for (int group_begin = 0; group_begin < value_number; group_begin += ARCHIVE_GROUP)
+		{
+			int group_end = std::min(group_begin + ARCHIVE_GROUP, value_number);
+			uint32_t bits = 0;
+			for (int i = group_begin; i < group_end; i++)
+			{
+				bits |= predictResidual(values, reference, i);
+			}
+			packed_size += 2 + ((size_t)bitWidth(bits >> bitShift(bits)) * (group_end - group_begin) + 7) / 8;
+		}
+		return packed_size;
+	}
+
+	//pack the residuals of prediction. The shared trailing zeros of each group are removed, which happens to
+	//quantized values like the iteration steps, the shift and the bit width are stored in two bytes before the group
+	static void packField(const uint32_t* values, const uint32_t* reference, int value_number, std::vector<char>& output)
+	{
+		output.resize(packedSize(values, reference, value_number));
+		unsigned char* p = (unsigned char*)output.data();
+
+		uint32_t residual[ARCHIVE_GROUP];
+		for (int group_begin = 0; group_begin < value_number; group_begin += ARCHIVE_GROUP)
+		{
+			int group_length = std::min(ARCHIVE_GROUP, value_number - group_begin);
+			uint32_t bits = 0;
+			for (int i = 0; i < group_length; i++)
+			{
+				residual[i] = predictResidual(values, reference, group_begin + i);
+				bits |= residual[i];
+			}
+
+			int shift = bitShift(bits);
+			int width = bitWidth(bits >> shift);
+			*p++ = (unsigned char)shift;
+			*p++ = (unsigned char)width;
+
+			uint64_t buffer = 0;
+			int buffer_bits = 0;
+			for (int i = 0; i < group_length && width > 0; i++)
+			{
+				buffer |= (uint64_t)(residual[i] >> shift) << buffer_bits;
+				buffer_bits += width;
+				while (buffer_bits >= 8)
+				{
+					*p++ = (unsigned char)buffer;
+					buffer >>= 8;
+					buffer_bits -= 8;
+				}
+			}
+			if (buffer_bits > 0)
+			{
+				*p++ = (unsigned char)buffer;
+			}
+		}
+	}
+
+	//unpack a field, return false if the data is corrupted
+	static bool unpackField(const unsigned char* input, size_t input_size, const uint32_t* reference, int value_number,
+		uint32_t* values)
+	{
+		const unsigned char* p = input;
+		const unsigned char* end = input + input_size;
+
+		for (int group_begin = 0; group_begin < value_number; group_begin += ARCHIVE_GROUP)
+		{
+			int group_length = std::min(ARCHIVE_GROUP, value_number - group_begin);
+			if (p + 2 > end)
+			{
+				return false;
+			}
+			int shift = *p++;
+			int width = *p++;
+			size_t group_bytes = ((size_t)width * group_length + 7) / 8;
+			if (shift > 31 || shift + width > 32 || p + group_bytes > end)
+			{
+				return false;
+			}
+
+			uint64_t buffer = 0;
+			int buffer_bits = 0;
+			uint32_t mask = width == 32 ? 0xFFFFFFFFu : ((1u << width) - 1);
+			for (int i = 0; i < group_length; i++)
+			{
+				while (buffer_bits < width)
+				{
+					buffer |= (uint64_t)(*p++) << buffer_bits;
+					buffer_bits += 8;
+				}
+				uint32_t residual = ((uint32_t)buffer & mask) << shift;
+				buffer >>= width;
+				buffer_bits -= width;
+
+				int index = group_begin + i;
+				values[index] = residual ^ (reference != nullptr ? reference[index] : (index > 0 ? values[index - 1] : 0));
+			}
+		}
+
+		return p == end;
+	}
+
+
+
+	ArchiveWriter::ArchiveWriter()
+		: block_size(65536), keyframe_interval(8), file_size(0), raw_size(0), poi_type(0), frame_number(0),
+		previous_poi_number(0)
+	{
+		dimension[0] = 0;
+		dimension[1] = 0;
+		dimension[2] = 0;
+	}
+
+	ArchiveWriter::~ArchiveWriter()
+	{
+		close();
+	}
+
+	void ArchiveWriter::setPath(std::string file_path)
+	{
+		this->file_path = file_path;
+	}
+
+	void ArchiveWriter::setBlockSize(int block_size)
+	{
+		this->block_size = std::max(block_size, ARCHIVE_GROUP);
+	}
+
+	void ArchiveWriter::setKeyframeInterval(int keyframe_interval)
+	{
+		this->keyframe_interval = std::max(keyframe_interval, 1);
+	}
+
+	void ArchiveWriter::setDimension(int dim_x, int dim_y, int dim_z)
+	{
+		dimension[0] = dim_x;
+		dimension[1] = dim_y;
+		dimension[2] = dim_z;
+	}
+
+	void ArchiveWriter::open()
+	{
+		close();
+
+		archive_file = std::fopen(file_path.c_str(), "wb");
+		if (archive_file == nullptr)
+		{
+			throw std::string("Failed to open file " + file_path);
+		}
+
+		file_size = 0;
+		raw_size = 0;
+		poi_type = 0;
+		frame_number = 0;
+		previous_poi_number = 0;
+		field_names.clear();
+		field_offsets.clear();
+		chunk_index.clear();
+	}
+
+	void ArchiveWriter::close()
+	{
+		if (archive_file == nullptr)
+		{
+			return;
+		}
+
+		//an archive without frames only has the footer
+		ArchiveFooter footer;
+		footer.index_offset = file_size;
+		footer.chunk_number = (uint32_t)chunk_index.size();
+		footer.frame_number = (uint32_t)frame_number;
+		footer.reserved = 0;
+		std::memcpy(footer.magic, "OCTI", 4);
+
+		std::fwrite(chunk_index.data(), sizeof(ArchiveChunk), chunk_index.size(), archive_file);
+		std::fwrite(&footer, sizeof(footer), 1, archive_file);
+		file_size += sizeof(ArchiveChunk) * chunk_index.size() + sizeof(footer);
+
+		bool failed = std::ferror(archive_file) != 0;
+		std::fclose(archive_file);
+		archive_file = nullptr;
+
+		if (failed)
+		{
+			std::cerr << "failed to write file " << file_path << std::endl;
+		}
+	}
+
+	template <typename T>
+	void ArchiveWriter::appendFrame(std::vector<T>& poi_queue, int poi_type, T empty_poi)
+	{
+		if (archive_file == nullptr)
+		{
+			throw std::string("ArchiveWriter is not opened: " + file_path);
+		}
+
+		//the header is written with the first frame
+		if (this->poi_type == 0)
+		{
+			getColumnarFields(empty_poi, field_names, field_offsets);
+
+			ArchiveHeader header;
+			std::memset(&header, 0, sizeof(header));
+			std::memcpy(header.magic, "OCTC", 4);
+			header.version = ARCHIVE_VERSION;
+			header.poi_type = (uint32_t)poi_type;
+			header.field_number = (uint32_t)field_names.size();
+			header.block_size = (uint32_t)block_size;
+			header.keyframe_interval = (uint32_t)keyframe_interval;
+			for (int i = 0; i < 3; i++)
+			{
+				header.dimension[i] = dimension[i];
+			}
+
+			std::vector<char> names(24 * field_names.size(), 0);
+			for (int i = 0; i < (int)field_names.size(); i++)
+			{
+				std::strncpy(names.data() + 24 * i, field_names[i].c_str(), 23);
+			}
+
+			std::fwrite(&header, sizeof(header), 1, archive_file);
+			std::fwrite(names.data(), 1, names.size(), archive_file);
+			file_size = sizeof(header) + names.size();
+			this->poi_type = poi_type;
+		}
+		else if (this->poi_type != poi_type)
+		{
+			throw std::string("Type of POI differs from the previous frames in archive: " + file_path);
+		}
+
+		int field_number = (int)field_names.size();
+		size_t poi_number = poi_queue.size();
+		int block_number = (int)((poi_number + block_size - 1) / block_size);
+
+		//gather the fields into columns
+		columns.resize(poi_number * field_number);
+		long long queue_length = (long long)poi_number;
+		for (int f = 0; f < field_number; f++)
+		{
+			float* column = columns.data() + poi_number * f;
+			size_t field_offset = field_offsets[f];
+#pragma omp parallel for
+			for (long long i = 0; i < queue_length; i++)
+			{
+				column[i] = *(const float*)((const char*)&poi_queue[i] + field_offset);
+			}
+		}
+
+		//compress the fields of blocks in parallel, the previous frame is used if it has the same POIs
+		bool keyframe = (frame_number % keyframe_interval == 0) || (previous_poi_number != poi_number);
+		int task_number = block_number * field_number;
+		stream.resize(std::max((int)stream.size(), task_number));
+		std::vector<unsigned char> prediction(task_number);
+
+#pragma omp parallel for schedule(dynamic)
+		for (int task = 0; task < task_number; task++)
+		{
+			int b = task / field_number;
+			int f = task % field_number;
+			size_t block_begin = (size_t)block_size * b;
+			int value_number = (int)std::min((size_t)block_size, poi_number - block_begin);
+
+			const uint32_t* values = (const uint32_t*)(columns.data() + poi_number * f + block_begin);
+			const uint32_t* reference = nullptr;
+			if (!keyframe)
+			{
+				const uint32_t* previous = (const uint32_t*)(previous_columns.data() + poi_number * f + block_begin);
+				if (packedSize(values, previous, value_number) < packedSize(values, nullptr, value_number))
+				{
+					reference = previous;
+				}
+			}
+
+			prediction[task] = reference != nullptr ? PREDICT_FRAME : PREDICT_BLOCK;
+			packField(values, reference, value_number, stream[task]);
+		}
+
+		//each chunk begins with the prediction and size of its fields
+		for (int b = 0; b < block_number; b++)
+		{
+			size_t block_begin = (size_t)block_size * b;
+			ArchiveChunk chunk;
+			chunk.frame = (uint32_t)frame_number;
+			chunk.block = (uint32_t)b;
+			chunk.poi_number = (uint32_t)std::min((size_t)block_size, poi_number - block_begin);
+			chunk.offset = file_size;
+
+			std::vector<uint32_t> stream_size(field_number);
+			size_t chunk_size = (sizeof(uint32_t) + 1) * field_number;
+			for (int f = 0; f < field_number; f++)
+			{
+				stream_size[f] = (uint32_t)stream[b * field_number + f].size();
+				chunk_size += stream_size[f];
+			}
+			chunk.size = (uint32_t)chunk_size;
+
+			std::fwrite(stream_size.data(), sizeof(uint32_t), field_number, archive_file);
+			std::fwrite(prediction.data() + b * field_number, 1, field_number, archive_file);
+			for (int f = 0; f < field_number; f++)
+			{
+				std::fwrite(stream[b * field_number + f].data(), 1, stream_size[f], archive_file);
+			}
+
+			file_size += chunk_size;
+			chunk_index.push_back(chunk);
+		}
+
+		if (std::ferror(archive_file) != 0)
+		{
+			throw std::string("Failed to write file " + file_path);
+		}
+
+		raw_size += sizeof(float) * columns.size();
+		columns.swap(previous_columns);
+		previous_poi_number = poi_number;
+		frame_number++;
+	}
+
+	void ArchiveWriter::append(std::vector<POI2D>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI2D, POI2D(0, 0));
+	}
+
+	void ArchiveWriter::append(std::vector<POI2DS>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI2DS, POI2DS(0, 0));
+	}
+
+	void ArchiveWriter::append(std::vector<POI3D>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI3D, POI3D(0, 0, 0));
+	}
+
+	int ArchiveWriter::getFrameNumber() const
+	{
+		return frame_number;
+	}
+
+	double ArchiveWriter::getCompressionRatio() const
+	{
+		return file_size > 0 ? (double)raw_size / file_size : 0.;
+	}
+
+
+
+	ArchiveReader::ArchiveReader() : header(nullptr), cached_frame(-1) {}
+
+	ArchiveReader::~ArchiveReader()
+	{
+		close();
+	}
+
+	void ArchiveReader::open(std::string file_path)
+	{
+		close();
+
+		if (!mapped_file.open(file_path))
+		{
+			throw std::string("Failed to map file " + file_path);
+		}
+
+		const char* data = mapped_file.data();
+		size_t data_size = mapped_file.size();
+		if (data_size < sizeof(ArchiveFooter))
+		{
+			close();
+			throw std::string("Not an archive file: " + file_path);
+		}
+
+		//the footer and the table of chunks may be unaligned, thus they are copied
+		ArchiveFooter footer;
+		std::memcpy(&footer, data + data_size - sizeof(ArchiveFooter), sizeof(footer));
+		if (std::memcmp(footer.magic, "OCTI", 4) != 0 || footer.index_offset > data_size - sizeof(ArchiveFooter)
+			|| data_size - sizeof(ArchiveFooter) - footer.index_offset != (uint64_t)sizeof(ArchiveChunk) * footer.chunk_number)
+		{
+			close();
+			throw std::string("Incomplete archive file: " + file_path);
+		}
+
+		//the header is written with the first frame, even if the frame has no POIs
+		if (footer.frame_number == 0)
+		{
+			if (footer.chunk_number != 0)
+			{
+				close();
+				throw std::string("Corrupted chunk table in archive file: " + file_path);
+			}
+			return;
+		}
+
+		if (footer.index_offset < sizeof(ArchiveHeader))
+		{
+			close();
+			throw std::string("Incomplete archive file: " + file_path);
+		}
+
+		header = (const ArchiveHeader*)data;
+		if (std::memcmp(header->magic, "OCTC", 4) != 0 || header->version != ARCHIVE_VERSION)
+		{
+			close();
+			throw std::string("Unsupported archive file: " + file_path);
+		}
+
+		//the names of fields lie between the header and the first chunk
+		uint64_t data_begin = sizeof(ArchiveHeader) + (uint64_t)24 * header->field_number;
+		if (data_begin > footer.index_offset || header->block_size == 0 || header->keyframe_interval == 0)
+		{
+			close();
+			throw std::string("Corrupted header of archive file: " + file_path);
+		}
+
+		const char* names = data + sizeof(ArchiveHeader);
+		for (uint32_t i = 0; i < header->field_number; i++)
+		{
+			field_names.push_back(std::string(names + 24 * i, strnlen(names + 24 * i, 24)));
+		}
+
+		//frames without POIs have no chunk, their number is bounded by the size of file to reject absurd counts
+		if (footer.frame_number > data_size)
+		{
+			close();
+			throw std::string("Corrupted footer of archive file: " + file_path);
+		}
+		frame_chunks.resize(footer.frame_number);
+
+		//chunks are written in the order of frames and blocks, and only the last block of a frame may be partial
+		uint32_t last_frame = 0;
+		for (uint32_t i = 0; i < footer.chunk_number; i++)
+		{
+			ArchiveChunk chunk;
+			std::memcpy(&chunk, data + footer.index_offset + sizeof(ArchiveChunk) * i, sizeof(chunk));
+
+			bool valid = chunk.offset >= data_begin && chunk.offset <= footer.index_offset
+				&& chunk.size <= footer.index_offset - chunk.offset
+				&& (uint64_t)chunk.size >= (uint64_t)(sizeof(uint32_t) + 1) * header->field_number
+				&& chunk.poi_number > 0 && chunk.poi_number <= header->block_size
+				&& chunk.frame >= last_frame && chunk.frame < footer.frame_number;
+			if (valid)
+			{
+				std::vector<ArchiveChunk>& chunks = frame_chunks[chunk.frame];
+				valid = chunk.block == chunks.size() && (chunks.empty() || chunks.back().poi_number == header->block_size);
+			}
+			if (!valid)
+			{
+				close();
+				throw std::string("Corrupted chunk table in archive file: " + file_path);
+			}
+
+			frame_chunks[chunk.frame].push_back(chunk);
+			last_frame = chunk.frame;
+		}
+	}
+
+	void ArchiveReader::close()
+	{
+		mapped_file.close();
+		header = nullptr;
+		field_names.clear();
+		frame_chunks.clear();
+		cached_frame = -1;
+	}
+
+	int ArchiveReader::getType() const
+	{
+		return header != nullptr ? (int)header->poi_type : 0;
+	}
+
+	int ArchiveReader::getFrameNumber() const
+	{
+		return (int)frame_chunks.size();
+	}
+
+	size_t ArchiveReader::getPOINumber(int frame) const
+	{
+		size_t poi_number = 0;
+		if (frame >= 0 && frame < (int)frame_chunks.size())
+		{
+			for (int i = 0; i < (int)frame_chunks[frame].size(); i++)
+			{
+				poi_number += frame_chunks[frame][i].poi_number;
+			}
+		}
+		return poi_number;
+	}
+
+	int ArchiveReader::getFieldNumber() const
+	{
+		return (int)field_names.size();
+	}
+
+	std::string ArchiveReader::getFieldName(int field_index) const
+	{
+		return (field_index >= 0 && field_index < (int)field_names.size()) ? field_names[field_index] : std::string();
+	}
+
+	int ArchiveReader::getDimension(int axis) const
+	{
+		return (header != nullptr && axis >= 0 && axis < 4) ? header->dimension[axis] : 0;
+	}
+
+	void ArchiveReader::decodeFrame(int frame)
+	{
+		int field_number = (int)field_names.size();
+		int block_number = (int)frame_chunks[frame].size();
+		size_t poi_number = getPOINumber(frame);
+		size_t block_size = header->block_size;
+
+		cached_columns.resize(poi_number * field_number);
+		bool previous_valid = (previous_columns.size() == cached_columns.size());
+		int corrupted = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(||:corrupted)
+		for (int task = 0; task < block_number * field_number; task++)
+		{
+			int b = task / field_number;
+			int f = task % field_number;
+			const ArchiveChunk& chunk = frame_chunks[frame][b];
+			const unsigned char* chunk_data = (const unsigned char*)mapped_file.data() + chunk.offset;
+			const unsigned char* prediction = chunk_data + sizeof(uint32_t) * field_number;
+
+			//sizes of fields in chunk, which may be unaligned
+			uint32_t stream_size = 0;
+			size_t stream_offset = (sizeof(uint32_t) + 1) * field_number;
+			for (int i = 0; i <= f; i++)
+			{
+				std::memcpy(&stream_size, chunk_data + sizeof(uint32_t) * i, sizeof(uint32_t));
+				stream_offset += i < f ? stream_size : 0;
+			}
+
+			size_t block_begin = block_size * b;
+			uint32_t* values = (uint32_t*)(cached_columns.data() + poi_number * f + block_begin);
+			const uint32_t* reference = nullptr;
+			if (prediction[f] == PREDICT_FRAME)
+			{
+				if (!previous_valid)
+				{
+					corrupted = 1;
+					continue;
+				}
+				reference = (const uint32_t*)(previous_columns.data() + poi_number * f + block_begin);
+			}
+
+			if (stream_offset + stream_size > chunk.size
+				|| !unpackField(chunk_data + stream_offset, stream_size, reference, (int)chunk.poi_number, values))
+			{
+				corrupted = 1;
+			}
+		}
+
+		if (corrupted)
+		{
+			cached_frame = -1;
+			throw std::string("Corrupted chunk in archive at frame " + std::to_string(frame));
+		}
+		cached_frame = frame;
+	}
+
+	const std::vector<float>& ArchiveReader::readColumns(int frame)
+	{
+		if (frame < 0 || frame >= (int)frame_chunks.size())
+		{
+			throw std::string("Frame out of range in archive");
+		}
+		if (frame == cached_frame)
+		{
+			return cached_columns;
+		}
+
+		int keyframe = frame - frame % (int)header->keyframe_interval;
+		int start_frame = (cached_frame >= keyframe && cached_frame < frame) ? cached_frame + 1 : keyframe;
+		for (int i = start_frame; i <= frame; i++)
+		{
+			if (i > start_frame || cached_frame == i - 1)
+			{
+				cached_columns.swap(previous_columns);
+			}
+			else
+			{
+				previous_columns.clear();
+			}
+			decodeFrame(i);
+		}
+
+		return cached_columns;
+	}
+
+	void ArchiveReader::readColumn(int frame, std::string field_name, std::vector<float>& column)
+	{
+		const std::vector<float>& columns = readColumns(frame);
+		size_t poi_number = getPOINumber(frame);
+		for (int f = 0; f < (int)field_names.size(); f++)
+		{
+			if (field_names[f] == field_name)
+			{
+				column.assign(columns.begin() + poi_number * f, columns.begin() + poi_number * (f + 1));
+				return;
+			}
+		}
+		throw std::string("Field not found in archive: " + field_name);
+	}
+
+	//scatter the decoded columns into POIs, fields missing in archive are left as zero
+	template <typename T>
+	void scatterArchive(const std::vector<float>& columns, std::vector<std::string>& archive_fields, size_t poi_number,
+		T empty_poi, std::vector<T>& poi_queue)
+	{
+		std::vector<std::string> names;
+		std::vector<size_t> offsets;
+		getColumnarFields(empty_poi, names, offsets);
+
+		poi_queue.assign(poi_number, empty_poi);
+		long long queue_length = (long long)poi_number;
+		for (int f = 0; f < (int)names.size(); f++)
+		{
+			int archive_index = -1;
+			for (int i = 0; i < (int)archive_fields.size(); i++)
+			{
+				if (archive_fields[i] == names[f])
+				{
+					archive_index = i;
+				}
+			}
+			if (archive_index < 0)
+			{
+				continue;
+			}
+
+			const float* column = columns.data() + poi_number * archive_index;
+			size_t field_offset = offsets[f];
+#pragma omp parallel for
+			for (long long i = 0; i < queue_length; i++)
+			{
+				*(float*)((char*)&poi_queue[i] + field_offset) = column[i];
+			}
+		}
+	}
+
+	void ArchiveReader::readFrame(int frame, std::vector<POI2D>& poi_queue)
+	{
+		if (getType() != COLUMNAR_POI2D)
+		{
+			throw std::string("Type of POI in archive does not match");
+		}
+		scatterArchive(readColumns(frame), field_names, getPOINumber(frame), POI2D(0, 0), poi_queue);
+	}
+
+	void ArchiveReader::readFrame(int frame, std::vector<POI2DS>& poi_queue)
+	{
+		if (getType() != COLUMNAR_POI2DS)
+		{
+			throw std::string("Type of POI in archive does not match");
+		}
+		scatterArchive(readColumns(frame), field_names, getPOINumber(frame), POI2DS(0, 0), poi_queue);
+	}
+
+	void ArchiveReader::readFrame(int frame, std::vector<POI3D>& poi_queue)
+	{
+		if (getType() != COLUMNAR_POI3D)
+		{
+			throw std::string("Type of POI in archive does not match");
+		}
+		scatterArchive(readColumns(frame), field_names, getPOINumber(frame), POI3D(0, 0, 0), poi_queue);
+	}
+
+}//namespace opencorr
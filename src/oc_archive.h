@@ -0,0 +1,147 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "oc_columnar.h"
+#include "oc_poi.h"
+
+namespace opencorr
+{
+	//compressed container of results of a sequence of frames. The POIs of a frame are divided into blocks, and each
+	//chunk holds the fields of a block. A field in chunk is predicted by XOR with the same POI in previous frame or
+	//with the previous POI in block, the residuals are packed with the bit width of every 128 values. Every frame
+	//starting a keyframe interval uses the prediction within block only, for random access
+	struct ArchiveHeader
+	{
+		char magic[4]; //"OCTC"
+		uint32_t version;
+		uint32_t poi_type; //ColumnarType
+		uint32_t field_number;
+		uint32_t block_size; //number of POIs in a block
+		uint32_t keyframe_interval;
+		int32_t dimension[4]; //width and height of image in 2D, dim_x, dim_y and dim_z in 3D
+	};
+
+	struct ArchiveChunk
+	{
+		uint32_t frame;
+		uint32_t block;
+		uint32_t poi_number;
+		uint32_t size; //size of chunk in bytes
+		uint64_t offset; //offset of chunk from the beginning of file, in bytes
+	};
+
+	//the end of file, pointing to the table of chunks
+	struct ArchiveFooter
+	{
+		uint64_t index_offset;
+		uint32_t chunk_number;
+		uint32_t frame_number; //including the frames without POIs, which have no chunk
+		uint32_t reserved;
+		char magic[4]; //"OCTI"
+	};
+
+	class ArchiveWriter
+	{
+	private:
+		std::string file_path;
+		int block_size;
+		int keyframe_interval;
+		int dimension[3];
+
+		std::FILE* archive_file = nullptr;
+		uint64_t file_size;
+		uint64_t raw_size; //size of the appended fields without compression
+		int poi_type; //0 before the first frame
+		int frame_number;
+		std::vector<std::string> field_names;
+		std::vector<size_t> field_offsets;
+		std::vector<ArchiveChunk> chunk_index;
+
+		std::vector<float> columns, previous_columns; //fields of current and previous frames, one column per field
+		size_t previous_poi_number;
+		std::vector<std::vector<char>> stream; //compressed fields, one per field in each block
+
+		template <typename T>
+		void appendFrame(std::vector<T>& poi_queue, int poi_type, T empty_poi);
+
+	public:
+		ArchiveWriter();
+		~ArchiveWriter();
+
+		void setPath(std::string file_path);
+		void setBlockSize(int block_size); //default 65536
+		void setKeyframeInterval(int keyframe_interval); //default 8, 1 disables the prediction from previous frame
+		void setDimension(int dim_x, int dim_y, int dim_z);
+
+		void open(); //existing file is overwritten
+		void close(); //write the table of chunks
+
+		void append(std::vector<POI2D>& poi_queue);
+		void append(std::vector<POI2DS>& poi_queue);
+		void append(std::vector<POI3D>& poi_queue);
+
+		int getFrameNumber() const;
+		double getCompressionRatio() const; //size of fields without compression over size of file
+	};
+
+	class ArchiveReader
+	{
+	private:
+		MappedFile mapped_file;
+		const ArchiveHeader* header;
+		std::vector<std::string> field_names;
+		std::vector<std::vector<ArchiveChunk>> frame_chunks; //chunks of each frame, in the order of blocks
+
+		int cached_frame; //the last decoded frame, -1 if none
+		std::vector<float> cached_columns, previous_columns;
+
+		void decodeFrame(int frame); //decode a frame into cached_columns, using previous_columns as the previous frame
+
+	public:
+		ArchiveReader();
+		~ArchiveReader();
+
+		void open(std::string file_path);
+		void close();
+
+		int getType() const;
+		int getFrameNumber() const;
+		size_t getPOINumber(int frame) const;
+		int getFieldNumber() const;
+		std::string getFieldName(int field_index) const;
+		int getDimension(int axis) const;
+
+		//fields of a frame, one column after another. The frames following the last decoded one are decoded
+		//incrementally, others are decoded from the beginning of their keyframe intervals
+		const std::vector<float>& readColumns(int frame);
+		void readColumn(int frame, std::string field_name, std::vector<float>& column);
+
+		void readFrame(int frame, std::vector<POI2D>& poi_queue);
+		void readFrame(int frame, std::vector<POI2DS>& poi_queue);
+		void readFrame(int frame, std::vector<POI3D>& poi_queue);
+	};
+
+}//namespace opencorr
+
+#endif //_ARCHIVE_H_
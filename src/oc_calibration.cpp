@@ -12,6 +12,13 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
 #include "oc_calibration.h"
 
 namespace opencorr
@@ -20,6 +27,8 @@ namespace opencorr
 	{
 		convergence = 0.001f;
 		iteration = 40;
+		map_grid_step = 1;
+		map_tolerance = 0.01f;
 	}
 
 	Calibration::Calibration(CameraIntrinsics& intrinsics, CameraExtrinsics& extrinsics)
@@ -27,6 +36,8 @@ namespace opencorr
 		updateCalibration(intrinsics, extrinsics);
 		convergence = 0.001f;
 		iteration = 40;
+		map_grid_step = 1;
+		map_tolerance = 0.01f;
 	}
 
 	Calibration::~Calibration() {}
@@ -150,109 +161,501 @@ namespace opencorr
 		return distorted_coordinate;
 	}
 
-	void Calibration::prepare(int height, int width)
+	Point2D Calibration::solveImageCoordinate(Point2D& sensor_coordinate)
+	{
+		float deviation_y;
+		float deviation_x;
+		bool stop_iteration = false;
+		int i = 0;
+		Point2D initial_coordinate(sensor_to_image(sensor_coordinate));
+		Point2D image_coordinate = initial_coordinate;
+
+		while (i < iteration && stop_iteration == false)
+		{
+			i++;
+			Point2D distorted_coordinate(distort(image_coordinate));
+			Point2D estimated_coordinate(image_to_sensor(distorted_coordinate));
+			deviation_y = sensor_coordinate.y - estimated_coordinate.y;
+			deviation_x = sensor_coordinate.x - estimated_coordinate.x;
+			if (std::isinf(deviation_x) || std::isinf(deviation_y))
+			{
+				stop_iteration = true;
+				image_coordinate = initial_coordinate;
+			}
+			if (fabs(deviation_x) > convergence || fabs(deviation_y) > convergence)
+			{
+				deviation_y /= intrinsics.fy;
+				image_coordinate.y += deviation_y;
+				image_coordinate.x += (deviation_x - deviation_y * intrinsics.fs) / intrinsics.fx;
+			}
+			else
+			{
+				stop_iteration = true;
+			}
+		}
+
+		return image_coordinate;
+	}
+
+	void Calibration::solveGrid(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y)
 	{
-		//initialize the map of distorted coordinates in image coordinate system
-		map_x = Eigen::MatrixXf::Zero(height, width);
-		map_y = Eigen::MatrixXf::Zero(height, width);
+		//node (j, i) locates at ((i - 1) * grid_step, (j - 1) * grid_step), with one extra node beyond each boundary
+		int grid_rows = (height - 1) / grid_step + 4;
+		int grid_cols = (width - 1) / grid_step + 4;
+		grid_x.resize(grid_rows, grid_cols);
+		grid_y.resize(grid_rows, grid_cols);
 
-		//initialize the correction map
 #pragma omp parallel for
-		for (int r = 0; r < height; r++)
+		for (int j = 0; j < grid_rows; j++)
 		{
-			for (int c = 0; c < width; c++)
+			for (int i = 0; i < grid_cols; i++)
 			{
-				Point2D sensor_coordinate(c, r);
-				Point2D image_coordinate(sensor_to_image(sensor_coordinate));
-				map_x(r, c) = image_coordinate.x;
-				map_y(r, c) = image_coordinate.y;
+				Point2D sensor_coordinate((float)((i - 1) * grid_step), (float)((j - 1) * grid_step));
+				Point2D image_coordinate = solveImageCoordinate(sensor_coordinate);
+				grid_x(j, i) = image_coordinate.x;
+				grid_y(j, i) = image_coordinate.y;
+			}
+		}
+	}
+
+	//weights of Catmull-Rom cubic convolution
+	inline void cubicWeights(float t, float* weight)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		weight[0] = 0.5f * (-t3 + 2 * t2 - t);
+		weight[1] = 0.5f * (3 * t3 - 5 * t2 + 2);
+		weight[2] = 0.5f * (-3 * t3 + 4 * t2 + t);
+		weight[3] = 0.5f * (t3 - t2);
+	}
+
+	void Calibration::upsampleGrid(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y)
+	{
+		int grid_rows = (int)grid_x.rows();
+		map_x.resize(height, width);
+		map_y.resize(height, width);
+
+		//separable interpolation, along x at the rows of nodes first, then along y
+		Eigen::MatrixXf row_x(grid_rows, width);
+		Eigen::MatrixXf row_y(grid_rows, width);
+
+#pragma omp parallel for
+		for (int c = 0; c < width; c++)
+		{
+			int i = c / grid_step;
+			float weight_x[4];
+			cubicWeights((float)(c - i * grid_step) / grid_step, weight_x);
+
+			//nodes i, i + 1, i + 2, i + 3 cover the columns from (i - 1) * grid_step to (i + 2) * grid_step
+			for (int j = 0; j < grid_rows; j++)
+			{
+				row_x(j, c) = weight_x[0] * grid_x(j, i) + weight_x[1] * grid_x(j, i + 1)
+					+ weight_x[2] * grid_x(j, i + 2) + weight_x[3] * grid_x(j, i + 3);
+				row_y(j, c) = weight_x[0] * grid_y(j, i) + weight_x[1] * grid_y(j, i + 1)
+					+ weight_x[2] * grid_y(j, i + 2) + weight_x[3] * grid_y(j, i + 3);
 			}
 		}
 
 #pragma omp parallel for
-		for (int r = 0; r < height; r++)
+		for (int c = 0; c < width; c++)
+		{
+			for (int r = 0; r < height; r++)
+			{
+				int j = r / grid_step;
+				float weight_y[4];
+				cubicWeights((float)(r - j * grid_step) / grid_step, weight_y);
+
+				map_x(r, c) = weight_y[0] * row_x(j, c) + weight_y[1] * row_x(j + 1, c)
+					+ weight_y[2] * row_x(j + 2, c) + weight_y[3] * row_x(j + 3, c);
+				map_y(r, c) = weight_y[0] * row_y(j, c) + weight_y[1] * row_y(j + 1, c)
+					+ weight_y[2] * row_y(j + 2, c) + weight_y[3] * row_y(j + 3, c);
+			}
+		}
+	}
+
+	float Calibration::checkGrid(int height, int width, int grid_step)
+	{
+		//the centers of grid cells are the farthest from the nodes
+		int check_rows = (height - 1 - grid_step / 2) / grid_step + 1;
+		std::vector<float> row_error(check_rows, 0.f);
+#pragma omp parallel for
+		for (int j = 0; j < check_rows; j++)
+		{
+			int r = grid_step / 2 + j * grid_step;
+			for (int c = grid_step / 2; c < width; c += grid_step)
+			{
+				Point2D sensor_coordinate((float)c, (float)r);
+				Point2D image_coordinate = solveImageCoordinate(sensor_coordinate);
+				float error_x = (float)fabs(image_coordinate.x - map_x(r, c)) * intrinsics.fx;
+				float error_y = (float)fabs(image_coordinate.y - map_y(r, c)) * intrinsics.fy;
+				row_error[j] = std::max(row_error[j], std::max(error_x, error_y));
+			}
+		}
+
+		return *std::max_element(row_error.begin(), row_error.end());
+	}
+
+	void Calibration::prepare(int height, int width)
+	{
+		//skip the iterative solution if the maps have been cached
+		if (!map_cache_dir.empty() && loadMap(height, width))
+		{
+			return;
+		}
+
+		//solve the map on a coarse grid and upsample it, refine the grid until the error is within tolerance
+		int grid_step = std::max(map_grid_step, 1);
+		Eigen::MatrixXf grid_x, grid_y;
+		while (true)
 		{
-			for (int c = 0; c < width; c++)
+			solveGrid(height, width, grid_step, grid_x, grid_y);
+			upsampleGrid(height, width, grid_step, grid_x, grid_y);
+			if (grid_step == 1 || checkGrid(height, width, grid_step) <= map_tolerance)
 			{
-				float deviation_y;
-				float deviation_x;
-				bool stop_iteration = false;
-				int i = 0;
-				Point2D image_coordinate(map_x(r, c), map_y(r, c));
+				break;
+			}
+			grid_step /= 2;
+		}
+
+		if (!map_cache_dir.empty())
+		{
+			saveMap(height, width, grid_step, grid_x, grid_y);
+		}
+	}
+
+	//conversion between single precision and half precision floating numbers
+	inline uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
 
-				while (i < iteration && stop_iteration == false)
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if (exponent >= 31)
+		{
+			return sign | 0x7c00;
+		}
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return sign;
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			return (uint16_t)(sign | ((mantissa + (1u << (shift - 1))) >> shift));
+		}
+
+		return (uint16_t)(sign | ((exponent << 10) + ((mantissa + 0x1000) >> 13)));
+	}
+
+	inline float halfToFloat(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		int exponent = (value >> 10) & 0x1f;
+		uint32_t mantissa = value & 0x3ff;
+		uint32_t bits;
+
+		if (exponent == 0)
+		{
+			if (mantissa == 0)
+			{
+				bits = sign;
+			}
+			else
+			{
+				exponent = 1;
+				while (!(mantissa & 0x400))
 				{
-					i++;
-					Point2D distorted_coordinate(distort(image_coordinate));
-					Point2D sensor_coordinate(image_to_sensor(distorted_coordinate));
-					deviation_y = r - sensor_coordinate.y;
-					deviation_x = c - sensor_coordinate.x;
-					if (std::isinf(deviation_x) || std::isinf(deviation_y))
-					{
-						stop_iteration = true;
-						image_coordinate.y = map_y(r, c);
-						image_coordinate.x = map_x(r, c);
-					}
-					if (fabs(deviation_x) > convergence || fabs(deviation_y) > convergence)
-					{
-						deviation_y /= intrinsics.fy;
-						image_coordinate.y += deviation_y;
-						image_coordinate.x += (deviation_x - deviation_y * intrinsics.fs) / intrinsics.fx;
-					}
-					else
-					{
-						stop_iteration = true;
-					}
+					mantissa <<= 1;
+					exponent--;
 				}
-				map_y(r, c) = image_coordinate.y;
-				map_x(r, c) = image_coordinate.x;
+				mantissa &= 0x3ff;
+				bits = sign | ((uint32_t)(exponent + 112) << 23) | (mantissa << 13);
+			}
+		}
+		else if (exponent == 31)
+		{
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else
+		{
+			bits = sign | ((uint32_t)(exponent + 112) << 23) | (mantissa << 13);
+		}
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	uint64_t Calibration::mapHash(int height, int width) const
+	{
+		//FNV-1a hash of the parameters that determine the maps
+		uint64_t hash = 14695981039346656037ull;
+		auto append = [&hash](const void* data, size_t size)
+		{
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		append(intrinsics.cam_i, sizeof(intrinsics.cam_i));
+		append(&height, sizeof(height));
+		append(&width, sizeof(width));
+		append(&convergence, sizeof(convergence));
+		append(&iteration, sizeof(iteration));
+		append(&map_grid_step, sizeof(map_grid_step));
+		append(&map_tolerance, sizeof(map_tolerance));
+
+		return hash;
+	}
+
+	std::string Calibration::mapFile(int height, int width) const
+	{
+		std::stringstream file_name;
+		file_name << map_cache_dir << "/oc_undistortion_" << std::hex << std::setw(16) << std::setfill('0') << mapHash(height, width) << ".bin";
+		return file_name.str();
+	}
+
+	void Calibration::saveMap(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y)
+	{
+		//offsets from the identity in pixels
+		int grid_rows = (int)grid_x.rows();
+		int grid_cols = (int)grid_x.cols();
+		int node_number = grid_rows * grid_cols;
+		std::vector<float> offset(2 * (size_t)node_number);
+		for (int i = 0; i < grid_cols; i++)
+		{
+			for (int j = 0; j < grid_rows; j++)
+			{
+				Point2D sensor_coordinate((float)((i - 1) * grid_step), (float)((j - 1) * grid_step));
+				Point2D identity = sensor_to_image(sensor_coordinate);
+				int index = i * grid_rows + j;
+				offset[2 * index] = (grid_x(j, i) - identity.x) * intrinsics.fx;
+				offset[2 * index + 1] = (grid_y(j, i) - identity.y) * intrinsics.fy;
 			}
 		}
+
+		//half precision is taken if the rounding error is negligible compared with the tolerance
+		std::vector<uint16_t> half_offset(offset.size());
+		float max_rounding = 0.f;
+		for (size_t i = 0; i < offset.size(); i++)
+		{
+			half_offset[i] = floatToHalf(offset[i]);
+			max_rounding = std::max(max_rounding, (float)fabs(halfToFloat(half_offset[i]) - offset[i]));
+		}
+		int precision = max_rounding <= 0.1f * map_tolerance ? 2 : 4;
+
+		std::ofstream file_out(mapFile(height, width), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file_out.is_open())
+		{
+			std::cerr << "Fail to cache the undistortion map in: " << map_cache_dir << std::endl;
+			return;
+		}
+
+		uint64_t hash = mapHash(height, width);
+		int head[7] = { 0x4d55434f, 1, height, width, grid_step, grid_rows, grid_cols }; //"OCUM", version 1
+		file_out.write((char*)head, sizeof(head));
+		file_out.write((char*)&hash, sizeof(hash));
+		file_out.write((char*)&precision, sizeof(precision));
+		if (precision == 2)
+		{
+			file_out.write((char*)half_offset.data(), half_offset.size() * sizeof(uint16_t));
+		}
+		else
+		{
+			file_out.write((char*)offset.data(), offset.size() * sizeof(float));
+		}
+		file_out.close();
 	}
 
-	Point2D Calibration::undistort(Point2D& point)
+	bool Calibration::loadMap(int height, int width)
 	{
-		//deal with the points adjacent to boundary
-		if (point.x < 0)
+		std::ifstream file_in(mapFile(height, width), std::ios::in | std::ios::binary);
+		if (!file_in.is_open())
+		{
+			return false;
+		}
+
+		int head[7];
+		uint64_t hash;
+		int precision;
+		file_in.read((char*)head, sizeof(head));
+		file_in.read((char*)&hash, sizeof(hash));
+		file_in.read((char*)&precision, sizeof(precision));
+		if (!file_in || head[0] != 0x4d55434f || head[1] != 1 || head[2] != height || head[3] != width
+			|| hash != mapHash(height, width) || (precision != 2 && precision != 4))
+		{
+			return false;
+		}
+
+		int grid_step = head[4];
+		int grid_rows = head[5];
+		int grid_cols = head[6];
+		if (grid_step < 1 || grid_rows != (height - 1) / grid_step + 4 || grid_cols != (width - 1) / grid_step + 4)
+		{
+			return false;
+		}
+
+		int node_number = grid_rows * grid_cols;
+		std::vector<float> offset(2 * (size_t)node_number);
+		if (precision == 2)
 		{
-			point.x = 0;
+			std::vector<uint16_t> half_offset(offset.size());
+			file_in.read((char*)half_offset.data(), half_offset.size() * sizeof(uint16_t));
+			for (size_t i = 0; i < offset.size(); i++)
+			{
+				offset[i] = halfToFloat(half_offset[i]);
+			}
 		}
-		if (point.y < 0)
+		else
 		{
-			point.y = 0;
+			file_in.read((char*)offset.data(), offset.size() * sizeof(float));
 		}
-		if (point.x > map_x.cols() - 2)
+		if (!file_in)
 		{
-			point.x = (float)map_x.cols() - 2.f;
+			return false;
 		}
-		if (point.y > map_y.rows() - 2)
+		file_in.close();
+
+		Eigen::MatrixXf grid_x(grid_rows, grid_cols);
+		Eigen::MatrixXf grid_y(grid_rows, grid_cols);
+		for (int i = 0; i < grid_cols; i++)
 		{
-			point.y = (float)map_y.rows() - 2.f;
+			for (int j = 0; j < grid_rows; j++)
+			{
+				Point2D sensor_coordinate((float)((i - 1) * grid_step), (float)((j - 1) * grid_step));
+				Point2D identity = sensor_to_image(sensor_coordinate);
+				int index = i * grid_rows + j;
+				grid_x(j, i) = identity.x + offset[2 * index] / intrinsics.fx;
+				grid_y(j, i) = identity.y + offset[2 * index + 1] / intrinsics.fy;
+			}
 		}
+		upsampleGrid(height, width, grid_step, grid_x, grid_y);
 
-		//get integral part and decimal part of the coordinate
-		int y_integral = (int)floor(point.y);
-		int x_integral = (int)floor(point.x);
+		return true;
+	}
 
-		float y_decimal = point.y - y_integral;
-		float x_decimal = point.x - x_integral;
+	int Calibration::getMapGridStep() const
+	{
+		return map_grid_step;
+	}
 
-		//locate the position of the point in the map of distorted image coordinates
-		float corrected_y = map_y(y_integral, x_integral) * (1 - y_decimal) * (1 - x_decimal)
-			+ map_y(y_integral + 1, x_integral) * y_decimal * (1 - x_decimal)
-			+ map_y(y_integral, x_integral + 1) * (1 - y_decimal) * x_decimal
-			+ map_y(y_integral + 1, x_integral + 1) * y_decimal * x_decimal;
+	float Calibration::getMapTolerance() const
+	{
+		return map_tolerance;
+	}
 
-		float corrected_x = map_x(y_integral, x_integral) * (1 - y_decimal) * (1 - x_decimal)
-			+ map_x(y_integral + 1, x_integral) * y_decimal * (1 - x_decimal)
-			+ map_x(y_integral, x_integral + 1) * (1 - y_decimal) * x_decimal
-			+ map_x(y_integral + 1, x_integral + 1) * y_decimal * x_decimal;
+	void Calibration::setMapGrid(int grid_step, float tolerance)
+	{
+		map_grid_step = grid_step;
+		map_tolerance = tolerance;
+	}
 
-		Point2D image_coordinate(corrected_x, corrected_y);
+	void Calibration::setMapCache(std::string cache_dir)
+	{
+		map_cache_dir = cache_dir;
+	}
 
-		//convert to the sensor coordinates
-		Point2D undistorted_coordinate(image_to_sensor(image_coordinate));
+	Point2D Calibration::undistort(Point2D& point)
+	{
+		Point2D undistorted_coordinate;
+		undistort(&point.x, &point.y, &undistorted_coordinate.x, &undistorted_coordinate.y, 1);
 		return undistorted_coordinate;
 	}
 
+	void Calibration::undistort(const float* x, const float* y, float* undistorted_x, float* undistorted_y, int point_number)
+	{
+		const float* map_x_data = map_x.data();
+		const float* map_y_data = map_y.data();
+		int map_rows = (int)map_x.rows();
+		float x_limit = (float)map_x.cols() - 2.f;
+		float y_limit = (float)map_x.rows() - 2.f;
+		float nan = std::numeric_limits<float>::quiet_NaN();
+
+		for (int i = 0; i < point_number; i++)
+		{
+			//deal with the points adjacent to boundary, NaN is clamped to 0 here and restored in the output
+			float point_x = std::min(std::max(0.f, x[i]), x_limit);
+			float point_y = std::min(std::max(0.f, y[i]), y_limit);
+
+			//get integral part and decimal part of the coordinate, the map is stored in column-major order
+			int x_integral = (int)point_x;
+			int y_integral = (int)point_y;
+			float x_decimal = point_x - x_integral;
+			float y_decimal = point_y - y_integral;
+			int index = x_integral * map_rows + y_integral;
+
+			//bilinear interpolation on the map of distorted image coordinates
+			float weight_00 = (1 - y_decimal) * (1 - x_decimal);
+			float weight_10 = y_decimal * (1 - x_decimal);
+			float weight_01 = (1 - y_decimal) * x_decimal;
+			float weight_11 = y_decimal * x_decimal;
+
+			float corrected_x = map_x_data[index] * weight_00 + map_x_data[index + 1] * weight_10
+				+ map_x_data[index + map_rows] * weight_01 + map_x_data[index + map_rows + 1] * weight_11;
+			float corrected_y = map_y_data[index] * weight_00 + map_y_data[index + 1] * weight_10
+				+ map_y_data[index + map_rows] * weight_01 + map_y_data[index + map_rows + 1] * weight_11;
+
+			//convert to the sensor coordinates
+			bool is_nan = std::isnan(x[i]) || std::isnan(y[i]);
+			undistorted_x[i] = is_nan ? nan : corrected_x * intrinsics.fx + corrected_y * intrinsics.fs + intrinsics.cx;
+			undistorted_y[i] = is_nan ? nan : corrected_y * intrinsics.fy + intrinsics.cy;
+		}
+	}
+
+	void Calibration::distort(const float* x, const float* y, float* distorted_x, float* distorted_y, int point_number)
+	{
+		float k1 = intrinsics.k1, k2 = intrinsics.k2, k3 = intrinsics.k3;
+		float k4 = intrinsics.k4, k5 = intrinsics.k5, k6 = intrinsics.k6;
+		float p1 = intrinsics.p1, p2 = intrinsics.p2;
+
+		for (int i = 0; i < point_number; i++)
+		{
+			float image_xx = x[i] * x[i];
+			float image_yy = y[i] * y[i];
+			float image_xy = x[i] * y[i];
+			float distortion_r2 = image_xx + image_yy;
+			float distortion_r4 = distortion_r2 * distortion_r2;
+			float distortion_r6 = distortion_r2 * distortion_r4;
+
+			float radial_factor = (1 + k1 * distortion_r2 + k2 * distortion_r4 + k3 * distortion_r6)
+				/ (1 + k4 * distortion_r2 + k5 * distortion_r4 + k6 * distortion_r6);
+
+			distorted_x[i] = x[i] * radial_factor + 2 * p1 * image_xy + p2 * (distortion_r2 + 2 * image_xx);
+			distorted_y[i] = y[i] * radial_factor + p1 * (distortion_r2 + 2 * image_yy) + 2 * p2 * image_xy;
+		}
+	}
+
+	void Calibration::undistort(std::vector<float>& x, std::vector<float>& y, std::vector<float>& undistorted_x, std::vector<float>& undistorted_y)
+	{
+		int point_number = (int)x.size();
+		if ((int)y.size() != point_number)
+		{
+			throw std::string("Mismatched length of coordinate arrays");
+		}
+
+		undistorted_x.resize(point_number);
+		undistorted_y.resize(point_number);
+		undistort(x.data(), y.data(), undistorted_x.data(), undistorted_y.data(), point_number);
+	}
+
+	void Calibration::distort(std::vector<float>& x, std::vector<float>& y, std::vector<float>& distorted_x, std::vector<float>& distorted_y)
+	{
+		int point_number = (int)x.size();
+		if ((int)y.size() != point_number)
+		{
+			throw std::string("Mismatched length of coordinate arrays");
+		}
+
+		distorted_x.resize(point_number);
+		distorted_y.resize(point_number);
+		distort(x.data(), y.data(), distorted_x.data(), distorted_y.data(), point_number);
+	}
+
 }//namespace opencorr
@@ -17,6 +17,9 @@
 #ifndef _CALIBRATION_H_
 #define _CALIBRATION_H_
 
+#include <cstdint>
+#include <string>
+
 #include "oc_array.h"
 #include "oc_point.h"
 
@@ -46,6 +49,21 @@ namespace opencorr
 
 	class Calibration
 	{
+	protected:
+		int map_grid_step; //initial step of the coarse grid where the maps are solved iteratively, 1 for full resolution
+		float map_tolerance; //tolerance of the error of upsampled maps, in pixels
+		std::string map_cache_dir; //directory for caching the maps, empty string disables the cache
+
+		Point2D solveImageCoordinate(Point2D& sensor_coordinate); //iterative inversion of distortion at one point
+		void solveGrid(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y);
+		void upsampleGrid(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y);
+		float checkGrid(int height, int width, int grid_step); //maximum error at the centers of grid cells
+
+		uint64_t mapHash(int height, int width) const;
+		std::string mapFile(int height, int width) const;
+		void saveMap(int height, int width, int grid_step, Eigen::MatrixXf& grid_x, Eigen::MatrixXf& grid_y);
+		bool loadMap(int height, int width);
+
 	public:
 		CameraIntrinsics intrinsics;
 		CameraExtrinsics extrinsics;
@@ -78,6 +96,12 @@ namespace opencorr
 		int getIteration() const;
 		void setUndistortion(float convergence, int iteration);
 
+		//get and set the coarse grid and the cache of undistortion maps
+		int getMapGridStep() const;
+		float getMapTolerance() const;
+		void setMapGrid(int grid_step, float tolerance);
+		void setMapCache(std::string cache_dir);
+
 		//convert the coordinate between image/retina system and sensor/pixel system
 		Point2D image_to_sensor(Point2D& point);
 		Point2D sensor_to_image(Point2D& point);
@@ -91,6 +115,12 @@ namespace opencorr
 
 		//undistortion throught interpolation on image-sensor coordinate map
 		Point2D undistort(Point2D& point);
+
+		//batch versions for arrays of coordinates, the input arrays are not modified
+		void undistort(const float* x, const float* y, float* undistorted_x, float* undistorted_y, int point_number);
+		void distort(const float* x, const float* y, float* distorted_x, float* distorted_y, int point_number);
+		void undistort(std::vector<float>& x, std::vector<float>& y, std::vector<float>& undistorted_x, std::vector<float>& undistorted_y);
+		void distort(std::vector<float>& x, std::vector<float>& y, std::vector<float>& distorted_x, std::vector<float>& distorted_y);
 	};
 
 } //opencorr
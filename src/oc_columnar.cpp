@@ -0,0 +1,392 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "oc_columnar.h"
+
+namespace opencorr
+{
+	MappedFile::MappedFile()
+		: mapped_data(nullptr), mapped_size(0), file_handle(nullptr), mapping_handle(nullptr) {}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(std::string file_path)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		file_handle = file;
+		mapping_handle = mapping;
+		mapped_data = (const char*)view;
+		mapped_size = (size_t)file_size.QuadPart;
+#else
+		int file = ::open(file_path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat file_status;
+		if (fstat(file, &file_status) != 0 || file_status.st_size == 0)
+		{
+			::close(file);
+			return false;
+		}
+
+		void* view = mmap(nullptr, (size_t)file_status.st_size, PROT_READ, MAP_SHARED, file, 0);
+		if (view == MAP_FAILED)
+		{
+			::close(file);
+			return false;
+		}
+
+		file_handle = (void*)(intptr_t)file;
+		mapped_data = (const char*)view;
+		mapped_size = (size_t)file_status.st_size;
+#endif
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (mapped_data == nullptr)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(mapped_data);
+		CloseHandle((HANDLE)mapping_handle);
+		CloseHandle((HANDLE)file_handle);
+#else
+		munmap((void*)mapped_data, mapped_size);
+		::close((int)(intptr_t)file_handle);
+#endif
+
+		mapped_data = nullptr;
+		mapped_size = 0;
+		file_handle = nullptr;
+		mapping_handle = nullptr;
+	}
+
+	const char* MappedFile::data() const
+	{
+		return mapped_data;
+	}
+
+	size_t MappedFile::size() const
+	{
+		return mapped_size;
+	}
+
+	//layout of a table: the header, the field table, then the columns starting at aligned offsets
+	static void makeLayout(int poi_type, int dimension[3], size_t poi_number, std::vector<std::string>& field_names,
+		ColumnarHeader& header, std::vector<ColumnarField>& fields, size_t& data_begin, size_t& aligned_column_size)
+	{
+		const size_t alignment = ColumnarTable::ALIGNMENT;
+		int field_number = (int)field_names.size();
+
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "OCCB", 4);
+		header.version = ColumnarTable::VERSION;
+		header.poi_type = (uint32_t)poi_type;
+		header.field_number = (uint32_t)field_number;
+		header.poi_number = (uint64_t)poi_number;
+		for (int i = 0; i < 3; i++)
+		{
+			header.dimension[i] = dimension[i];
+		}
+
+		size_t column_size = sizeof(float) * poi_number;
+		aligned_column_size = (column_size + alignment - 1) / alignment * alignment;
+		size_t table_end = sizeof(ColumnarHeader) + sizeof(ColumnarField) * field_number;
+		data_begin = (table_end + alignment - 1) / alignment * alignment;
+
+		fields.resize(field_number);
+		for (int i = 0; i < field_number; i++)
+		{
+			std::memset(&fields[i], 0, sizeof(ColumnarField));
+			std::strncpy(fields[i].name, field_names[i].c_str(), sizeof(fields[i].name) - 1);
+			fields[i].offset = (uint64_t)(data_begin + aligned_column_size * i);
+		}
+	}
+
+	ColumnarTable::ColumnarTable()
+		: table_data(nullptr), header(nullptr), field_table(nullptr) {}
+
+	ColumnarTable::~ColumnarTable()
+	{
+		close();
+	}
+
+	void ColumnarTable::parse(const char* data, size_t data_size, std::string source)
+	{
+		if (data_size < sizeof(ColumnarHeader) || std::memcmp(data, "OCCB", 4) != 0)
+		{
+			throw std::string("Not a columnar table: " + source);
+		}
+
+		const ColumnarHeader* table_header = (const ColumnarHeader*)data;
+		if (table_header->version != VERSION)
+		{
+			throw std::string("Unsupported version of columnar table: " + source);
+		}
+
+		//check that the field table and all columns lie within the data
+		size_t table_end = sizeof(ColumnarHeader) + sizeof(ColumnarField) * (size_t)table_header->field_number;
+		if (table_end > data_size)
+		{
+			throw std::string("Truncated columnar table: " + source);
+		}
+		const ColumnarField* fields = (const ColumnarField*)(data + sizeof(ColumnarHeader));
+		for (uint32_t i = 0; i < table_header->field_number; i++)
+		{
+			if (fields[i].offset + sizeof(float) * table_header->poi_number > data_size)
+			{
+				throw std::string("Truncated columnar table: " + source);
+			}
+		}
+
+		table_data = data;
+		header = table_header;
+		field_table = fields;
+	}
+
+	void ColumnarTable::open(std::string file_path)
+	{
+		close();
+
+		if (!mapped_file.open(file_path))
+		{
+			throw std::string("Failed to map file " + file_path);
+		}
+
+		try
+		{
+			parse(mapped_file.data(), mapped_file.size(), file_path);
+		}
+		catch (std::string&)
+		{
+			mapped_file.close();
+			throw;
+		}
+	}
+
+	void ColumnarTable::open(const char* data, size_t data_size)
+	{
+		close();
+		parse(data, data_size, "memory");
+	}
+
+	void ColumnarTable::close()
+	{
+		mapped_file.close();
+		table_data = nullptr;
+		header = nullptr;
+		field_table = nullptr;
+	}
+
+	int ColumnarTable::getType() const
+	{
+		return header != nullptr ? (int)header->poi_type : 0;
+	}
+
+	size_t ColumnarTable::getPOINumber() const
+	{
+		return header != nullptr ? (size_t)header->poi_number : 0;
+	}
+
+	int ColumnarTable::getFieldNumber() const
+	{
+		return header != nullptr ? (int)header->field_number : 0;
+	}
+
+	std::string ColumnarTable::getFieldName(int field_index) const
+	{
+		if (header == nullptr || field_index < 0 || field_index >= (int)header->field_number)
+		{
+			return std::string();
+		}
+
+		const char* name = field_table[field_index].name;
+		return std::string(name, strnlen(name, sizeof(field_table[field_index].name)));
+	}
+
+	int ColumnarTable::getDimension(int axis) const
+	{
+		return (header != nullptr && axis >= 0 && axis < 4) ? header->dimension[axis] : 0;
+	}
+
+	const float* ColumnarTable::getColumn(int field_index) const
+	{
+		if (header == nullptr || field_index < 0 || field_index >= (int)header->field_number)
+		{
+			return nullptr;
+		}
+
+		return (const float*)(table_data + field_table[field_index].offset);
+	}
+
+	const float* ColumnarTable::getColumn(std::string field_name) const
+	{
+		for (int i = 0; i < getFieldNumber(); i++)
+		{
+			if (getFieldName(i) == field_name)
+			{
+				return getColumn(i);
+			}
+		}
+
+		return nullptr;
+	}
+
+	void ColumnarTable::write(std::string file_path, int poi_type, int dimension[3], const char* poi_data, size_t poi_size,
+		size_t poi_number, std::vector<std::string>& field_names, std::vector<size_t>& field_offsets)
+	{
+		ColumnarHeader file_header;
+		std::vector<ColumnarField> fields;
+		size_t data_begin, aligned_column_size;
+		makeLayout(poi_type, dimension, poi_number, field_names, file_header, fields, data_begin, aligned_column_size);
+
+		int field_number = (int)fields.size();
+		size_t column_size = sizeof(float) * poi_number;
+		size_t table_end = sizeof(ColumnarHeader) + sizeof(ColumnarField) * field_number;
+
+		std::ofstream file_out(file_path, std::ios::out | std::ios::binary);
+		if (!file_out.is_open())
+		{
+			throw std::string("Failed to open file " + file_path);
+		}
+
+		std::vector<char> padding(ALIGNMENT, 0);
+		file_out.write((const char*)&file_header, sizeof(file_header));
+		file_out.write((const char*)fields.data(), sizeof(ColumnarField) * field_number);
+		file_out.write(padding.data(), data_begin - table_end);
+
+		std::vector<float> column(poi_number);
+		long long column_length = (long long)poi_number;
+		for (int f = 0; f < field_number; f++)
+		{
+			const char* field_data = poi_data + field_offsets[f];
+#pragma omp parallel for
+			for (long long i = 0; i < column_length; i++)
+			{
+				column[i] = *(const float*)(field_data + poi_size * i);
+			}
+
+			file_out.write((const char*)column.data(), column_size);
+			file_out.write(padding.data(), aligned_column_size - column_size);
+		}
+
+		if (!file_out.good())
+		{
+			throw std::string("Failed to write file " + file_path);
+		}
+		file_out.close();
+	}
+
+	void ColumnarTable::pack(int poi_type, int dimension[3], const char* poi_data, size_t poi_size, size_t poi_number,
+		std::vector<std::string>& field_names, std::vector<size_t>& field_offsets, std::vector<char>& block)
+	{
+		ColumnarHeader block_header;
+		std::vector<ColumnarField> fields;
+		size_t data_begin, aligned_column_size;
+		makeLayout(poi_type, dimension, poi_number, field_names, block_header, fields, data_begin, aligned_column_size);
+
+		int field_number = (int)fields.size();
+		size_t column_size = sizeof(float) * poi_number;
+		block.resize(data_begin + aligned_column_size * field_number);
+		std::memset(block.data(), 0, data_begin);
+		std::memcpy(block.data(), &block_header, sizeof(block_header));
+		std::memcpy(block.data() + sizeof(block_header), fields.data(), sizeof(ColumnarField) * field_number);
+
+		long long column_length = (long long)poi_number;
+		for (int f = 0; f < field_number; f++)
+		{
+			const char* field_data = poi_data + field_offsets[f];
+			float* column = (float*)(block.data() + fields[f].offset);
+			std::memset(block.data() + fields[f].offset + column_size, 0, aligned_column_size - column_size);
+#pragma omp parallel for
+			for (long long i = 0; i < column_length; i++)
+			{
+				column[i] = *(const float*)(field_data + poi_size * i);
+			}
+		}
+	}
+
+	size_t ColumnarTable::getTableSize(const char* data, size_t data_size)
+	{
+		if (data_size < sizeof(ColumnarHeader) || std::memcmp(data, "OCCB", 4) != 0)
+		{
+			return 0;
+		}
+
+		const ColumnarHeader* table_header = (const ColumnarHeader*)data;
+		size_t table_end = sizeof(ColumnarHeader) + sizeof(ColumnarField) * (size_t)table_header->field_number;
+		size_t data_begin = (table_end + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		size_t column_size = sizeof(float) * (size_t)table_header->poi_number;
+		size_t aligned_column_size = (column_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		size_t table_size = data_begin + aligned_column_size * table_header->field_number;
+
+		return table_size <= data_size ? table_size : 0;
+	}
+
+}//namespace opencorr
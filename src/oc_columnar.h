@@ -0,0 +1,118 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _COLUMNAR_H_
+#define _COLUMNAR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace opencorr
+{
+	//read-only memory mapping of a whole file
+	class MappedFile
+	{
+	private:
+		const char* mapped_data;
+		size_t mapped_size;
+		void* file_handle; //HANDLE on Windows, file descriptor elsewhere
+		void* mapping_handle; //only used on Windows
+
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool open(std::string file_path);
+		void close();
+
+		const char* data() const;
+		size_t size() const;
+	};
+
+	//binary columnar format for POI queues, little-endian:
+	//header, field table, then one float32 column per field, each column aligned to 64 bytes
+	enum ColumnarType
+	{
+		COLUMNAR_POI2D = 1,
+		COLUMNAR_POI2DS = 2,
+		COLUMNAR_POI3D = 3
+	};
+
+	struct ColumnarHeader
+	{
+		char magic[4]; //"OCCB"
+		uint32_t version;
+		uint32_t poi_type; //ColumnarType
+		uint32_t field_number;
+		uint64_t poi_number;
+		int32_t dimension[4]; //width and height of image in 2D, dim_x, dim_y and dim_z in 3D
+	};
+
+	struct ColumnarField
+	{
+		char name[24];
+		uint64_t offset; //offset of column from the beginning of file, in bytes
+	};
+
+	//zero-copy view of a columnar file through memory mapping
+	class ColumnarTable
+	{
+	private:
+		MappedFile mapped_file;
+		const char* table_data; //beginning of the table, in the mapped file or in memory
+		const ColumnarHeader* header;
+		const ColumnarField* field_table;
+
+		void parse(const char* data, size_t data_size, std::string source);
+
+	public:
+		static const uint32_t VERSION = 1;
+		static const size_t ALIGNMENT = 64;
+
+		ColumnarTable();
+		~ColumnarTable();
+
+		void open(std::string file_path);
+		void open(const char* data, size_t data_size); //view a table in memory, e.g. a frame of streamed file
+		void close();
+
+		int getType() const;
+		size_t getPOINumber() const;
+		int getFieldNumber() const;
+		std::string getFieldName(int field_index) const;
+		int getDimension(int axis) const;
+
+		//pointers to the columns in mapped memory, valid until close(), nullptr if the field does not exist
+		const float* getColumn(int field_index) const;
+		const float* getColumn(std::string field_name) const;
+
+		//write the fields of a POI queue, each field is a float located at the given byte offset in POI object,
+		//each column is gathered into a buffer and written in one call
+		static void write(std::string file_path, int poi_type, int dimension[3], const char* poi_data, size_t poi_size,
+			size_t poi_number, std::vector<std::string>& field_names, std::vector<size_t>& field_offsets);
+
+		//pack the same content into a block in memory, the size of block is a multiple of ALIGNMENT
+		static void pack(int poi_type, int dimension[3], const char* poi_data, size_t poi_size, size_t poi_number,
+			std::vector<std::string>& field_names, std::vector<size_t>& field_offsets, std::vector<char>& block);
+
+		//size of a table in the beginning of data, 0 if the table is incomplete or invalid
+		static size_t getTableSize(const char* data, size_t data_size);
+	};
+
+}//namespace opencorr
+
+#endif //_COLUMNAR_H_
@@ -12,7 +12,10 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <algorithm>
+
 #include "oc_cubic_bspline.h"
+#include "oc_numa.h"
 
 namespace opencorr
 {
@@ -45,60 +48,62 @@ namespace opencorr
 		}
 		interp_coefficient = new4D(height, width, 4, 4);
 
-#pragma omp parallel for
-		for (int r = 1; r < height - 2; r++)
+		numaFor(width, [&](int begin, int end)
 		{
-			for (int c = 1; c < width - 2; c++)
+			for (int c = std::max(begin, 1); c < std::min(end, width - 2); c++)
 			{
-				float matrix_g[4][4] = { 0.f };
-				float matrix_b[4][4] = { 0.f };
-				for (int i = 0; i < 4; i++)
+				for (int r = 1; r < height - 2; r++)
 				{
-					for (int j = 0; j < 4; j++) {
-						matrix_g[i][j] = interp_img->eg_mat(r - 1 + i, c - 1 + j);
+					float matrix_g[4][4] = { 0.f };
+					float matrix_b[4][4] = { 0.f };
+					for (int i = 0; i < 4; i++)
+					{
+						for (int j = 0; j < 4; j++) {
+							matrix_g[i][j] = interp_img->eg_mat(r - 1 + i, c - 1 + j);
+						}
 					}
-				}
 
-				for (int k = 0; k < 4; k++)
-				{
-					for (int l = 0; l < 4; l++)
+					for (int k = 0; k < 4; k++)
 					{
-						for (int m = 0; m < 4; m++)
+						for (int l = 0; l < 4; l++)
 						{
-							for (int n = 0; n < 4; n++)
+							for (int m = 0; m < 4; m++)
 							{
-								matrix_b[k][l] += CONTROL_MATRIX[k][m] * CONTROL_MATRIX[l][n] * matrix_g[n][m];
+								for (int n = 0; n < 4; n++)
+								{
+									matrix_b[k][l] += CONTROL_MATRIX[k][m] * CONTROL_MATRIX[l][n] * matrix_g[n][m];
+								}
 							}
 						}
 					}
-				}
 
-				for (int k = 0; k < 4; k++)
-				{
-					for (int l = 0; l < 4; l++)
+					for (int k = 0; k < 4; k++)
 					{
-						interp_coefficient[r][c][k][l] = 0;
-						for (int m = 0; m < 4; m++)
+						for (int l = 0; l < 4; l++)
 						{
-							for (int n = 0; n < 4; n++)
+							interp_coefficient[r][c][k][l] = 0;
+							for (int m = 0; m < 4; m++)
 							{
-								interp_coefficient[r][c][k][l] += FUNCTION_MATRIX[k][m] * FUNCTION_MATRIX[l][n] * matrix_b[n][m];
+								for (int n = 0; n < 4; n++)
+								{
+									interp_coefficient[r][c][k][l] += FUNCTION_MATRIX[k][m] * FUNCTION_MATRIX[l][n] * matrix_b[n][m];
+								}
 							}
 						}
 					}
-				}
 
-				for (int k = 0; k < 2; k++)
-				{
-					for (int l = 0; l < 4; l++)
+					for (int k = 0; k < 2; k++)
 					{
-						float buffer = interp_coefficient[r][c][k][l];
-						interp_coefficient[r][c][k][l] = interp_coefficient[r][c][3 - k][3 - l];
-						interp_coefficient[r][c][3 - k][3 - l] = buffer;
+						for (int l = 0; l < 4; l++)
+						{
+							float buffer = interp_coefficient[r][c][k][l];
+							interp_coefficient[r][c][k][l] = interp_coefficient[r][c][3 - k][3 - l];
+							interp_coefficient[r][c][3 - k][3 - l] = buffer;
+						}
 					}
 				}
 			}
-		}
+		});
 	}
 
 	float BicubicBspline::compute(Point2D& location)
@@ -181,46 +186,48 @@ namespace opencorr
 		float*** conv_buffer = new3D(dim_z, dim_y, dim_x);
 
 		//convolution along x-axis
-#pragma omp parallel for
-		for (int i = 0; i < dim_z; i++)
+		numaFor(dim_z, [&](int begin, int end)
 		{
-			for (int j = 0; j < dim_y; j++)
+			for (int i = begin; i < end; i++)
 			{
-				for (int k = 7; k < dim_x - 7; k++)
-				{
-					interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
-						BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][k - 1] + interp_img->vol_mat[i][j][k + 1]) +
-						BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][k - 2] + interp_img->vol_mat[i][j][k + 2]) +
-						BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][k - 3] + interp_img->vol_mat[i][j][k + 3]) +
-						BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][k - 4] + interp_img->vol_mat[i][j][k + 4]) +
-						BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][k - 5] + interp_img->vol_mat[i][j][k + 5]) +
-						BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][k - 6] + interp_img->vol_mat[i][j][k + 6]) +
-						BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][k - 7] + interp_img->vol_mat[i][j][k + 7]);
-				}
-				for (int k = 0; k < 7; k++)
+				for (int j = 0; j < dim_y; j++)
 				{
-					interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
-						BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][getHigh(k - 1, 0)] + interp_img->vol_mat[i][j][k + 1]) +
-						BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][getHigh(k - 2, 0)] + interp_img->vol_mat[i][j][k + 2]) +
-						BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][getHigh(k - 3, 0)] + interp_img->vol_mat[i][j][k + 3]) +
-						BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][getHigh(k - 4, 0)] + interp_img->vol_mat[i][j][k + 4]) +
-						BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][getHigh(k - 5, 0)] + interp_img->vol_mat[i][j][k + 5]) +
-						BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][getHigh(k - 6, 0)] + interp_img->vol_mat[i][j][k + 6]) +
-						BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][getHigh(k - 7, 0)] + interp_img->vol_mat[i][j][k + 7]);
-				}
-				for (int k = dim_x - 7; k < dim_x; k++)
-				{
-					interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
-						BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][k - 1] + interp_img->vol_mat[i][j][getLow(k + 1, dim_x - 1)]) +
-						BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][k - 2] + interp_img->vol_mat[i][j][getLow(k + 2, dim_x - 1)]) +
-						BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][k - 3] + interp_img->vol_mat[i][j][getLow(k + 3, dim_x - 1)]) +
-						BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][k - 4] + interp_img->vol_mat[i][j][getLow(k + 4, dim_x - 1)]) +
-						BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][k - 5] + interp_img->vol_mat[i][j][getLow(k + 5, dim_x - 1)]) +
-						BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][k - 6] + interp_img->vol_mat[i][j][getLow(k + 6, dim_x - 1)]) +
-						BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][k - 7] + interp_img->vol_mat[i][j][getLow(k + 7, dim_x - 1)]);
+					for (int k = 7; k < dim_x - 7; k++)
+					{
+						interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
+							BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][k - 1] + interp_img->vol_mat[i][j][k + 1]) +
+							BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][k - 2] + interp_img->vol_mat[i][j][k + 2]) +
+							BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][k - 3] + interp_img->vol_mat[i][j][k + 3]) +
+							BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][k - 4] + interp_img->vol_mat[i][j][k + 4]) +
+							BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][k - 5] + interp_img->vol_mat[i][j][k + 5]) +
+							BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][k - 6] + interp_img->vol_mat[i][j][k + 6]) +
+							BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][k - 7] + interp_img->vol_mat[i][j][k + 7]);
+					}
+					for (int k = 0; k < 7; k++)
+					{
+						interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
+							BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][getHigh(k - 1, 0)] + interp_img->vol_mat[i][j][k + 1]) +
+							BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][getHigh(k - 2, 0)] + interp_img->vol_mat[i][j][k + 2]) +
+							BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][getHigh(k - 3, 0)] + interp_img->vol_mat[i][j][k + 3]) +
+							BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][getHigh(k - 4, 0)] + interp_img->vol_mat[i][j][k + 4]) +
+							BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][getHigh(k - 5, 0)] + interp_img->vol_mat[i][j][k + 5]) +
+							BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][getHigh(k - 6, 0)] + interp_img->vol_mat[i][j][k + 6]) +
+							BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][getHigh(k - 7, 0)] + interp_img->vol_mat[i][j][k + 7]);
+					}
+					for (int k = dim_x - 7; k < dim_x; k++)
+					{
+						interp_coefficient[i][j][k] = BSPLINE_PREFILTER[0] * interp_img->vol_mat[i][j][k] +
+							BSPLINE_PREFILTER[1] * (interp_img->vol_mat[i][j][k - 1] + interp_img->vol_mat[i][j][getLow(k + 1, dim_x - 1)]) +
+							BSPLINE_PREFILTER[2] * (interp_img->vol_mat[i][j][k - 2] + interp_img->vol_mat[i][j][getLow(k + 2, dim_x - 1)]) +
+							BSPLINE_PREFILTER[3] * (interp_img->vol_mat[i][j][k - 3] + interp_img->vol_mat[i][j][getLow(k + 3, dim_x - 1)]) +
+							BSPLINE_PREFILTER[4] * (interp_img->vol_mat[i][j][k - 4] + interp_img->vol_mat[i][j][getLow(k + 4, dim_x - 1)]) +
+							BSPLINE_PREFILTER[5] * (interp_img->vol_mat[i][j][k - 5] + interp_img->vol_mat[i][j][getLow(k + 5, dim_x - 1)]) +
+							BSPLINE_PREFILTER[6] * (interp_img->vol_mat[i][j][k - 6] + interp_img->vol_mat[i][j][getLow(k + 6, dim_x - 1)]) +
+							BSPLINE_PREFILTER[7] * (interp_img->vol_mat[i][j][k - 7] + interp_img->vol_mat[i][j][getLow(k + 7, dim_x - 1)]);
+					}
 				}
 			}
-		}
+		});
 
 		//convolution along y-axis
 #pragma omp parallel for
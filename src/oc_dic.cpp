@@ -22,6 +22,7 @@ namespace opencorr
 	{
 		this->ref_img = &ref_img;
 		this->tar_img = &tar_img;
+		scheduler.setNumaExtent((float)ref_img.width);
 	}
 
 	void DIC::setSubsetRadius(int subset_radius_x, int subset_radius_y)
@@ -39,6 +40,7 @@ namespace opencorr
 	{
 		this->ref_img = &ref_img;
 		this->tar_img = &tar_img;
+		scheduler.setNumaExtent((float)ref_img.dim_z);
 	}
 
 	void DVC::setSubsetRadius(int radius_x, int radius_y, int radius_z)
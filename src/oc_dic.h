@@ -20,6 +20,7 @@
 #include "oc_array.h"
 #include "oc_image.h"
 #include "oc_poi.h"
+#include "oc_scheduler.h"
 #include "oc_subset.h"
 
 namespace opencorr
@@ -39,6 +40,7 @@ namespace opencorr
 
 		int subset_radius_x, subset_radius_y;
 		int thread_number; //OpenMP thread number
+		Scheduler scheduler; //distribution of POIs among threads in batch processing
 
 		DIC();
 		virtual ~DIC() = default;
@@ -60,6 +62,7 @@ namespace opencorr
 
 		int subset_radius_x, subset_radius_y, subset_radius_z;
 		int thread_number; //OpenMP thread number
+		Scheduler scheduler; //distribution of POIs among threads in batch processing
 
 		DVC();
 		virtual ~DVC() = default;
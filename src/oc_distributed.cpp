@@ -0,0 +1,832 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <omp.h>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "oc_distributed.h"
+#include "oc_nearest_neighbor.h"
+
+namespace opencorr
+{
+	namespace
+	{
+		//types of messages between the coordinator and the workers
+		enum DistributedMessage
+		{
+			MESSAGE_STOP = 0,
+			MESSAGE_BLOCK = 1,
+			MESSAGE_RESULT = 2,
+			MESSAGE_ERROR = 3
+		};
+
+		//number of floats of a POI in messages: location, deformation, result, strain and subset radius
+		const int POI_RECORD_LENGTH = 31;
+
+		template <typename T>
+		void pack(std::vector<char>& message, const T& value)
+		{
+			const char* bytes = (const char*)&value;
+			message.insert(message.end(), bytes, bytes + sizeof(T));
+		}
+
+		template <typename T>
+		T unpack(const std::vector<char>& message, size_t& offset)
+		{
+			if (offset + sizeof(T) > message.size())
+			{
+				throw std::string("Truncated message in distributed DVC");
+			}
+			T value;
+			std::memcpy(&value, message.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		void packString(std::vector<char>& message, const std::string& text)
+		{
+			pack(message, (uint64_t)text.size());
+			message.insert(message.end(), text.begin(), text.end());
+		}
+
+		std::string unpackString(const std::vector<char>& message, size_t& offset)
+		{
+			uint64_t length = unpack<uint64_t>(message, offset);
+			if (length > message.size() - offset)
+			{
+				throw std::string("Truncated message in distributed DVC");
+			}
+			std::string text(message.data() + offset, (size_t)length);
+			offset += (size_t)length;
+			return text;
+		}
+
+		void packPOI(std::vector<char>& message, POI3D& poi)
+		{
+			float record[POI_RECORD_LENGTH];
+			record[0] = poi.x;
+			record[1] = poi.y;
+			record[2] = poi.z;
+			std::copy(std::begin(poi.deformation.p), std::end(poi.deformation.p), record + 3);
+			std::copy(std::begin(poi.result.r), std::end(poi.result.r), record + 15);
+			std::copy(std::begin(poi.strain.e), std::end(poi.strain.e), record + 22);
+			record[28] = poi.subset_radius.x;
+			record[29] = poi.subset_radius.y;
+			record[30] = poi.subset_radius.z;
+
+			const char* bytes = (const char*)record;
+			message.insert(message.end(), bytes, bytes + sizeof(record));
+		}
+
+		void unpackPOI(const std::vector<char>& message, size_t& offset, POI3D& poi)
+		{
+			float record[POI_RECORD_LENGTH];
+			if (offset + sizeof(record) > message.size())
+			{
+				throw std::string("Truncated message in distributed DVC");
+			}
+			std::memcpy(record, message.data() + offset, sizeof(record));
+			offset += sizeof(record);
+
+			poi.x = record[0];
+			poi.y = record[1];
+			poi.z = record[2];
+			std::copy(record + 3, record + 15, poi.deformation.p);
+			std::copy(record + 15, record + 22, poi.result.r);
+			std::copy(record + 22, record + 28, poi.strain.e);
+			poi.subset_radius.x = record[28];
+			poi.subset_radius.y = record[29];
+			poi.subset_radius.z = record[30];
+		}
+	}
+
+
+	//transport through pipes
+#ifndef _WIN32
+	namespace
+	{
+		//write the whole buffer, retrying after interruption by signals
+		bool writeAll(int fd, const char* data, size_t size)
+		{
+			while (size > 0)
+			{
+				ssize_t written = ::write(fd, data, size);
+				if (written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (written <= 0)
+				{
+					return false;
+				}
+				data += written;
+				size -= (size_t)written;
+			}
+			return true;
+		}
+
+		//read until the buffer is full or the end of pipe, return the number of bytes read
+		size_t readAll(int fd, char* data, size_t size)
+		{
+			size_t total = 0;
+			while (total < size)
+			{
+				ssize_t count = ::read(fd, data + total, size - total);
+				if (count < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (count <= 0)
+				{
+					break;
+				}
+				total += (size_t)count;
+			}
+			return total;
+		}
+	}
+#endif
+
+	PipeTransport::PipeTransport() : rank(0), size(1)
+	{
+		read_fd.assign(1, -1);
+		write_fd.assign(1, -1);
+	}
+
+	PipeTransport::~PipeTransport()
+	{
+		close();
+	}
+
+	void PipeTransport::spawn(int worker_number)
+	{
+#ifdef _WIN32
+		throw std::string("PipeTransport requires fork(), which is not available on Windows");
+#else
+		if (size > 1)
+		{
+			throw std::string("Workers of PipeTransport are already spawned");
+		}
+
+		//a lost worker is reported by send() rather than terminating the coordinator
+		signal(SIGPIPE, SIG_IGN);
+
+		read_fd.assign(worker_number + 1, -1);
+		write_fd.assign(worker_number + 1, -1);
+		for (int worker = 1; worker <= worker_number; worker++)
+		{
+			int to_worker[2], to_coordinator[2];
+			if (pipe(to_worker) != 0)
+			{
+				throw std::string("Failed to create pipes for workers");
+			}
+			if (pipe(to_coordinator) != 0)
+			{
+				::close(to_worker[0]);
+				::close(to_worker[1]);
+				throw std::string("Failed to create pipes for workers");
+			}
+
+			int pid = (int)fork();
+			if (pid < 0)
+			{
+				throw std::string("Failed to fork workers");
+			}
+
+			if (pid == 0)
+			{
+				//a worker keeps only its own link, the links of the coordinator to the earlier workers are closed
+				::close(to_worker[1]);
+				::close(to_coordinator[0]);
+				for (int peer = 1; peer < worker; peer++)
+				{
+					::close(read_fd[peer]);
+					::close(write_fd[peer]);
+				}
+				read_fd.assign(worker_number + 1, -1);
+				write_fd.assign(worker_number + 1, -1);
+				read_fd[0] = to_worker[0];
+				write_fd[0] = to_coordinator[1];
+				worker_pid.clear();
+				rank = worker;
+				size = worker_number + 1;
+				return;
+			}
+
+			::close(to_worker[0]);
+			::close(to_coordinator[1]);
+			read_fd[worker] = to_coordinator[0];
+			write_fd[worker] = to_worker[1];
+			worker_pid.push_back(pid);
+		}
+
+		rank = 0;
+		size = worker_number + 1;
+#endif
+	}
+
+	void PipeTransport::close()
+	{
+#ifndef _WIN32
+		for (size_t i = 0; i < read_fd.size(); i++)
+		{
+			if (read_fd[i] >= 0)
+			{
+				::close(read_fd[i]);
+			}
+			if (write_fd[i] >= 0)
+			{
+				::close(write_fd[i]);
+			}
+		}
+
+		for (auto& pid : worker_pid)
+		{
+			waitpid((pid_t)pid, nullptr, 0);
+		}
+#endif
+		worker_pid.clear();
+		read_fd.assign(read_fd.size(), -1);
+		write_fd.assign(write_fd.size(), -1);
+	}
+
+	int PipeTransport::getRank() const
+	{
+		return rank;
+	}
+
+	int PipeTransport::getSize() const
+	{
+		return size;
+	}
+
+	void PipeTransport::send(int rank, const std::vector<char>& message)
+	{
+		if (rank < 0 || rank >= (int)write_fd.size() || write_fd[rank] < 0)
+		{
+			throw std::string("No link to rank " + std::to_string(rank));
+		}
+
+#ifndef _WIN32
+		//each message is preceded by its length
+		uint64_t length = (uint64_t)message.size();
+		if (!writeAll(write_fd[rank], (const char*)&length, sizeof(length))
+			|| !writeAll(write_fd[rank], message.data(), message.size()))
+		{
+			throw std::string("Failed to send message to rank " + std::to_string(rank));
+		}
+#endif
+	}
+
+	bool PipeTransport::receive(int rank, std::vector<char>& message)
+	{
+		if (rank < 0 || rank >= (int)read_fd.size() || read_fd[rank] < 0)
+		{
+			throw std::string("No link to rank " + std::to_string(rank));
+		}
+
+#ifndef _WIN32
+		uint64_t length = 0;
+		size_t count = readAll(read_fd[rank], (char*)&length, sizeof(length));
+		if (count == 0)
+		{
+			return false;
+		}
+
+		if (count != sizeof(length))
+		{
+			throw std::string("Truncated message from rank " + std::to_string(rank));
+		}
+		message.resize((size_t)length);
+		if (readAll(read_fd[rank], message.data(), message.size()) != message.size())
+		{
+			throw std::string("Truncated message from rank " + std::to_string(rank));
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+
+	//distributed DVC
+	DistributedDVC::DistributedDVC(int subset_radius_x, int subset_radius_y, int subset_radius_z,
+		float conv_criterion, float stop_condition, int thread_number)
+	{
+		this->subset_radius_x = subset_radius_x;
+		this->subset_radius_y = subset_radius_y;
+		this->subset_radius_z = subset_radius_z;
+		this->conv_criterion = conv_criterion;
+		this->stop_condition = stop_condition;
+		this->thread_number = thread_number;
+
+		block_number_x = 2;
+		block_number_y = 2;
+		block_number_z = 2;
+		expected_displacement = (float)std::max(subset_radius_x, std::max(subset_radius_y, subset_radius_z));
+		seed_threshold = 0.8f;
+		exchange_rounds = 1;
+	}
+
+	void DistributedDVC::setBlocks(int block_number_x, int block_number_y, int block_number_z)
+	{
+		this->block_number_x = std::max(1, block_number_x);
+		this->block_number_y = std::max(1, block_number_y);
+		this->block_number_z = std::max(1, block_number_z);
+	}
+
+	void DistributedDVC::setExpectedDisplacement(float expected_displacement)
+	{
+		this->expected_displacement = expected_displacement;
+	}
+
+	void DistributedDVC::setSeedExchange(float seed_threshold, int exchange_rounds)
+	{
+		this->seed_threshold = seed_threshold;
+		this->exchange_rounds = exchange_rounds;
+	}
+
+	DistributedReport DistributedDVC::getReport() const
+	{
+		return report;
+	}
+
+	std::vector<VolumeBlock> DistributedDVC::partition(std::vector<POI3D>& poi_queue, std::vector<long long>& poi_index, int dimension[3]) const
+	{
+		int block_number[3] = { block_number_x, block_number_y, block_number_z };
+		int subset_radius[3] = { subset_radius_x, subset_radius_y, subset_radius_z };
+
+		//group the POIs by the cell of grid containing them
+		std::vector<std::vector<long long>> cell_poi(block_number[0] * block_number[1] * block_number[2]);
+		for (auto& index : poi_index)
+		{
+			POI3D& poi = poi_queue[index];
+			float location[3] = { poi.x, poi.y, poi.z };
+			int cell[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				int cell_coor = (int)std::floor(location[axis] * block_number[axis] / dimension[axis]);
+				cell[axis] = std::max(0, std::min(block_number[axis] - 1, cell_coor));
+			}
+			cell_poi[(cell[2] * block_number[1] + cell[1]) * block_number[0] + cell[0]].push_back(index);
+		}
+
+		//the loaded region covers the POIs of a cell and their subsets, shifted by the initial guess and the search
+		//range of FFT-CC around it
+		std::vector<VolumeBlock> blocks;
+		for (auto& cell : cell_poi)
+		{
+			if (cell.empty())
+			{
+				continue;
+			}
+
+			VolumeBlock block;
+			block.poi_index.swap(cell);
+
+			float lower[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float upper[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			float guess_max[3] = { 0.f, 0.f, 0.f };
+			for (auto& index : block.poi_index)
+			{
+				POI3D& poi = poi_queue[index];
+				float location[3] = { poi.x, poi.y, poi.z };
+				float guess[3] = { poi.deformation.u, poi.deformation.v, poi.deformation.w };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					lower[axis] = std::min(lower[axis], location[axis]);
+					upper[axis] = std::max(upper[axis], location[axis]);
+					guess_max[axis] = std::max(guess_max[axis], std::fabs(guess[axis]));
+				}
+			}
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float reach = expected_displacement + guess_max[axis];
+				int halo = subset_radius[axis] + (int)std::ceil(reach) + HALO_BORDER;
+				block.load_begin[axis] = std::max(0, std::min(dimension[axis] - 1, (int)std::floor(lower[axis]) - halo));
+				block.load_end[axis] = std::min(dimension[axis], (int)std::ceil(upper[axis]) + halo + 1);
+				block.load_end[axis] = std::max(block.load_end[axis], block.load_begin[axis] + 1);
+			}
+			blocks.push_back(block);
+		}
+
+		return blocks;
+	}
+
+	void DistributedDVC::encodeBlock(VolumeBlock& block, std::vector<POI3D>& poi_queue, std::string& ref_path, std::string& tar_path,
+		std::vector<char>& message) const
+	{
+		message.clear();
+		message.reserve(block.poi_index.size() * (sizeof(long long) + sizeof(float) * POI_RECORD_LENGTH) + 256);
+
+		pack(message, (int32_t)MESSAGE_BLOCK);
+		packString(message, ref_path);
+		packString(message, tar_path);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			pack(message, (int32_t)block.load_begin[axis]);
+			pack(message, (int32_t)block.load_end[axis]);
+		}
+		pack(message, (int32_t)subset_radius_x);
+		pack(message, (int32_t)subset_radius_y);
+		pack(message, (int32_t)subset_radius_z);
+		pack(message, conv_criterion);
+		pack(message, stop_condition);
+
+		pack(message, (int64_t)block.poi_index.size());
+		for (auto& index : block.poi_index)
+		{
+			pack(message, (int64_t)index);
+			packPOI(message, poi_queue[index]);
+		}
+	}
+
+	void DistributedDVC::processBlock(const std::vector<char>& message, std::vector<char>& result)
+	{
+		size_t offset = 0;
+		if (unpack<int32_t>(message, offset) != MESSAGE_BLOCK)
+		{
+			throw std::string("Unexpected message in distributed DVC");
+		}
+
+		std::string ref_path = unpackString(message, offset);
+		std::string tar_path = unpackString(message, offset);
+		int load_begin[3], load_end[3], dimension[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			load_begin[axis] = unpack<int32_t>(message, offset);
+			load_end[axis] = unpack<int32_t>(message, offset);
+			dimension[axis] = load_end[axis] - load_begin[axis];
+		}
+		int subset_radius[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			subset_radius[axis] = unpack<int32_t>(message, offset);
+		}
+		float block_conv_criterion = unpack<float>(message, offset);
+		float block_stop_condition = unpack<float>(message, offset);
+
+		//POIs are processed in the coordinates of loaded region
+		int64_t poi_number = unpack<int64_t>(message, offset);
+		if (poi_number < 0 || (uint64_t)poi_number > message.size() / (sizeof(float) * POI_RECORD_LENGTH))
+		{
+			throw std::string("Invalid number of POIs in distributed DVC");
+		}
+		std::vector<int64_t> poi_index((size_t)poi_number);
+		std::vector<POI3D> poi_queue((size_t)poi_number, POI3D(0, 0, 0));
+		for (int64_t i = 0; i < poi_number; i++)
+		{
+			poi_index[i] = unpack<int64_t>(message, offset);
+			unpackPOI(message, offset, poi_queue[i]);
+			poi_queue[i].x -= load_begin[0];
+			poi_queue[i].y -= load_begin[1];
+			poi_queue[i].z -= load_begin[2];
+		}
+
+		Image3D ref_img(dimension[0], dimension[1], dimension[2]);
+		Image3D tar_img(dimension[0], dimension[1], dimension[2]);
+		ref_img.loadBin(ref_path, load_begin[0], load_begin[1], load_begin[2], dimension[0], dimension[1], dimension[2]);
+		tar_img.loadBin(tar_path, load_begin[0], load_begin[1], load_begin[2], dimension[0], dimension[1], dimension[2]);
+
+		//FFTCC3D reads the subsets without check, the POIs whose subsets leave the loaded region are marked as ICGN3D1
+		//does at the boundary of image
+		std::vector<POI3D> valid_queue;
+		std::vector<int64_t> valid_slot;
+		for (int64_t i = 0; i < poi_number; i++)
+		{
+			POI3D& poi = poi_queue[i];
+			float location[3] = { poi.x, poi.y, poi.z };
+			float guess[3] = { poi.deformation.u, poi.deformation.v, poi.deformation.w };
+			bool inside = true;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float ref_lower = location[axis] - subset_radius[axis];
+				float ref_upper = location[axis] + subset_radius[axis];
+				float tar_lower = ref_lower + guess[axis];
+				float tar_upper = ref_upper + guess[axis];
+				if (!(ref_lower >= 0 && ref_upper <= dimension[axis] - 1 && tar_lower >= 0 && tar_upper <= dimension[axis] - 1))
+				{
+					inside = false;
+				}
+			}
+
+			if (inside)
+			{
+				valid_queue.push_back(poi);
+				valid_slot.push_back(i);
+			}
+			else
+			{
+				poi.result.zncc = -1;
+			}
+		}
+
+		if (!valid_queue.empty())
+		{
+			FFTCC3D fftcc(subset_radius[0], subset_radius[1], subset_radius[2], thread_number);
+			fftcc.setImages(ref_img, tar_img);
+			fftcc.compute(valid_queue);
+
+			ICGN3D1 icgn(subset_radius[0], subset_radius[1], subset_radius[2], block_conv_criterion, block_stop_condition, thread_number);
+			icgn.setImages(ref_img, tar_img);
+			icgn.prepare();
+			icgn.compute(valid_queue);
+
+			for (size_t i = 0; i < valid_queue.size(); i++)
+			{
+				poi_queue[valid_slot[i]] = valid_queue[i];
+			}
+		}
+
+		result.clear();
+		result.reserve((size_t)poi_number * (sizeof(int64_t) + sizeof(float) * POI_RECORD_LENGTH) + 16);
+		pack(result, (int32_t)MESSAGE_RESULT);
+		pack(result, poi_number);
+		for (int64_t i = 0; i < poi_number; i++)
+		{
+			POI3D& poi = poi_queue[i];
+			poi.x += load_begin[0];
+			poi.y += load_begin[1];
+			poi.z += load_begin[2];
+			pack(result, poi_index[i]);
+			packPOI(result, poi);
+		}
+	}
+
+	void DistributedDVC::mergeResult(const std::vector<char>& result, std::vector<POI3D>& poi_queue) const
+	{
+		size_t offset = 0;
+		int32_t type = unpack<int32_t>(result, offset);
+		if (type == MESSAGE_ERROR)
+		{
+			throw unpackString(result, offset);
+		}
+		if (type != MESSAGE_RESULT)
+		{
+			throw std::string("Unexpected message in distributed DVC");
+		}
+
+		int64_t poi_number = unpack<int64_t>(result, offset);
+		for (int64_t i = 0; i < poi_number; i++)
+		{
+			int64_t index = unpack<int64_t>(result, offset);
+			if (index < 0 || index >= (int64_t)poi_queue.size())
+			{
+				throw std::string("Invalid index of POI in distributed DVC");
+			}
+			unpackPOI(result, offset, poi_queue[index]);
+		}
+	}
+
+	void DistributedDVC::runBlocks(Transport& transport, std::vector<VolumeBlock>& blocks, std::vector<POI3D>& poi_queue,
+		std::string& ref_path, std::string& tar_path)
+	{
+		int worker_number = transport.getSize() - 1;
+		int round_size = worker_number + 1;
+		std::vector<char> message, result;
+
+		//one block for each worker and one for the coordinator in a round. A worker reads the whole block before
+		//writing its result, and the coordinator sends all the blocks before reading, thus no pipe blocks both ends
+		for (size_t first = 0; first < blocks.size(); first += round_size)
+		{
+			//the results of all the workers in the round are read before the first error is thrown, otherwise they
+			//would be left in the links and merged by the next call
+			std::string error;
+			int sent_number = 0;
+			try
+			{
+				for (int worker = 1; worker <= worker_number; worker++)
+				{
+					size_t block_index = first + worker;
+					if (block_index < blocks.size())
+					{
+						encodeBlock(blocks[block_index], poi_queue, ref_path, tar_path, message);
+						transport.send(worker, message);
+						sent_number = worker;
+					}
+				}
+
+				encodeBlock(blocks[first], poi_queue, ref_path, tar_path, message);
+				processBlock(message, result);
+				mergeResult(result, poi_queue);
+			}
+			catch (std::string& text)
+			{
+				error = text;
+			}
+			catch (std::exception& exception)
+			{
+				error = exception.what();
+			}
+
+			for (int worker = 1; worker <= sent_number; worker++)
+			{
+				if (!transport.receive(worker, result))
+				{
+					if (error.empty())
+					{
+						error = "Lost worker " + std::to_string(worker) + " in distributed DVC";
+					}
+					continue;
+				}
+
+				try
+				{
+					mergeResult(result, poi_queue);
+				}
+				catch (std::string& text)
+				{
+					if (error.empty())
+					{
+						error = text;
+					}
+				}
+			}
+
+			if (!error.empty())
+			{
+				throw error;
+			}
+		}
+
+		for (auto& block : blocks)
+		{
+			report.loaded_voxels += (long long)(block.load_end[0] - block.load_begin[0])
+				* (block.load_end[1] - block.load_begin[1]) * (block.load_end[2] - block.load_begin[2]);
+		}
+	}
+
+	void DistributedDVC::compute(Transport& transport, std::string ref_path, std::string tar_path, std::vector<POI3D>& poi_queue)
+	{
+		if (transport.getRank() != 0)
+		{
+			throw std::string("DistributedDVC::compute() should be called by the coordinator");
+		}
+
+		double start_time = omp_get_wtime();
+		report = DistributedReport();
+		report.worker_number = transport.getSize() - 1;
+
+		int dimension[3], tar_dimension[3];
+		Image3D::getBinDimension(ref_path, dimension[0], dimension[1], dimension[2]);
+		Image3D::getBinDimension(tar_path, tar_dimension[0], tar_dimension[1], tar_dimension[2]);
+		if (dimension[0] != tar_dimension[0] || dimension[1] != tar_dimension[1] || dimension[2] != tar_dimension[2])
+		{
+			throw std::string("Dimensions of reference and target volumes are different");
+		}
+		report.volume_voxels = (long long)dimension[0] * dimension[1] * dimension[2];
+
+		std::vector<long long> poi_index(poi_queue.size());
+		std::iota(poi_index.begin(), poi_index.end(), 0LL);
+		std::vector<VolumeBlock> blocks = partition(poi_queue, poi_index, dimension);
+		report.block_number = (int)blocks.size();
+		runBlocks(transport, blocks, poi_queue, ref_path, tar_path);
+
+		for (int round = 0; round < exchange_rounds; round++)
+		{
+			std::vector<Point3D> good_location;
+			std::vector<long long> good_index, bad_index;
+			for (long long i = 0; i < (long long)poi_queue.size(); i++)
+			{
+				if (poi_queue[i].result.zncc >= seed_threshold)
+				{
+					good_location.push_back((Point3D)poi_queue[i]);
+					good_index.push_back(i);
+				}
+				else
+				{
+					bad_index.push_back(i);
+				}
+			}
+			if (good_index.empty() || bad_index.empty())
+			{
+				break;
+			}
+
+			//the seeds may come from the POIs in neighboring blocks, the current results are kept unless improved
+			NearestNeighbor nearest_neighbor;
+			nearest_neighbor.assignPoints(good_location);
+			nearest_neighbor.constructKdTree();
+
+			std::vector<POI3D> seeded_queue;
+			seeded_queue.reserve(bad_index.size());
+			std::vector<uint32_t> neighbor_index;
+			std::vector<float> squared_distance;
+			for (auto& index : bad_index)
+			{
+				POI3D poi = poi_queue[index];
+				nearest_neighbor.knnSearch((Point3D)poi, 1, neighbor_index, squared_distance);
+				POI3D& seed = poi_queue[good_index[neighbor_index[0]]];
+				poi.clear();
+				poi.deformation.u = seed.deformation.u;
+				poi.deformation.v = seed.deformation.v;
+				poi.deformation.w = seed.deformation.w;
+				seeded_queue.push_back(poi);
+			}
+
+			std::vector<long long> seeded_index(seeded_queue.size());
+			std::iota(seeded_index.begin(), seeded_index.end(), 0LL);
+			blocks = partition(seeded_queue, seeded_index, dimension);
+			runBlocks(transport, blocks, seeded_queue, ref_path, tar_path);
+
+			long long recovered_number = 0;
+			for (size_t i = 0; i < bad_index.size(); i++)
+			{
+				POI3D& poi = poi_queue[bad_index[i]];
+				if (seeded_queue[i].result.zncc > poi.result.zncc)
+				{
+					poi = seeded_queue[i];
+				}
+				if (poi.result.zncc >= seed_threshold)
+				{
+					recovered_number++;
+				}
+			}
+			report.reseeded_pois += (long long)bad_index.size();
+			report.recovered_pois += recovered_number;
+			if (recovered_number == 0)
+			{
+				break;
+			}
+		}
+
+		report.wall_time = omp_get_wtime() - start_time;
+	}
+
+	void DistributedDVC::stop(Transport& transport)
+	{
+		std::vector<char> message;
+		pack(message, (int32_t)MESSAGE_STOP);
+		for (int worker = 1; worker < transport.getSize(); worker++)
+		{
+			transport.send(worker, message);
+		}
+	}
+
+	void DistributedDVC::serve(Transport& transport)
+	{
+		if (transport.getRank() == 0)
+		{
+			throw std::string("DistributedDVC::serve() should be called by the workers");
+		}
+
+		std::vector<char> message, result;
+		while (transport.receive(0, message))
+		{
+			size_t offset = 0;
+			if (unpack<int32_t>(message, offset) == MESSAGE_STOP)
+			{
+				break;
+			}
+
+			//the errors are passed to the coordinator, which throws them in compute()
+			std::string error;
+			try
+			{
+				processBlock(message, result);
+			}
+			catch (std::string& text)
+			{
+				error = text;
+			}
+			catch (std::exception& exception)
+			{
+				error = exception.what();
+			}
+
+			if (!error.empty())
+			{
+				result.clear();
+				pack(result, (int32_t)MESSAGE_ERROR);
+				packString(result, "Worker " + std::to_string(transport.getRank()) + ": " + error);
+			}
+			transport.send(0, result);
+		}
+	}
+
+}//namespace opencorr
@@ -0,0 +1,141 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _DISTRIBUTED_H_
+#define _DISTRIBUTED_H_
+
+#include <string>
+#include <vector>
+
+#include "oc_fftcc.h"
+#include "oc_icgn.h"
+#include "oc_image.h"
+#include "oc_poi.h"
+
+namespace opencorr
+{
+	//links between the processes of a distributed job, the coordinator has rank 0 and the workers rank 1 to size - 1.
+	//Messages between two ranks are delivered in order. A transport over sockets or MPI can be plugged in by
+	//implementing this interface, only the links between the coordinator and each worker are used
+	class Transport
+	{
+	public:
+		virtual ~Transport() = default;
+
+		virtual int getRank() const = 0;
+		virtual int getSize() const = 0;
+
+		virtual void send(int rank, const std::vector<char>& message) = 0;
+		virtual bool receive(int rank, std::vector<char>& message) = 0; //block until a message arrives, false if the link is closed
+	};
+
+	//worker processes forked on the local machine, linked to the coordinator by a pair of pipes each. It serves
+	//workstations and the test of distributed jobs, and is not available on Windows
+	class PipeTransport : public Transport
+	{
+	private:
+		int rank, size;
+		std::vector<int> read_fd, write_fd; //pipes to each rank, -1 if not linked
+		std::vector<int> worker_pid; //kept by the coordinator
+
+	public:
+		PipeTransport(); //a single process, i.e. the coordinator without worker
+		~PipeTransport();
+
+		//fork worker_number processes, returning in the coordinator and in each worker with its own rank. Call it
+		//before any OpenMP region, since the threads of the runtime are not inherited by the children
+		void spawn(int worker_number);
+		void close(); //the workers find the links closed, the coordinator then waits for their exit
+
+		int getRank() const;
+		int getSize() const;
+
+		void send(int rank, const std::vector<char>& message);
+		bool receive(int rank, std::vector<char>& message);
+	};
+
+	//a block of volume processed by one process
+	struct VolumeBlock
+	{
+		int load_begin[3], load_end[3]; //region loaded from the bin files, covering the POIs and their halo
+		std::vector<long long> poi_index; //POIs of the block, as indices in the queue
+	};
+
+	struct DistributedReport
+	{
+		int worker_number = 0;
+		int block_number = 0; //blocks of the first pass
+		long long volume_voxels = 0; //voxels of an image
+		long long loaded_voxels = 0; //voxels of an image loaded by all the processes in all the passes
+		long long reseeded_pois = 0; //POIs computed again with the seeds taken from their neighbors
+		long long recovered_pois = 0; //reseeded POIs reaching the ZNCC threshold
+		double wall_time = 0; //in seconds
+	};
+
+	//domain-decomposed DVC for volumes exceeding the memory of a node. The volume is divided into a grid of blocks,
+	//and each block of POIs is processed by FFTCC3D and ICGN3D1 on the region of bin files covering the POIs and
+	//a halo of subset radius plus expected displacement, thus no process holds the whole volume. The coordinator
+	//sends the blocks to the workers and keeps one for itself in each round. Afterwards, the POIs below the ZNCC
+	//threshold take the displacement of their nearest good neighbor as initial guess, which may come from another
+	//block, and are computed again. The results are merged into the queue of POIs in the coordinator
+	class DistributedDVC
+	{
+	protected:
+		int subset_radius_x, subset_radius_y, subset_radius_z;
+		float conv_criterion, stop_condition;
+		int thread_number; //OpenMP threads of the engines in this process
+		int block_number_x, block_number_y, block_number_z;
+		float expected_displacement; //in voxels, subset radius by default, i.e. the search range of FFT-CC
+		float seed_threshold; //POIs below this ZNCC are reseeded from their neighbors
+		int exchange_rounds; //rounds of reseeding, 0 disables it
+
+		DistributedReport report;
+
+		std::vector<VolumeBlock> partition(std::vector<POI3D>& poi_queue, std::vector<long long>& poi_index, int dimension[3]) const;
+		void encodeBlock(VolumeBlock& block, std::vector<POI3D>& poi_queue, std::string& ref_path, std::string& tar_path,
+			std::vector<char>& message) const;
+		void processBlock(const std::vector<char>& message, std::vector<char>& result); //load the block and run FFTCC3D and ICGN3D1
+		void mergeResult(const std::vector<char>& result, std::vector<POI3D>& poi_queue) const;
+		void runBlocks(Transport& transport, std::vector<VolumeBlock>& blocks, std::vector<POI3D>& poi_queue,
+			std::string& ref_path, std::string& tar_path);
+
+	public:
+		//voxels loaded beyond the subsets and the expected displacement: 7 reached by the B-spline prefilter, so that the
+		//coefficients near a subset are the same as those of the whole volume, 2 by the cubic B-spline basis, and 2 by
+		//the gradient of reference volume
+		static const int HALO_BORDER = 11;
+
+		DistributedDVC(int subset_radius_x, int subset_radius_y, int subset_radius_z,
+			float conv_criterion, float stop_condition, int thread_number);
+		~DistributedDVC() = default;
+
+		void setBlocks(int block_number_x, int block_number_y, int block_number_z); //grid of blocks, 2 x 2 x 2 by default
+		void setExpectedDisplacement(float expected_displacement);
+		void setSeedExchange(float seed_threshold, int exchange_rounds); //0.8 and 1 by default
+
+		//called by the coordinator, the initial guess of POIs is taken as the center of FFT-CC search
+		void compute(Transport& transport, std::string ref_path, std::string tar_path, std::vector<POI3D>& poi_queue);
+		void stop(Transport& transport); //called by the coordinator to release the workers
+
+		//called by the workers, process blocks until stop() is called or the link is closed
+		void serve(Transport& transport);
+
+		DistributedReport getReport() const; //valid after compute()
+	};
+
+}//namespace opencorr
+
+#endif //_DISTRIBUTED_H_
@@ -0,0 +1,339 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include "oc_epipolar_icgn.h"
+
+namespace opencorr
+{
+	EpipolarICGN2D1_* EpipolarICGN2D1_::allocate(int subset_radius_x, int subset_radius_y)
+	{
+		int subset_width = 2 * subset_radius_x + 1;
+		int subset_height = 2 * subset_radius_y + 1;
+		Point2D subset_center(0, 0);
+
+		EpipolarICGN2D1_* ICGN_instance = new EpipolarICGN2D1_;
+		ICGN_instance->ref_subset = new Subset2D(subset_center, subset_radius_x, subset_radius_y);
+		ICGN_instance->tar_subset = new Subset2D(subset_center, subset_radius_x, subset_radius_y);
+		ICGN_instance->error_img = Eigen::MatrixXf::Zero(subset_height, subset_width);
+		ICGN_instance->sd_img = new3D(subset_height, subset_width, 5);
+		ICGN_instance->ref_mean_norm = 0.f;
+		ICGN_instance->epipolar_line.setZero();
+
+		return ICGN_instance;
+	}
+
+	void EpipolarICGN2D1_::release(EpipolarICGN2D1_* instance)
+	{
+		delete3D(instance->sd_img);
+		delete instance->ref_subset;
+		delete instance->tar_subset;
+	}
+
+	EpipolarICGN2D1_* EpipolarICGN2D1::getInstance()
+	{
+		return workspace.local();
+	}
+
+	EpipolarICGN2D1::EpipolarICGN2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number)
+		: tar_interp(nullptr), ref_gradient(nullptr),
+		workspace([this] { return EpipolarICGN2D1_::allocate(this->subset_radius_x, this->subset_radius_y); },
+			[](EpipolarICGN2D1_* instance)
+			{
+				EpipolarICGN2D1_::release(instance);
+				delete instance;
+			})
+	{
+		this->subset_radius_x = subset_radius_x;
+		this->subset_radius_y = subset_radius_y;
+		this->conv_criterion = conv_criterion;
+		this->stop_condition = stop_condition;
+		this->thread_number = thread_number;
+		fundamental_matrix.setZero();
+	}
+
+	EpipolarICGN2D1::~EpipolarICGN2D1()
+	{
+		delete ref_gradient;
+		delete tar_interp;
+	}
+
+	void EpipolarICGN2D1::setFundamentalMatrix(Eigen::Matrix3f& fundamental_matrix)
+	{
+		this->fundamental_matrix = fundamental_matrix;
+	}
+
+	void EpipolarICGN2D1::setIteration(float conv_criterion, float stop_condition)
+	{
+		this->conv_criterion = conv_criterion;
+		this->stop_condition = stop_condition;
+	}
+
+	void EpipolarICGN2D1::setIteration(POI2D* poi)
+	{
+		conv_criterion = poi->result.convergence;
+		stop_condition = (int)poi->result.iteration;
+	}
+
+	void EpipolarICGN2D1::prepareRef()
+	{
+		if (ref_gradient != nullptr)
+		{
+			delete ref_gradient;
+			ref_gradient = nullptr;
+		}
+
+		ref_gradient = new Gradient2D4(*ref_img);
+		ref_gradient->getGradientX();
+		ref_gradient->getGradientY();
+	}
+
+	void EpipolarICGN2D1::prepareTar()
+	{
+		if (tar_interp != nullptr)
+		{
+			delete tar_interp;
+			tar_interp = nullptr;
+		}
+
+		tar_interp = new BicubicBspline(*tar_img);
+		tar_interp->prepare();
+	}
+
+	void EpipolarICGN2D1::prepare()
+	{
+		if (fundamental_matrix.isZero())
+		{
+			throw std::string("Fundamental matrix is not set");
+		}
+
+		prepareRef();
+		prepareTar();
+	}
+
+	bool EpipolarICGN2D1::setEpipolarLine(EpipolarICGN2D1_* instance, POI2D* poi)
+	{
+		Eigen::Vector3f view1_vector(poi->x, poi->y, 1.f);
+		Eigen::Vector3f view2_epipolar = fundamental_matrix * view1_vector;
+
+		float line_norm = sqrt(view2_epipolar(0) * view2_epipolar(0) + view2_epipolar(1) * view2_epipolar(1));
+		if (line_norm == 0.f || std::isnan(line_norm))
+		{
+			return false;
+		}
+
+		instance->epipolar_line = view2_epipolar / line_norm;
+		return true;
+	}
+
+	void EpipolarICGN2D1::projectOnLine(EpipolarICGN2D1_* instance, POI2D* poi, float& u, float& v)
+	{
+		//signed distance from the subset center in view2 to the epipolar line
+		float distance = instance->epipolar_line(0) * (poi->x + u) + instance->epipolar_line(1) * (poi->y + v) + instance->epipolar_line(2);
+		u -= distance * instance->epipolar_line(0);
+		v -= distance * instance->epipolar_line(1);
+	}
+
+	void EpipolarICGN2D1::setRefSubset(EpipolarICGN2D1_* instance, POI2D* poi)
+	{
+		int subset_width = 2 * subset_radius_x + 1;
+		int subset_height = 2 * subset_radius_y + 1;
+
+		//direction of epipolar line
+		float direction_x = instance->epipolar_line(1);
+		float direction_y = -instance->epipolar_line(0);
+
+		//set reference subset
+		instance->ref_subset->center = (Point2D)*poi;
+		instance->ref_subset->fill(ref_img);
+		instance->ref_mean_norm = instance->ref_subset->zeroMeanNorm();
+
+		//build the Hessian matrix
+		instance->hessian.setZero();
+		for (int r = 0; r < subset_height; r++)
+		{
+			for (int c = 0; c < subset_width; c++)
+			{
+				int x_local = c - subset_radius_x;
+				int y_local = r - subset_radius_y;
+				int x_global = (int)poi->x + x_local;
+				int y_global = (int)poi->y + y_local;
+				float ref_gradient_x = ref_gradient->gradient_x(y_global, x_global);
+				float ref_gradient_y = ref_gradient->gradient_y(y_global, x_global);
+
+				instance->sd_img[r][c][0] = ref_gradient_x * direction_x + ref_gradient_y * direction_y;
+				instance->sd_img[r][c][1] = ref_gradient_x * x_local;
+				instance->sd_img[r][c][2] = ref_gradient_x * y_local;
+				instance->sd_img[r][c][3] = ref_gradient_y * x_local;
+				instance->sd_img[r][c][4] = ref_gradient_y * y_local;
+
+				for (int i = 0; i < 5; i++)
+				{
+					for (int j = 0; j < 5; j++)
+					{
+						instance->hessian(i, j) += (instance->sd_img[r][c][i] * instance->sd_img[r][c][j]);
+					}
+				}
+			}
+		}
+
+		//calculate the inversed Hessian matrix
+		instance->inv_hessian = instance->hessian.inverse();
+	}
+
+	void EpipolarICGN2D1::compute(POI2D* poi)
+	{
+		//set instance w.r.t. thread id
+		EpipolarICGN2D1_* cur_instance = getInstance();
+
+		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
+			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1
+			|| fabs(poi->deformation.u) >= ref_img->width || fabs(poi->deformation.v) >= ref_img->height
+			|| poi->result.zncc < 0 || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v)
+			|| !setEpipolarLine(cur_instance, poi))
+		{
+			poi->result.zncc = poi->result.zncc < -1 ? poi->result.zncc : -1;
+		}
+		else
+		{
+			int subset_width = 2 * subset_radius_x + 1;
+			int subset_height = 2 * subset_radius_y + 1;
+
+			setRefSubset(cur_instance, poi);
+			float ref_mean_norm = cur_instance->ref_mean_norm;
+			float direction_x = cur_instance->epipolar_line(1);
+			float direction_y = -cur_instance->epipolar_line(0);
+
+			//set target subset
+			cur_instance->tar_subset->center = (Point2D)*poi;
+
+			//get initial guess, its translation is moved onto the epipolar line
+			float u_initial = poi->deformation.u;
+			float v_initial = poi->deformation.v;
+			projectOnLine(cur_instance, poi, u_initial, v_initial);
+			Deformation2D1 p_initial(u_initial, poi->deformation.ux, poi->deformation.uy,
+				v_initial, poi->deformation.vx, poi->deformation.vy);
+
+			//IC-GN iteration
+			int iteration_counter = 0; //initialize iteration counter
+			Deformation2D1 p_current, p_increment;
+			p_current.setDeformation(p_initial);
+			float dp_norm_max = 0.f, znssd;
+			Point2D local_coor, warped_coor, global_coor;
+			do
+			{
+				iteration_counter++;
+				//reconstruct target subset
+				for (int r = 0; r < subset_height; r++)
+				{
+					for (int c = 0; c < subset_width; c++)
+					{
+						int x_local = c - subset_radius_x;
+						int y_local = r - subset_radius_y;
+						local_coor.x = x_local;
+						local_coor.y = y_local;
+						warped_coor = p_current.warp(local_coor);
+						global_coor = cur_instance->tar_subset->center + warped_coor;
+						cur_instance->tar_subset->eg_mat(r, c) = tar_interp->compute(global_coor);
+					}
+				}
+				float tar_mean_norm = cur_instance->tar_subset->zeroMeanNorm();
+
+				//calculate error image
+				cur_instance->error_img = cur_instance->tar_subset->eg_mat * (ref_mean_norm / tar_mean_norm)
+					- (cur_instance->ref_subset->eg_mat);
+
+				//calculate ZNSSD
+				znssd = cur_instance->error_img.squaredNorm() / (ref_mean_norm * ref_mean_norm);
+
+				//calculate numerator
+				float numerator[5] = { 0.f };
+				for (int r = 0; r < subset_height; r++)
+				{
+					for (int c = 0; c < subset_width; c++)
+					{
+						for (int i = 0; i < 5; i++)
+						{
+							numerator[i] += (cur_instance->sd_img[r][c][i] * cur_instance->error_img(r, c));
+						}
+					}
+				}
+
+				//calculate the reduced dp, then expand it to the 6 parameters of the 1st order shape function
+				float dp_reduced[5] = { 0.f };
+				for (int i = 0; i < 5; i++)
+				{
+					for (int j = 0; j < 5; j++)
+					{
+						dp_reduced[i] += (cur_instance->inv_hessian(i, j) * numerator[j]);
+					}
+				}
+				float dp[6] = { dp_reduced[0] * direction_x, dp_reduced[1], dp_reduced[2],
+					dp_reduced[0] * direction_y, dp_reduced[3], dp_reduced[4] };
+				p_increment.setDeformation(dp);
+
+				//update warp
+				p_current.warp_matrix = p_current.warp_matrix * p_increment.warp_matrix.inverse();
+
+				//update p, the composition may drift off the epipolar line slightly due to the change of gradients
+				p_current.setDeformation();
+				float u_current = p_current.u;
+				float v_current = p_current.v;
+				projectOnLine(cur_instance, poi, u_current, v_current);
+				p_current.setDeformation(u_current, p_current.ux, p_current.uy, v_current, p_current.vx, p_current.vy);
+
+				//check convergence
+				int subset_radius_x2 = subset_radius_x * subset_radius_x;
+				int subset_radius_y2 = subset_radius_y * subset_radius_y;
+
+				dp_norm_max = 0.f;
+				dp_norm_max += dp_reduced[0] * dp_reduced[0];
+				dp_norm_max += p_increment.ux * p_increment.ux * subset_radius_x2;
+				dp_norm_max += p_increment.uy * p_increment.uy * subset_radius_y2;
+				dp_norm_max += p_increment.vx * p_increment.vx * subset_radius_x2;
+				dp_norm_max += p_increment.vy * p_increment.vy * subset_radius_y2;
+
+				dp_norm_max = sqrt(dp_norm_max);
+			} while (iteration_counter < stop_condition && dp_norm_max >= conv_criterion);
+
+			//store the final result
+			poi->deformation.u = p_current.u;
+			poi->deformation.ux = p_current.ux;
+			poi->deformation.uy = p_current.uy;
+			poi->deformation.v = p_current.v;
+			poi->deformation.vx = p_current.vx;
+			poi->deformation.vy = p_current.vy;
+
+			//save the parameters for output
+			poi->result.u0 = p_initial.u;
+			poi->result.v0 = p_initial.v;
+			poi->result.zncc = 0.5f * (2 - znssd);
+			poi->result.iteration = (float)iteration_counter;
+			poi->result.convergence = dp_norm_max;
+		}
+
+		//check if the case of NaN occurs for ZNCC or displacments
+		if (std::isnan(poi->result.zncc) || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v))
+		{
+			poi->deformation.u = poi->result.u0;
+			poi->deformation.v = poi->result.v0;
+			poi->result.zncc = -5;
+		}
+	}
+
+	void EpipolarICGN2D1::compute(std::vector<POI2D>& poi_queue)
+	{
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
+	}
+
+}//namespace opencorr
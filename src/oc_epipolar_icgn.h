@@ -0,0 +1,91 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _EPIPOLAR_ICGN_H_
+#define _EPIPOLAR_ICGN_H_
+
+#include "oc_array.h"
+#include "oc_cubic_bspline.h"
+#include "oc_dic.h"
+#include "oc_gradient.h"
+#include "oc_image.h"
+#include "oc_interpolation.h"
+#include "oc_poi.h"
+#include "oc_point.h"
+#include "oc_subset.h"
+#include "oc_workspace.h"
+
+namespace opencorr
+{
+	//IC-GN with the 1st order shape function for the matching between the two views of a stereovision system,
+	//the translation of subset is constrained on the epipolar line given by the fundamental matrix,
+	//thus the increment of deformation consists of 5 parameters: ds along the epipolar line, ux, uy, vx, vy
+
+	typedef Eigen::Matrix<float, 5, 5> Matrix5f;
+
+	class EpipolarICGN2D1_
+	{
+	public:
+		Subset2D* ref_subset;
+		Subset2D* tar_subset;
+		Eigen::MatrixXf error_img;
+		Matrix5f hessian, inv_hessian;
+		float*** sd_img; //steepest descent image
+		float ref_mean_norm; //zero-mean norm of reference subset
+		Eigen::Vector3f epipolar_line; //epipolar line in view2 with (a, b) normalized, a * x + b * y + c = 0
+
+		static EpipolarICGN2D1_* allocate(int subset_radius_x, int subset_radius_y);
+		static void release(EpipolarICGN2D1_* instance);
+	};
+
+	class EpipolarICGN2D1 : public DIC
+	{
+	private:
+		Interpolation2D* tar_interp; //interpolation for generating target subset during iteration
+		Gradient2D4* ref_gradient; //gradient for calculating Hessian matrix of reference subset
+		Eigen::Matrix3f fundamental_matrix; //maps a point in view1 (ref image) to its epipolar line in view2 (tar image)
+
+		float conv_criterion; //convergence criterion: norm of maximum deformation increment in subset
+		float stop_condition; //stop condition: max iteration
+
+		Workspace<EpipolarICGN2D1_> workspace; //instances of the threads running this engine
+		EpipolarICGN2D1_* getInstance(); //instance of calling thread
+
+		bool setEpipolarLine(EpipolarICGN2D1_* instance, POI2D* poi); //return false if the line is degenerated
+		void setRefSubset(EpipolarICGN2D1_* instance, POI2D* poi); //fill reference subset and build the inversed Hessian matrix
+		void projectOnLine(EpipolarICGN2D1_* instance, POI2D* poi, float& u, float& v); //move the subset center onto the epipolar line
+
+	public:
+		EpipolarICGN2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number);
+		~EpipolarICGN2D1();
+
+		//the fundamental matrix can be obtained from EpipolarSearch::getFundamentalMatrix(),
+		//for the images rectified by Stereorectification, it is [0, 0, 0; 0, 0, -1; 0, 1, 0]
+		void setFundamentalMatrix(Eigen::Matrix3f& fundamental_matrix);
+		void setIteration(float conv_criterion, float stop_condition);
+		void setIteration(POI2D* poi);
+
+		void prepareRef(); //calculate gradient maps of ref image
+		void prepareTar(); //calculate interpolation coefficient look_up table of tar image
+		void prepare(); //calculate gradient maps of ref image and interpolation coefficient look_up table of tar image
+
+		void compute(POI2D* poi);
+		void compute(std::vector<POI2D>& poi_queue);
+	};
+
+}//namespace opencorr
+
+#endif //_EPIPOLAR_ICGN_H_
@@ -21,6 +21,13 @@ namespace opencorr
 		this->view1_cam = view1_cam;
 		this->view2_cam = view2_cam;
 		this->thread_number = thread_number;
+		candidate_parallel = false;
+		prune_zncc = -1.f;
+		scan_candidates = 0;
+		row_aligned = false;
+		tracking = false;
+		track_zncc = 0.8f;
+		fallback_number = 0;
 	}
 
 	EpipolarSearch::~EpipolarSearch()
@@ -49,6 +56,69 @@ namespace opencorr
 		this->search_step = search_step;
 	}
 
+	bool EpipolarSearch::getCandidateParallel() const
+	{
+		return candidate_parallel;
+	}
+
+	void EpipolarSearch::setCandidateParallel(bool candidate_parallel)
+	{
+		this->candidate_parallel = candidate_parallel;
+	}
+
+	float EpipolarSearch::getPruning() const
+	{
+		return prune_zncc;
+	}
+
+	void EpipolarSearch::setPruning(float prune_zncc)
+	{
+		this->prune_zncc = prune_zncc;
+	}
+
+	int EpipolarSearch::getScan() const
+	{
+		return scan_candidates;
+	}
+
+	void EpipolarSearch::setScan(int scan_candidates)
+	{
+		this->scan_candidates = scan_candidates;
+	}
+
+	bool EpipolarSearch::getRowAligned() const
+	{
+		return row_aligned;
+	}
+
+	void EpipolarSearch::setRowAligned(bool row_aligned)
+	{
+		this->row_aligned = row_aligned;
+	}
+
+	bool EpipolarSearch::getTracking() const
+	{
+		return tracking;
+	}
+
+	void EpipolarSearch::setTracking(bool tracking, float track_zncc)
+	{
+		this->tracking = tracking;
+		this->track_zncc = track_zncc;
+	}
+
+	void EpipolarSearch::resetTracking()
+	{
+		track_queue.clear();
+		track_motion.clear();
+		fallback_number = 0;
+	}
+
+	int EpipolarSearch::getFallback() const
+	{
+		return fallback_number;
+	}
+
 	void EpipolarSearch::createICGN(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition)
 	{
 		icgn1 = new ICGN2D1(subset_radius_x, subset_radius_y, conv_criterion, stop_condition, thread_number);
@@ -118,6 +188,11 @@ namespace opencorr
 		fundamental_matrix = right_invK_t * right_E * left_K;
 	}
 
+	Eigen::Matrix3f EpipolarSearch::getFundamentalMatrix() const
+	{
+		return fundamental_matrix;
+	}
+
 	void EpipolarSearch::prepare()
 	{
 		view1_cam.updateMatrices();
@@ -126,81 +201,351 @@ namespace opencorr
 		updateFundementalMatrix();
 
 		prepareICGN();
+
+		if (scan_candidates > 0)
+		{
+			tar_sum.resize(0, 0);
+			prepareScan();
+		}
+	}
+
+	void EpipolarSearch::prepareScan()
+	{
+		int height = tar_img->height;
+		int width = tar_img->width;
+		if (tar_sum.rows() == height + 1 && tar_sum.cols() == width + 1)
+		{
+			return;
+		}
+
+		//integral images of target image for the normalization in integer-pixel scan
+		tar_sum = Eigen::MatrixXd::Zero(height + 1, width + 1);
+		tar_sqsum = Eigen::MatrixXd::Zero(height + 1, width + 1);
+		for (int c = 0; c < width; c++)
+		{
+			for (int r = 0; r < height; r++)
+			{
+				double value = tar_img->eg_mat(r, c);
+				tar_sum(r + 1, c + 1) = value + tar_sum(r, c + 1) + tar_sum(r + 1, c) - tar_sum(r, c);
+				tar_sqsum(r + 1, c + 1) = value * value + tar_sqsum(r, c + 1) + tar_sqsum(r + 1, c) - tar_sqsum(r, c);
+			}
+		}
+	}
+
+	void EpipolarSearch::scanEpipolar(POI2D* poi, int x_center, float line_slope, float line_intercept, std::vector<int>& selected_x)
+	{
+		if (tar_sum.rows() != tar_img->height + 1 || tar_sum.cols() != tar_img->width + 1)
+		{
+			throw std::string("Integral images of target image are not prepared");
+		}
+
+		int subset_radius_x = icgn1->subset_radius_x;
+		int subset_radius_y = icgn1->subset_radius_y;
+		int subset_width = 2 * subset_radius_x + 1;
+		int subset_height = 2 * subset_radius_y + 1;
+		double subset_size = (double)subset_width * subset_height;
+
+		//zero-mean reference subset, the mean of target subset is thus not needed in the dot product
+		Eigen::MatrixXf ref_subset = ref_img->eg_mat.block((int)poi->y - subset_radius_y, (int)poi->x - subset_radius_x, subset_height, subset_width);
+		ref_subset.array() -= ref_subset.mean();
+		float ref_norm = ref_subset.norm();
+
+		//ZNCC at each integer location on epipolar line within searching region
+		std::vector<std::pair<float, int>> scan_zncc;
+		scan_zncc.reserve(2 * search_radius);
+		for (int x_trial = x_center - search_radius + 1; x_trial < x_center + search_radius; x_trial++)
+		{
+			int y_trial = (int)(line_slope * x_trial + line_intercept);
+			int x_topleft = x_trial - subset_radius_x;
+			int y_topleft = y_trial - subset_radius_y;
+			if (x_topleft <= 0 || x_trial + subset_radius_x >= tar_img->width - 1
+				|| y_topleft <= 0 || y_trial + subset_radius_y >= tar_img->height - 1)
+			{
+				continue;
+			}
+
+			//sum and squared sum of target subset read from the integral images
+			int x_bottomright = x_topleft + subset_width;
+			int y_bottomright = y_topleft + subset_height;
+			double tar_subset_sum = tar_sum(y_bottomright, x_bottomright) - tar_sum(y_topleft, x_bottomright)
+				- tar_sum(y_bottomright, x_topleft) + tar_sum(y_topleft, x_topleft);
+			double tar_subset_sqsum = tar_sqsum(y_bottomright, x_bottomright) - tar_sqsum(y_topleft, x_bottomright)
+				- tar_sqsum(y_bottomright, x_topleft) + tar_sqsum(y_topleft, x_topleft);
+			double tar_variance = tar_subset_sqsum - tar_subset_sum * tar_subset_sum / subset_size;
+			if (tar_variance <= 0)
+			{
+				continue;
+			}
+
+			float numerator = ref_subset.cwiseProduct(tar_img->eg_mat.block(y_topleft, x_topleft, subset_height, subset_width)).sum();
+			scan_zncc.push_back(std::make_pair(numerator / (ref_norm * (float)sqrt(tar_variance)), x_trial));
+		}
+
+		//select the locations with the highest ZNCC, which are separated by at least one searching step
+		std::sort(scan_zncc.begin(), scan_zncc.end(),
+			[](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+
+		selected_x.clear();
+		for (auto& location : scan_zncc)
+		{
+			if ((int)selected_x.size() >= scan_candidates)
+			{
+				break;
+			}
+
+			bool isolated = true;
+			for (auto& x_selected : selected_x)
+			{
+				if (abs(location.second - x_selected) < search_step)
+				{
+					isolated = false;
+					break;
+				}
+			}
+
+			if (isolated)
+			{
+				selected_x.push_back(location.second);
+			}
+		}
+	}
+
+	bool EpipolarSearch::track(POI2D* poi, POI2D* previous, Point2D& previous_motion)
+	{
+		if (previous->result.zncc < track_zncc)
+		{
+			return false;
+		}
+
+		//location of POI in view1 at current frame
+		float x_view1 = poi->x + poi->deformation.u;
+		float y_view1 = poi->y + poi->deformation.v;
+
+		//the counterpart in view2 moves with the POI in view1, i.e. the displacement between views is kept
+		float x_view2 = poi->x + previous->deformation.u + (poi->deformation.u - previous_motion.x);
+		float y_view2 = poi->y + previous->deformation.v + (poi->deformation.v - previous_motion.y);
+
+		//move the seed onto the epipolar line of POI
+		if (row_aligned)
+		{
+			y_view2 = y_view1;
+		}
+		else
+		{
+			Eigen::Vector3f view1_vector(x_view1, y_view1, 1.f);
+			Eigen::Vector3f view2_epipolar = fundamental_matrix * view1_vector;
+			float line_norm2 = view2_epipolar(0) * view2_epipolar(0) + view2_epipolar(1) * view2_epipolar(1);
+			if (line_norm2 > 0)
+			{
+				float distance = (view2_epipolar(0) * x_view2 + view2_epipolar(1) * y_view2 + view2_epipolar(2)) / line_norm2;
+				x_view2 -= distance * view2_epipolar(0);
+				y_view2 -= distance * view2_epipolar(1);
+			}
+		}
+
+		POI2D candidate(poi->x, poi->y);
+		candidate.deformation = previous->deformation;
+		candidate.deformation.u = x_view2 - poi->x;
+		candidate.deformation.v = y_view2 - poi->y;
+		icgn1->compute(&candidate);
+
+		if (candidate.result.zncc < track_zncc)
+		{
+			return false;
+		}
+
+		poi->deformation = candidate.deformation;
+		poi->result = candidate.result;
+		return true;
 	}
 
 	void EpipolarSearch::compute(POI2D* poi)
 	{
-		//estimate parallax
-		parallax.x = parallax_x[0] * (poi->x - int(ref_img->width / 2)) + parallax_x[1] * (poi->y - int(ref_img->height / 2)) + parallax_x[2];
-		parallax.y = parallax_y[0] * (poi->x - int(ref_img->width / 2)) + parallax_y[1] * (poi->y - int(ref_img->height / 2)) + parallax_y[2];
+		//estimate parallax, a local copy is used as POIs are processed in parallel
+		Point2D poi_parallax;
+		poi_parallax.x = parallax_x[0] * (poi->x - int(ref_img->width / 2)) + parallax_x[1] * (poi->y - int(ref_img->height / 2)) + parallax_x[2];
+		poi_parallax.y = parallax_y[0] * (poi->x - int(ref_img->width / 2)) + parallax_y[1] * (poi->y - int(ref_img->height / 2)) + parallax_y[2];
 
 		//convert locatoin of left POI to a vector
 		Eigen::Vector3f view1_vector;
 		view1_vector << (poi->x + poi->deformation.u), (poi->y + poi->deformation.v), 1;
 
-		//get the projection of POI in the primary view on the epipolar line in the secondary view
-		Eigen::Vector3f view2_epipolar = fundamental_matrix * view1_vector;
-		float line_slope = -view2_epipolar(0) / view2_epipolar(1);
-		float line_intercept = -view2_epipolar(2) / view2_epipolar(1);
-		int x_view2 = (int)((line_slope * (poi->y + poi->deformation.v + parallax.y - line_intercept)
-			+ poi->x + poi->deformation.u + parallax.x) / (line_slope * line_slope + 1));
+		//get the projection of POI in the primary view on the epipolar line in the secondary view,
+		//which is the same row in a pair of rectified views
+		float line_slope = 0.f;
+		float line_intercept = poi->y + poi->deformation.v;
+		if (!row_aligned)
+		{
+			Eigen::Vector3f view2_epipolar = fundamental_matrix * view1_vector;
+			line_slope = -view2_epipolar(0) / view2_epipolar(1);
+			line_intercept = -view2_epipolar(2) / view2_epipolar(1);
+		}
+		int x_view2 = (int)((line_slope * (poi->y + poi->deformation.v + poi_parallax.y - line_intercept)
+			+ poi->x + poi->deformation.u + poi_parallax.x) / (line_slope * line_slope + 1));
 		int y_view2 = (int)(line_slope * x_view2 + line_intercept);
 
-		//get the center of searching region
-		std::vector<POI2D> poi_candidates;
-		POI2D current_poi(poi->x, poi->y);
-		current_poi.deformation.u = x_view2 - poi->x;
-		current_poi.deformation.v = y_view2 - poi->y;
-		poi_candidates.push_back(current_poi);
-
-		//get the other trial locations in searching region
-		int x_trial, y_trial;
-		for (int i = search_step; i < search_radius; i += search_step) {
-			x_trial = x_view2 + i;
-			y_trial = (int)(line_slope * x_trial + line_intercept);
-			current_poi.deformation.u = x_trial - poi->x;
-			current_poi.deformation.v = y_trial - poi->y;
-			if (x_trial - icgn1->subset_radius_x > 0 && x_trial + icgn1->subset_radius_x < icgn1->ref_img->width - 1
-				&& y_trial - icgn1->subset_radius_y > 0 && y_trial + icgn1->subset_radius_y < icgn1->ref_img->height - 1)
-			{
-				poi_candidates.push_back(current_poi);
-			}
+		//the center of searching region is the first candidate
+		POI2D best_candidate(poi->x, poi->y);
+		best_candidate.deformation.u = x_view2 - poi->x;
+		best_candidate.deformation.v = y_view2 - poi->y;
+		int best_index = -1;
 
-			x_trial = x_view2 - i;
-			y_trial = (int)(line_slope * x_trial + line_intercept);
-			current_poi.deformation.u = x_trial - poi->x;
-			current_poi.deformation.v = y_trial - poi->y;
-			if (x_trial - icgn1->subset_radius_x > 0 && x_trial + icgn1->subset_radius_x < icgn1->ref_img->width - 1
-				&& y_trial - icgn1->subset_radius_y > 0 && y_trial + icgn1->subset_radius_y < icgn1->ref_img->height - 1)
-			{
-				poi_candidates.push_back(current_poi);
-			}
+		//the reference subset is shared by all candidates, thus its Hessian matrix is built only once
+		if (!icgn1->prepareCandidates(poi))
+		{
+			poi->deformation = best_candidate.deformation;
+			poi->result.zncc = -1;
+			return;
 		}
 
-		//coarse check using ICGN1
-		int queue_size = (int)poi_candidates.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_size; i++)
+		//the other trial locations are taken alternately on the two sides of center,
+		//or selected by the integer-pixel scan along epipolar line if it is enabled
+		int trial_number = 2 * ((search_radius - 1) / search_step);
+		std::vector<int> scan_x;
+		if (scan_candidates > 0)
 		{
-			icgn1->compute(&poi_candidates[i]);
+			scanEpipolar(poi, x_view2, line_slope, line_intercept, scan_x);
+			trial_number = (int)scan_x.size();
+			best_candidate.result.zncc = -1;
+		}
+		else
+		{
+			icgn1->computeCandidate(&best_candidate, -1.f);
 		}
 
-		//take the one with the highest ZNCC value
-		std::sort(poi_candidates.begin(), poi_candidates.end(), sortByZNCC);
+		auto setTrial = [&](int trial_index, POI2D& candidate)
+		{
+			int x_trial = scan_candidates > 0 ? scan_x[trial_index]
+				: x_view2 + (trial_index % 2 == 0 ? 1 : -1) * (trial_index / 2 + 1) * search_step;
+			int y_trial = (int)(line_slope * x_trial + line_intercept);
+			candidate.deformation.u = x_trial - poi->x;
+			candidate.deformation.v = y_trial - poi->y;
+
+			return (x_trial - icgn1->subset_radius_x > 0 && x_trial + icgn1->subset_radius_x < icgn1->ref_img->width - 1
+				&& y_trial - icgn1->subset_radius_y > 0 && y_trial + icgn1->subset_radius_y < icgn1->ref_img->height - 1);
+		};
+
+		//coarse check using ICGN1, keep the candidate with the highest ZNCC value
+		if (!candidate_parallel)
+		{
+			POI2D current_candidate(poi->x, poi->y);
+			for (int i = 0; i < trial_number; i++)
+			{
+				current_candidate.clear();
+				if (setTrial(i, current_candidate))
+				{
+					icgn1->computeCandidate(&current_candidate, prune_zncc);
+					if (current_candidate.result.zncc > best_candidate.result.zncc)
+					{
+						best_candidate = current_candidate;
+						best_index = i;
+					}
+				}
+			}
+		}
+		else
+		{
+#pragma omp parallel
+			{
+				POI2D thread_best_candidate = best_candidate;
+				int thread_best_index = best_index;
+				POI2D current_candidate(poi->x, poi->y);
+				icgn1->prepareCandidates(poi);
+
+#pragma omp for nowait
+				for (int i = 0; i < trial_number; i++)
+				{
+					current_candidate.clear();
+					if (setTrial(i, current_candidate))
+					{
+						icgn1->computeCandidate(&current_candidate, prune_zncc);
+						if (current_candidate.result.zncc > thread_best_candidate.result.zncc)
+						{
+							thread_best_candidate = current_candidate;
+							thread_best_index = i;
+						}
+					}
+				}
+
+				//the candidate closer to the head of trial sequence wins a tie, same as the serial check
+#pragma omp critical
+				{
+					if (thread_best_candidate.result.zncc > best_candidate.result.zncc
+						|| (thread_best_candidate.result.zncc == best_candidate.result.zncc && thread_best_index < best_index))
+					{
+						best_candidate = thread_best_candidate;
+						best_index = thread_best_index;
+					}
+				}
+			}
+		}
 
-		poi->deformation = poi_candidates[0].deformation;
-		poi->deformation = poi_candidates[0].deformation;
-		poi->result = poi_candidates[0].result;
-		poi->result = poi_candidates[0].result;
+		poi->deformation = best_candidate.deformation;
+		poi->result = best_candidate.result;
 	}
 
 	void EpipolarSearch::compute(std::vector<POI2D>& poi_queue)
 	{
 		int queue_length = (int)poi_queue.size();
-		//CAUTION: no need to use omp parallel for, as the parallelism has been implemented in the processing of each poi
+
+		//the integral images are needed by the scan, an exception cannot leave the parallel region
+		if (scan_candidates > 0)
+		{
+			prepareScan();
+		}
+
+		//displacement of the POIs in view1, overwritten by the matches in view2
+		std::vector<Point2D> view1_motion(queue_length);
 		for (int i = 0; i < queue_length; i++)
 		{
-			compute(&poi_queue[i]);
+			view1_motion[i] = Point2D(poi_queue[i].deformation.u, poi_queue[i].deformation.v);
+		}
+
+		//track the POIs from last frame, only the failed ones are searched along epipolar line
+		std::vector<int> search_queue;
+		if (tracking && (int)track_queue.size() == queue_length)
+		{
+			std::vector<int> tracked(queue_length, 0);
+			scheduler.run(queue_length, [&](long long i)
+				{ tracked[i] = track(&poi_queue[i], &track_queue[i], track_motion[i]) ? 1 : 0; });
+
+			for (int i = 0; i < queue_length; i++)
+			{
+				if (tracked[i] == 0)
+				{
+					search_queue.push_back(i);
+				}
+			}
+		}
+		else
+		{
+			search_queue.resize(queue_length);
+			for (int i = 0; i < queue_length; i++)
+			{
+				search_queue[i] = i;
+			}
+		}
+
+		int search_length = (int)search_queue.size();
+		if (candidate_parallel)
+		{
+			//the parallelism is implemented in the processing of each POI
+			for (int i = 0; i < search_length; i++)
+			{
+				compute(&poi_queue[search_queue[i]]);
+			}
+		}
+		else
+		{
+			//the cost of POIs varies with the number of candidates within image and the iterations of ICGN1
+			scheduler.run(search_length, [&](long long i) { compute(&poi_queue[search_queue[i]]); });
+		}
+
+		if (tracking)
+		{
+			track_queue = poi_queue;
+			track_motion.swap(view1_motion);
+			fallback_number = search_length;
 		}
 	}
 
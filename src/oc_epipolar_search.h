@@ -41,6 +41,25 @@ namespace opencorr
 		Eigen::Matrix3f fundamental_matrix; //fundamental matrix of stereovision system
 		Point2D parallax; //parallax of the secondary view with respect to the primary view 
 		float parallax_x[3], parallax_y[3]; //linear regression coefficients of parallax with respect to coordinates
+		bool candidate_parallel; //parallelize the check of candidates of each POI instead of the processing of POIs
+		float prune_zncc; //candidates with ZNCC of initial guess lower than this threshold are not iterated further
+		int scan_candidates; //number of candidates selected by integer-pixel scan for ICGN1, 0 disables the scan
+		Eigen::MatrixXd tar_sum, tar_sqsum; //integral images of target image and its square
+		bool row_aligned; //search along the row of POI in a pair of rectified images
+		bool tracking; //seed the POIs with the matches in last frame, search only for the POIs failed in tracking
+		float track_zncc; //POIs with ZNCC lower than this threshold after tracking fall back to the search
+		std::vector<POI2D> track_queue; //matches in last frame, in the same order as the POI queue
+		std::vector<Point2D> track_motion; //displacement of the POIs in view1 in last frame
+		int fallback_number; //number of POIs falling back to the search in last frame
+
+		//integral images of target image and its square, built if they do not match the size of target image
+		void prepareScan();
+
+		//ZNCC scan at integer pixels along epipolar line, using the integral images for normalization
+		void scanEpipolar(POI2D* poi, int x_center, float line_slope, float line_intercept, std::vector<int>& selected_x);
+
+		//ICGN1 starting from the match of the same POI in last frame, return false if the result is not reliable
+		bool track(POI2D* poi, POI2D* previous, Point2D& previous_motion);
 
 	public:
 		ICGN2D1* icgn1;
@@ -51,6 +70,18 @@ namespace opencorr
 		int getSearchRadius() const;
 		int getSearchStep() const;
 		void setSearch(int search_radius, int search_step);
+		bool getCandidateParallel() const;
+		void setCandidateParallel(bool candidate_parallel); //suitable for a small number of POIs with many candidates
+		float getPruning() const;
+		void setPruning(float prune_zncc);
+		int getScan() const;
+		void setScan(int scan_candidates); //the integral images are built in prepare(), or in compute() if missing
+		bool getRowAligned() const;
+		void setRowAligned(bool row_aligned); //for the images rectified by Stereorectification
+		bool getTracking() const;
+		void setTracking(bool tracking, float track_zncc); //for a sequence of stereo images, the POIs keep their order
+		void resetTracking(); //clear the matches of last frame, e.g. at the beginning of a new sequence
+		int getFallback() const;
 		void createICGN(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition);
 		void prepareICGN();
 		void destoryICGN();
@@ -60,6 +91,7 @@ namespace opencorr
 
 		void updateCameras(Calibration& view1_cam, Calibration& view2_cam);
 		void updateFundementalMatrix();
+		Eigen::Matrix3f getFundamentalMatrix() const; //available after prepare()
 
 		void prepare();
 		void compute(POI2D* poi);
@@ -18,16 +18,6 @@
 
 namespace opencorr
 {
-	NearestNeighbor* FeatureAffine2D::getInstance(int tid)
-	{
-		if (tid >= (int)instance_pool.size())
-		{
-			throw std::string("CPU thread ID over limit");
-		}
-
-		return instance_pool[tid];
-	}
-
 	FeatureAffine2D::FeatureAffine2D(int radius_x, int radius_y, int thread_number)
 	{
 		this->subset_radius_x = radius_x;
@@ -38,21 +28,15 @@ namespace opencorr
 		ransac_config.sample_mumber = 3;
 		ransac_config.trial_number = 20;
 
+		grid_cell_size = 0.f;
+		grid_cols = 0;
+		grid_rows = 0;
+
 		this->thread_number = thread_number;
-		for (int i = 0; i < thread_number; i++)
-		{
-			NearestNeighbor* instance = new NearestNeighbor();
-			instance_pool.push_back(instance);
-		}
 	}
 
 	FeatureAffine2D::~FeatureAffine2D()
 	{
-		for (auto& instance : instance_pool)
-		{
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	RansacConfig FeatureAffine2D::getRansacConfig() const
@@ -87,29 +71,128 @@ namespace opencorr
 		this->tar_kp = tar_kp;
 	}
 
-	void FeatureAffine2D::prepare()
+	void FeatureAffine2D::constructGrid()
 	{
-#pragma omp parallel for
-		for (int i = 0; i < thread_number; i++)
+		int kp_number = (int)ref_kp.size();
+		grid_cell_size = neighbor_search_radius;
+		grid_cols = 0;
+		grid_rows = 0;
+		std::vector<int>().swap(cell_start);
+		std::vector<int>().swap(kp_cell_index);
+
+		if (kp_number == 0 || grid_cell_size <= 0)
+		{
+			return;
+		}
+
+		//get the bounding box of keypoints
+		float x_min = ref_kp[0].x, x_max = ref_kp[0].x;
+		float y_min = ref_kp[0].y, y_max = ref_kp[0].y;
+		for (int i = 1; i < kp_number; i++)
+		{
+			x_min = ref_kp[i].x < x_min ? ref_kp[i].x : x_min;
+			x_max = ref_kp[i].x > x_max ? ref_kp[i].x : x_max;
+			y_min = ref_kp[i].y < y_min ? ref_kp[i].y : y_min;
+			y_max = ref_kp[i].y > y_max ? ref_kp[i].y : y_max;
+		}
+
+		grid_origin.x = x_min;
+		grid_origin.y = y_min;
+
+		//enlarge the cells when a small radius would make them outnumber the keypoints
+		double cols = floor((x_max - x_min) / (double)grid_cell_size) + 1.;
+		double rows = floor((y_max - y_min) / (double)grid_cell_size) + 1.;
+		while (cols * rows > (double)kp_number)
 		{
-			instance_pool[i]->assignPoints(ref_kp);
-			instance_pool[i]->setSearchRadius(neighbor_search_radius);
-			instance_pool[i]->setSearchK(min_neighbor_num);
-			instance_pool[i]->constructKdTree();
+			double scale = sqrt(cols * rows / kp_number);
+			grid_cell_size = (float)(grid_cell_size * (scale > 1.01 ? scale : 1.01));
+			cols = floor((x_max - x_min) / (double)grid_cell_size) + 1.;
+			rows = floor((y_max - y_min) / (double)grid_cell_size) + 1.;
+		}
+		grid_cols = (int)((x_max - x_min) / grid_cell_size) + 1;
+		grid_rows = (int)((y_max - y_min) / grid_cell_size) + 1;
+
+		//counting sort of keypoints according to the cell they fall in
+		std::vector<int> kp_cell(kp_number);
+		cell_start.assign((size_t)grid_cols * grid_rows + 1, 0);
+		for (int i = 0; i < kp_number; i++)
+		{
+			int cell_x = (int)((ref_kp[i].x - grid_origin.x) / grid_cell_size);
+			int cell_y = (int)((ref_kp[i].y - grid_origin.y) / grid_cell_size);
+			kp_cell[i] = cell_y * grid_cols + cell_x;
+			cell_start[kp_cell[i] + 1]++;
+		}
+
+		for (int i = 0; i < grid_cols * grid_rows; i++)
+		{
+			cell_start[i + 1] += cell_start[i];
+		}
+
+		std::vector<int> cell_fill(cell_start.begin(), cell_start.end() - 1);
+		kp_cell_index.resize(kp_number);
+		for (int i = 0; i < kp_number; i++)
+		{
+			kp_cell_index[cell_fill[kp_cell[i]]++] = i;
 		}
 	}
 
-	void FeatureAffine2D::compute(POI2D* poi)
+	int FeatureAffine2D::gridSearch(Point2D& location, std::vector<int>& neighbor_index)
 	{
-		//set instance w.r.t. thread id 
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
+		neighbor_index.clear();
+		if (grid_cols == 0 || grid_rows == 0)
+		{
+			return 0;
+		}
+
+		//range of cells overlapped by the searching region
+		int cell_x_min = (int)floor((location.x - neighbor_search_radius - grid_origin.x) / grid_cell_size);
+		int cell_x_max = (int)floor((location.x + neighbor_search_radius - grid_origin.x) / grid_cell_size);
+		int cell_y_min = (int)floor((location.y - neighbor_search_radius - grid_origin.y) / grid_cell_size);
+		int cell_y_max = (int)floor((location.y + neighbor_search_radius - grid_origin.y) / grid_cell_size);
 
+		cell_x_min = cell_x_min < 0 ? 0 : cell_x_min;
+		cell_y_min = cell_y_min < 0 ? 0 : cell_y_min;
+		cell_x_max = cell_x_max > grid_cols - 1 ? grid_cols - 1 : cell_x_max;
+		cell_y_max = cell_y_max > grid_rows - 1 ? grid_rows - 1 : cell_y_max;
+
+		//the cells in the same row are contiguous, thus each row yields an index range of keypoints
+		float squared_radius = neighbor_search_radius * neighbor_search_radius;
+		for (int cell_y = cell_y_min; cell_y <= cell_y_max; cell_y++)
+		{
+			int range_begin = cell_start[cell_y * grid_cols + cell_x_min];
+			int range_end = cell_start[cell_y * grid_cols + cell_x_max + 1];
+			for (int i = range_begin; i < range_end; i++)
+			{
+				Point2D distance = ref_kp[kp_cell_index[i]] - location;
+				if (distance * distance < squared_radius)
+				{
+					neighbor_index.push_back(kp_cell_index[i]);
+				}
+			}
+		}
+
+		return (int)neighbor_index.size();
+	}
+
+	void FeatureAffine2D::prepare()
+	{
+		neighbor_search.assignPoints(ref_kp);
+		neighbor_search.setSearchRadius(neighbor_search_radius);
+		neighbor_search.setSearchK(min_neighbor_num);
+		neighbor_search.constructKdTree();
+
+		constructGrid();
+	}
+
+	void FeatureAffine2D::compute(POI2D* poi)
+	{
 		Point3D current_point(poi->x, poi->y, 0.f);
 		std::vector<Point2D> ref_candidates, tar_candidates;
 
-		//search the neighbor keypoints in a region of given radius
-		std::vector<nanoflann::ResultItem<uint32_t, float>> current_matches;
-		int neighbor_num = neighbor_search->radiusSearch(current_point, current_matches);
+		//collect the neighbor keypoints in a region of given radius from the cells of uniform grid
+		Point2D current_location(poi->x, poi->y);
+		std::vector<int> neighbor_index;
+		int neighbor_num = gridSearch(current_location, neighbor_index);
 
 		if (neighbor_num < ransac_config.sample_mumber)
 		{
@@ -124,8 +207,8 @@ namespace opencorr
 			{
 				for (int i = 0; i < neighbor_num; i++)
 				{
-					ref_candidates[i] = ref_kp[current_matches[i].first];
-					tar_candidates[i] = tar_kp[current_matches[i].first];
+					ref_candidates[i] = ref_kp[neighbor_index[i]];
+					tar_candidates[i] = tar_kp[neighbor_index[i]];
 				}
 			}
 			else //try KNN search if the obtained neighbor keypoints are not enough
@@ -136,7 +219,7 @@ namespace opencorr
 				std::vector<uint32_t> k_neighbors_idx;
 				std::vector<float> kp_squared_distance;
 
-				neighbor_num = neighbor_search->knnSearch(current_point, k_neighbors_idx, kp_squared_distance);
+				neighbor_num = neighbor_search.knnSearch(current_point, k_neighbors_idx, kp_squared_distance);
 
 				ref_candidates.resize(neighbor_num);
 				tar_candidates.resize(neighbor_num);
@@ -289,20 +372,12 @@ namespace opencorr
 
 	void FeatureAffine2D::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
 	}
 
 	//functions for self-adaptive subset
 	void FeatureAffine2D::compute(POI2D* poi, int neighbor_k, int min_radius)
 	{
-		//set instance w.r.t. thread id 
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
-
 		Point3D current_point(poi->x, poi->y, 0.f);
 		std::vector<Point2D> ref_candidates, tar_candidates;
 
@@ -315,7 +390,7 @@ namespace opencorr
 		std::vector<uint32_t> k_neighbors_idx;
 		std::vector<float> kp_squared_distance;
 
-		int neighbor_num = neighbor_search->knnSearch(current_point, neighbor_k, k_neighbors_idx, kp_squared_distance);
+		int neighbor_num = neighbor_search.knnSearch(current_point, neighbor_k, k_neighbors_idx, kp_squared_distance);
 
 		if (neighbor_num < ransac_config.sample_mumber)
 		{
@@ -477,16 +552,6 @@ namespace opencorr
 	//////////////////////////////////////////////////////////////////////////////
 
 
-	NearestNeighbor* FeatureAffine3D::getInstance(int tid)
-	{
-		if (tid >= (int)instance_pool.size())
-		{
-			throw std::string("CPU thread ID over limit");
-		}
-
-		return instance_pool[tid];
-	}
-
 	FeatureAffine3D::FeatureAffine3D(int radius_x, int radius_y, int radius_z, int thread_number)
 	{
 		this->subset_radius_x = radius_x;
@@ -498,45 +563,28 @@ namespace opencorr
 		ransac_config.trial_number = 32;
 
 		this->thread_number = thread_number;
-		for (int i = 0; i < thread_number; i++)
-		{
-			NearestNeighbor* instance = new NearestNeighbor();
-			instance_pool.push_back(instance);
-		}
 	}
 
 	FeatureAffine3D::~FeatureAffine3D()
 	{
-		for (auto& instance : instance_pool)
-		{
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	void FeatureAffine3D::prepare()
 	{
-#pragma omp parallel for
-		for (int i = 0; i < thread_number; i++)
-		{
-			instance_pool[i]->assignPoints(ref_kp);
-			instance_pool[i]->setSearchRadius(neighbor_search_radius);
-			instance_pool[i]->setSearchK(min_neighbor_num);
-			instance_pool[i]->constructKdTree();
-		}
+		neighbor_search.assignPoints(ref_kp);
+		neighbor_search.setSearchRadius(neighbor_search_radius);
+		neighbor_search.setSearchK(min_neighbor_num);
+		neighbor_search.constructKdTree();
 	}
 
 	void FeatureAffine3D::compute(POI3D* poi)
 	{
-		//set instance w.r.t. thread id 
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
-
 		Point3D current_point(poi->x, poi->y, poi->z);
 		std::vector<Point3D> ref_candidates, tar_candidates;
 
 		//search the neighbor keypoints in a region of given radius
 		std::vector<nanoflann::ResultItem<uint32_t, float>> current_matches;
-		int neighbor_num = neighbor_search->radiusSearch(current_point, current_matches);
+		int neighbor_num = neighbor_search.radiusSearch(current_point, current_matches);
 
 		if (neighbor_num < ransac_config.sample_mumber)
 		{
@@ -563,7 +611,7 @@ namespace opencorr
 				std::vector<uint32_t> k_neighbors_idx;
 				std::vector<float> kp_squared_distance;
 
-				neighbor_num = neighbor_search->knnSearch(current_point, k_neighbors_idx, kp_squared_distance);
+				neighbor_num = neighbor_search.knnSearch(current_point, k_neighbors_idx, kp_squared_distance);
 
 				ref_candidates.resize(neighbor_num);
 				tar_candidates.resize(neighbor_num);
@@ -726,12 +774,7 @@ namespace opencorr
 
 	void FeatureAffine3D::compute(std::vector<POI3D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI3D* poi) { compute(poi); });
 	}
 
 	RansacConfig FeatureAffine3D::getRansacConfig() const
@@ -41,14 +41,23 @@ namespace opencorr
 	class FeatureAffine2D : public DIC
 	{
 	private:
-		std::vector<NearestNeighbor*> instance_pool;
-		NearestNeighbor* getInstance(int tid);
+		NearestNeighbor neighbor_search; //kd-tree shared by all the threads
 
 	protected:
 		float neighbor_search_radius; //seaching radius for mached keypoints around a POI
 		int min_neighbor_num; //minimum number of neighbors required by RANSAC
 		RansacConfig ransac_config;
 
+		//uniform grid for bulk assignment of keypoints to POIs, cells are stored row by row
+		Point2D grid_origin; //upper-left corner of the grid
+		float grid_cell_size; //side length of cell, not smaller than the neighbor searching radius
+		int grid_cols, grid_rows; //number of cells along x and y
+		std::vector<int> cell_start; //start of each cell in kp_cell_index, with an extra element marking the end
+		std::vector<int> kp_cell_index; //indices of keypoints in ref_kp, sorted by cell
+
+		void constructGrid(); //bin the keypoints in ref image into the uniform grid
+		int gridSearch(Point2D& location, std::vector<int>& neighbor_index); //collect the keypoints within the searching radius
+
 	public:
 		std::vector<Point2D> ref_kp; //matched keypoints in ref image
 		std::vector<Point2D> tar_kp; //matched keypoints in tar image
@@ -81,8 +90,7 @@ namespace opencorr
 	class FeatureAffine3D : public DVC
 	{
 	private:
-		std::vector<NearestNeighbor*> instance_pool;
-		NearestNeighbor* getInstance(int tid);
+		NearestNeighbor neighbor_search; //kd-tree shared by all the threads
 
 	protected:
 		float neighbor_search_radius; //seaching radius for mached keypoints around a POI
@@ -12,10 +12,15 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <mutex>
+
 #include "oc_fftcc.h"
 
 namespace opencorr
 {
+	//the planner of FFTW is not thread-safe, while the instances may be created by any threads
+	static std::mutex planner_mutex;
+
 	FFTW* FFTW::allocate(int subset_radius_x, int subset_radius_y)
 	{
 		int width = 2 * subset_radius_x;
@@ -33,8 +38,8 @@ namespace opencorr
 		FFTW_instance->tar_subset = new float[subset_size];
 		FFTW_instance->zncc = new float[subset_size];
 
-#pragma omp critical 
 		{
+			std::lock_guard<std::mutex> lock(planner_mutex);
 			FFTW_instance->ref_plan = fftwf_plan_dft_r2c_2d(width, height, FFTW_instance->ref_subset, FFTW_instance->ref_freq, FFTW_ESTIMATE);
 			FFTW_instance->tar_plan = fftwf_plan_dft_r2c_2d(width, height, FFTW_instance->tar_subset, FFTW_instance->tar_freq, FFTW_ESTIMATE);
 			FFTW_instance->zncc_plan = fftwf_plan_dft_c2r_2d(width, height, FFTW_instance->zncc_freq, FFTW_instance->zncc, FFTW_ESTIMATE);
@@ -61,8 +66,8 @@ namespace opencorr
 		FFTW_instance->tar_subset = new float[subset_size];
 		FFTW_instance->zncc = new float[subset_size];
 
-#pragma omp critical 
 		{
+			std::lock_guard<std::mutex> lock(planner_mutex);
 			FFTW_instance->ref_plan = fftwf_plan_dft_r2c_3d(dim_x, dim_y, dim_z, FFTW_instance->ref_subset, FFTW_instance->ref_freq, FFTW_ESTIMATE);
 			FFTW_instance->tar_plan = fftwf_plan_dft_r2c_3d(dim_x, dim_y, dim_z, FFTW_instance->tar_subset, FFTW_instance->tar_freq, FFTW_ESTIMATE);
 			FFTW_instance->zncc_plan = fftwf_plan_dft_c2r_3d(dim_x, dim_y, dim_z, FFTW_instance->zncc_freq, FFTW_instance->zncc, FFTW_ESTIMATE);
@@ -79,6 +84,8 @@ namespace opencorr
 		fftw_free(instance->ref_freq);
 		fftw_free(instance->tar_freq);
 		fftw_free(instance->zncc_freq);
+
+		std::lock_guard<std::mutex> lock(planner_mutex);
 		fftwf_destroy_plan(instance->ref_plan);
 		fftwf_destroy_plan(instance->tar_plan);
 		fftwf_destroy_plan(instance->zncc_plan);
@@ -101,8 +108,8 @@ namespace opencorr
 		instance->tar_subset = new float[subset_size];
 		instance->zncc = new float[subset_size];
 
-#pragma omp critical 
 		{
+			std::lock_guard<std::mutex> lock(planner_mutex);
 			instance->ref_plan = fftwf_plan_dft_r2c_2d(width, height, instance->ref_subset, instance->ref_freq, FFTW_ESTIMATE);
 			instance->tar_plan = fftwf_plan_dft_r2c_2d(width, height, instance->tar_subset, instance->tar_freq, FFTW_ESTIMATE);
 			instance->zncc_plan = fftwf_plan_dft_c2r_2d(width, height, instance->zncc_freq, instance->zncc, FFTW_ESTIMATE);
@@ -127,8 +134,8 @@ namespace opencorr
 		instance->tar_subset = new float[subset_size];
 		instance->zncc = new float[subset_size];
 
-#pragma omp critical 
 		{
+			std::lock_guard<std::mutex> lock(planner_mutex);
 			instance->ref_plan = fftwf_plan_dft_r2c_3d(dim_x, dim_y, dim_z, instance->ref_subset, instance->ref_freq, FFTW_ESTIMATE);
 			instance->tar_plan = fftwf_plan_dft_r2c_3d(dim_x, dim_y, dim_z, instance->tar_subset, instance->tar_freq, FFTW_ESTIMATE);
 			instance->zncc_plan = fftwf_plan_dft_c2r_3d(dim_x, dim_y, dim_z, instance->zncc_freq, instance->zncc, FFTW_ESTIMATE);
@@ -137,42 +144,31 @@ namespace opencorr
 
 	//FFT accelerated cross correlation 2D
 	FFTCC2D::FFTCC2D(int subset_radius_x, int subset_radius_y, int thread_number)
+		: workspace([this] { return FFTW::allocate(this->subset_radius_x, this->subset_radius_y); },
+			[](FFTW* instance)
+			{
+				FFTW::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
 		this->thread_number = thread_number;
-
-		for (int i = 0; i < thread_number; i++)
-		{
-			FFTW* instance = FFTW::allocate(subset_radius_x, subset_radius_y);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	FFTCC2D::~FFTCC2D()
 	{
-		for (auto& instance : instance_pool)
-		{
-			FFTW::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
-	FFTW* FFTCC2D::getInstance(int tid)
+	FFTW* FFTCC2D::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
-		{
-			std::cerr << "CPU thread ID over limit" << std::endl;
-		}
-
-		return instance_pool[tid];
+		return workspace.local();
 	}
 
 	void FFTCC2D::compute(POI2D* poi)
 	{
 		//set instance w.r.t. thread id 
-		FFTW* current_instance = getInstance(omp_get_thread_num());
+		FFTW* current_instance = getInstance();
 
 		int subset_width = subset_radius_x * 2;
 		int subset_height = subset_radius_y * 2;
@@ -264,55 +260,39 @@ namespace opencorr
 
 	void FFTCC2D::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
 	}
 
 
 
 	//FFT accelerated cross correlation 3D
 	FFTCC3D::FFTCC3D(int subset_radius_x, int subset_radius_y, int subset_radius_z, int thread_number)
+		: workspace([this] { return FFTW::allocate(this->subset_radius_x, this->subset_radius_y, this->subset_radius_z); },
+			[](FFTW* instance)
+			{
+				FFTW::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
 		this->subset_radius_z = subset_radius_z;
 		this->thread_number = thread_number;
-
-		for (int i = 0; i < thread_number; i++)
-		{
-			FFTW* instance = FFTW::allocate(subset_radius_x, subset_radius_y, subset_radius_z);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	FFTCC3D::~FFTCC3D()
 	{
-		for (auto& instance : instance_pool)
-		{
-			FFTW::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
-	FFTW* FFTCC3D::getInstance(int tid)
+	FFTW* FFTCC3D::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
-		{
-			std::cerr << "CPU thread ID over limit" << std::endl;
-		}
-
-		return instance_pool[tid];
+		return workspace.local();
 	}
 
 	void FFTCC3D::compute(POI3D* poi)
 	{
 		//set instance w.r.t. thread id 
-		FFTW* current_instance = getInstance(omp_get_thread_num());
+		FFTW* current_instance = getInstance();
 
 		int subset_dim_x = subset_radius_x * 2;
 		int subset_dim_y = subset_radius_y * 2;
@@ -415,12 +395,7 @@ namespace opencorr
 
 	void FFTCC3D::compute(std::vector<POI3D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI3D* poi) { compute(poi); });
 	}
 
 }//namespace opencorr
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include "oc_poi.h"
 #include "oc_point.h"
 #include "oc_subset.h"
+#include "oc_workspace.h"
 
 namespace opencorr
 {
@@ -59,8 +60,8 @@ namespace opencorr
 	class FFTCC2D : public DIC
 	{
 	private:
-		std::vector<FFTW*> instance_pool; //pool of FFTW instances for multi-thread processing
-		FFTW* getInstance(int tid); //get an instance according to the number of current thread id
+		Workspace<FFTW> workspace; //instances of the threads running this engine
+		FFTW* getInstance(); //instance of calling thread
 
 	public:
 		FFTCC2D(int subset_radius_x, int subset_radius_y, int thread_number);
@@ -78,8 +79,8 @@ namespace opencorr
 	class FFTCC3D : public DVC
 	{
 	private:
-		std::vector<FFTW*> instance_pool; //pool of FFTW instances for multi-thread processing
-		FFTW* getInstance(int tid); //get an instance according to the number of current thread id
+		Workspace<FFTW> workspace; //instances of the threads running this engine
+		FFTW* getInstance(); //instance of calling thread
 
 	public:
 		FFTCC3D(int subset_radius_x, int subset_radius_y, int subset_radius_z, int thread_number);
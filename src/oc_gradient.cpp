@@ -12,7 +12,10 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <algorithm>
+
 #include "oc_gradient.h"
+#include "oc_numa.h"
 
 namespace opencorr
 {
@@ -29,21 +32,26 @@ namespace opencorr
 		int height = grad_img->height;
 		int width = grad_img->width;
 
-		gradient_x = Eigen::MatrixXf::Zero(height, width);
+		gradient_x.resize(height, width);
 
-#pragma omp parallel for
-		for (int r = 0; r < height; r++)
+		numaFor(width, [&](int begin, int end)
 		{
-			for (int c = 2; c < width - 2; c++)
+			for (int c = begin; c < end; c++)
 			{
-				float result = 0.0f;
-				result -= grad_img->eg_mat(r, c + 2) / 12.f;
-				result += grad_img->eg_mat(r, c + 1) * (2.f / 3.f);
-				result -= grad_img->eg_mat(r, c - 1) * (2.f / 3.f);
-				result += grad_img->eg_mat(r, c - 2) / 12.f;
-				gradient_x(r, c) = result;
+				for (int r = 0; r < height; r++)
+				{
+					float result = 0.0f;
+					if (c >= 2 && c < width - 2)
+					{
+						result -= grad_img->eg_mat(r, c + 2) / 12.f;
+						result += grad_img->eg_mat(r, c + 1) * (2.f / 3.f);
+						result -= grad_img->eg_mat(r, c - 1) * (2.f / 3.f);
+						result += grad_img->eg_mat(r, c - 2) / 12.f;
+					}
+					gradient_x(r, c) = result;
+				}
 			}
-		}
+		});
 	}
 
 	void Gradient2D4::getGradientY()
@@ -51,21 +59,26 @@ namespace opencorr
 		int height = grad_img->height;
 		int width = grad_img->width;
 
-		gradient_y = Eigen::MatrixXf::Zero(height, width);
+		gradient_y.resize(height, width);
 
-#pragma omp parallel for
-		for (int r = 2; r < height - 2; r++)
+		numaFor(width, [&](int begin, int end)
 		{
-			for (int c = 0; c < width; c++)
+			for (int c = begin; c < end; c++)
 			{
-				float result = 0.0f;
-				result -= grad_img->eg_mat(r + 2, c) / 12.f;
-				result += grad_img->eg_mat(r + 1, c) * (2.f / 3.f);
-				result -= grad_img->eg_mat(r - 1, c) * (2.f / 3.f);
-				result += grad_img->eg_mat(r - 2, c) / 12.f;
-				gradient_y(r, c) = result;
+				for (int r = 0; r < height; r++)
+				{
+					float result = 0.0f;
+					if (r >= 2 && r < height - 2)
+					{
+						result -= grad_img->eg_mat(r + 2, c) / 12.f;
+						result += grad_img->eg_mat(r + 1, c) * (2.f / 3.f);
+						result -= grad_img->eg_mat(r - 1, c) * (2.f / 3.f);
+						result += grad_img->eg_mat(r - 2, c) / 12.f;
+					}
+					gradient_y(r, c) = result;
+				}
 			}
-		}
+		});
 	}
 
 	void Gradient2D4::getGradientXY()
@@ -73,26 +86,31 @@ namespace opencorr
 		int height = grad_img->height;
 		int width = grad_img->width;
 
-		gradient_xy = Eigen::MatrixXf::Zero(height, width);
-
 		if (gradient_x.rows() != height || gradient_x.cols() != width)
 		{
 			getGradientX();
 		}
 
-#pragma omp parallel for
-		for (int r = 2; r < height - 2; r++)
+		gradient_xy.resize(height, width);
+
+		numaFor(width, [&](int begin, int end)
 		{
-			for (int c = 0; c < width; c++)
+			for (int c = begin; c < end; c++)
 			{
-				float result = 0.0f;
-				result -= gradient_x(r + 2, c) / 12.f;
-				result += gradient_x(r + 1, c) * (2.f / 3.f);
-				result -= gradient_x(r - 1, c) * (2.f / 3.f);
-				result += gradient_x(r - 2, c) / 12.f;
-				gradient_xy(r, c) = result;
+				for (int r = 0; r < height; r++)
+				{
+					float result = 0.0f;
+					if (r >= 2 && r < height - 2)
+					{
+						result -= gradient_x(r + 2, c) / 12.f;
+						result += gradient_x(r + 1, c) * (2.f / 3.f);
+						result -= gradient_x(r - 1, c) * (2.f / 3.f);
+						result += gradient_x(r - 2, c) / 12.f;
+					}
+					gradient_xy(r, c) = result;
+				}
 			}
-		}
+		});
 	}
 
 	Gradient3D4::Gradient3D4(Image3D& image)
@@ -128,22 +146,24 @@ namespace opencorr
 		}
 		gradient_x = new3D(dim_z, dim_y, dim_x);
 
-#pragma omp parallel for
-		for (int i = 0; i < dim_z; i++)
+		numaFor(dim_z, [&](int begin, int end)
 		{
-			for (int j = 0; j < dim_y; j++)
+			for (int i = begin; i < end; i++)
 			{
-				for (int k = 2; k < dim_x - 2; k++)
+				for (int j = 0; j < dim_y; j++)
 				{
-					float result = 0.0f;
-					result -= grad_img->vol_mat[i][j][k + 2] / 12.f;
-					result += grad_img->vol_mat[i][j][k + 1] * (2.f / 3.f);
-					result -= grad_img->vol_mat[i][j][k - 1] * (2.f / 3.f);
-					result += grad_img->vol_mat[i][j][k - 2] / 12.f;
-					gradient_x[i][j][k] = result;
+					for (int k = 2; k < dim_x - 2; k++)
+					{
+						float result = 0.0f;
+						result -= grad_img->vol_mat[i][j][k + 2] / 12.f;
+						result += grad_img->vol_mat[i][j][k + 1] * (2.f / 3.f);
+						result -= grad_img->vol_mat[i][j][k - 1] * (2.f / 3.f);
+						result += grad_img->vol_mat[i][j][k - 2] / 12.f;
+						gradient_x[i][j][k] = result;
+					}
 				}
 			}
-		}
+		});
 	}
 
 	void Gradient3D4::getGradientY()
@@ -158,22 +178,24 @@ namespace opencorr
 		}
 		gradient_y = new3D(dim_z, dim_y, dim_x);
 
-#pragma omp parallel for
-		for (int k = 0; k < dim_x; k++)
+		numaFor(dim_z, [&](int begin, int end)
 		{
-			for (int i = 0; i < dim_z; i++)
+			for (int i = begin; i < end; i++)
 			{
 				for (int j = 2; j < dim_y - 2; j++)
 				{
-					float result = 0.0f;
-					result -= grad_img->vol_mat[i][j + 2][k] / 12.f;
-					result += grad_img->vol_mat[i][j + 1][k] * (2.f / 3.f);
-					result -= grad_img->vol_mat[i][j - 1][k] * (2.f / 3.f);
-					result += grad_img->vol_mat[i][j - 2][k] / 12.f;
-					gradient_y[i][j][k] = result;
+					for (int k = 0; k < dim_x; k++)
+					{
+						float result = 0.0f;
+						result -= grad_img->vol_mat[i][j + 2][k] / 12.f;
+						result += grad_img->vol_mat[i][j + 1][k] * (2.f / 3.f);
+						result -= grad_img->vol_mat[i][j - 1][k] * (2.f / 3.f);
+						result += grad_img->vol_mat[i][j - 2][k] / 12.f;
+						gradient_y[i][j][k] = result;
+					}
 				}
 			}
-		}
+		});
 	}
 
 	void Gradient3D4::getGradientZ()
@@ -188,22 +210,24 @@ namespace opencorr
 		}
 		gradient_z = new3D(dim_z, dim_y, dim_x);
 
-#pragma omp parallel for
-		for (int j = 0; j < dim_y; j++)
+		numaFor(dim_z, [&](int begin, int end)
 		{
-			for (int k = 0; k < dim_x; k++)
+			for (int i = std::max(begin, 2); i < std::min(end, dim_z - 2); i++)
 			{
-				for (int i = 2; i < dim_z - 2; i++)
+				for (int j = 0; j < dim_y; j++)
 				{
-					float result = 0.0f;
-					result -= grad_img->vol_mat[i + 2][j][k] / 12.f;
-					result += grad_img->vol_mat[i + 1][j][k] * (2.f / 3.f);
-					result -= grad_img->vol_mat[i - 1][j][k] * (2.f / 3.f);
-					result += grad_img->vol_mat[i - 2][j][k] / 12.f;
-					gradient_z[i][j][k] = result;
+					for (int k = 0; k < dim_x; k++)
+					{
+						float result = 0.0f;
+						result -= grad_img->vol_mat[i + 2][j][k] / 12.f;
+						result += grad_img->vol_mat[i + 1][j][k] * (2.f / 3.f);
+						result -= grad_img->vol_mat[i - 1][j][k] * (2.f / 3.f);
+						result += grad_img->vol_mat[i - 2][j][k] / 12.f;
+						gradient_z[i][j][k] = result;
+					}
 				}
 			}
-		}
+		});
 	}
 
 } //namespcae opencorr
\ No newline at end of file
@@ -27,6 +27,8 @@ namespace opencorr
 		ICGN_instance->tar_subset = new Subset2D(subset_center, subset_radius_x, subset_radius_y);
 		ICGN_instance->error_img = Eigen::MatrixXf::Zero(subset_height, subset_width);
 		ICGN_instance->sd_img = new3D(subset_height, subset_width, 6);
+		ICGN_instance->ref_mean_norm = 0.f;
+		ICGN_instance->ref_prepared = false;
 
 		return ICGN_instance;
 	}
@@ -66,45 +68,42 @@ namespace opencorr
 		instance->tar_subset = new Subset2D(subset_center, subset_radius_x, subset_radius_y);
 		instance->error_img.resize(subset_height, subset_width);
 		instance->sd_img = new3D(subset_height, subset_width, 6);
+		instance->ref_prepared = false;
 	}
 
-	ICGN2D1_* ICGN2D1::getInstance(int tid)
+	ICGN2D1_* ICGN2D1::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
+		ICGN2D1_* instance = workspace.local();
+
+		//follow the subset radius of engine, which may be changed after the instance is created
+		if (instance->ref_subset->radius_x != subset_radius_x || instance->ref_subset->radius_y != subset_radius_y)
 		{
-			throw std::string("CPU thread ID over limit");
+			ICGN2D1_::update(instance, subset_radius_x, subset_radius_y);
 		}
 
-		return instance_pool[tid];
+		return instance;
 	}
 
 	ICGN2D1::ICGN2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number)
-		: ref_gradient(nullptr), tar_interp(nullptr)
+		: ref_gradient(nullptr), tar_interp(nullptr),
+		workspace([this] { return ICGN2D1_::allocate(this->subset_radius_x, this->subset_radius_y); },
+			[](ICGN2D1_* instance)
+			{
+				ICGN2D1_::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
 		this->conv_criterion = conv_criterion;
 		this->stop_condition = stop_condition;
 		this->thread_number = thread_number;
-
-		for (int i = 0; i < thread_number; i++)
-		{
-			ICGN2D1_* instance = ICGN2D1_::allocate(subset_radius_x, subset_radius_y);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	ICGN2D1::~ICGN2D1()
 	{
 		delete ref_gradient;
 		delete tar_interp;
-
-		for (auto& instance : instance_pool)
-		{
-			ICGN2D1_::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	void ICGN2D1::setIteration(float conv_criterion, float stop_condition)
@@ -150,185 +149,247 @@ namespace opencorr
 		prepareTar();
 	}
 
-	void ICGN2D1::compute(POI2D* poi)
+	void ICGN2D1::setRefSubset(ICGN2D1_* instance, POI2D* poi)
 	{
-		//set instance w.r.t. thread id 
-		ICGN2D1_* cur_instance = getInstance(omp_get_thread_num());
+		int subset_width = 2 * subset_radius_x + 1;
+		int subset_height = 2 * subset_radius_y + 1;
 
-		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
-			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1
-			|| fabs(poi->deformation.u) >= ref_img->width || fabs(poi->deformation.v) >= ref_img->height
-			|| poi->result.zncc < 0 || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v))
+		//set reference subset
+		instance->ref_subset->center = (Point2D)*poi;
+		instance->ref_subset->fill(ref_img);
+		instance->ref_mean_norm = instance->ref_subset->zeroMeanNorm();
+
+		//build the Hessian matrix
+		instance->hessian.setZero();
+		for (int r = 0; r < subset_height; r++)
 		{
-			poi->result.zncc = poi->result.zncc < -1 ? poi->result.zncc : -1;
+			for (int c = 0; c < subset_width; c++)
+			{
+				int x_local = c - subset_radius_x;
+				int y_local = r - subset_radius_y;
+				int x_global = (int)poi->x + x_local;
+				int y_global = (int)poi->y + y_local;
+				float ref_gradient_x = ref_gradient->gradient_x(y_global, x_global);
+				float ref_gradient_y = ref_gradient->gradient_y(y_global, x_global);
+
+				instance->sd_img[r][c][0] = ref_gradient_x;
+				instance->sd_img[r][c][1] = ref_gradient_x * x_local;
+				instance->sd_img[r][c][2] = ref_gradient_x * y_local;
+				instance->sd_img[r][c][3] = ref_gradient_y;
+				instance->sd_img[r][c][4] = ref_gradient_y * x_local;
+				instance->sd_img[r][c][5] = ref_gradient_y * y_local;
+
+				for (int i = 0; i < 6; i++)
+				{
+					for (int j = 0; j < 6; j++)
+					{
+						instance->hessian(i, j) += (instance->sd_img[r][c][i] * instance->sd_img[r][c][j]);
+					}
+				}
+			}
 		}
-		else
-		{
-			int subset_width = 2 * subset_radius_x + 1;
-			int subset_height = 2 * subset_radius_y + 1;
 
-			//set reference subset
-			cur_instance->ref_subset->center = (Point2D)*poi;
-			cur_instance->ref_subset->fill(ref_img);
-			float ref_mean_norm = cur_instance->ref_subset->zeroMeanNorm();
+		//calculate the inversed Hessian matrix
+		instance->inv_hessian = instance->hessian.inverse();
+	}
 
-			//build the Hessian matrix
-			cur_instance->hessian.setZero();
+	void ICGN2D1::iterate(ICGN2D1_* instance, POI2D* poi, float prune_zncc)
+	{
+		int subset_width = 2 * subset_radius_x + 1;
+		int subset_height = 2 * subset_radius_y + 1;
+		float ref_mean_norm = instance->ref_mean_norm;
+
+		//set target subset
+		instance->tar_subset->center = (Point2D)*poi;
+
+		//get initial guess
+		Deformation2D1 p_initial(poi->deformation.u, poi->deformation.ux, poi->deformation.uy,
+			poi->deformation.v, poi->deformation.vx, poi->deformation.vy);
+
+		//IC-GN iteration
+		int iteration_counter = 0; //initialize iteration counter
+		Deformation2D1 p_current, p_increment;
+		p_current.setDeformation(p_initial);
+		float dp_norm_max = 0.f, znssd;
+		Point2D local_coor, warped_coor, global_coor;
+		do
+		{
+			iteration_counter++;
+			//reconstruct target subset
 			for (int r = 0; r < subset_height; r++)
 			{
 				for (int c = 0; c < subset_width; c++)
 				{
 					int x_local = c - subset_radius_x;
 					int y_local = r - subset_radius_y;
-					int x_global = (int)poi->x + x_local;
-					int y_global = (int)poi->y + y_local;
-					float ref_gradient_x = ref_gradient->gradient_x(y_global, x_global);
-					float ref_gradient_y = ref_gradient->gradient_y(y_global, x_global);
-
-					cur_instance->sd_img[r][c][0] = ref_gradient_x;
-					cur_instance->sd_img[r][c][1] = ref_gradient_x * x_local;
-					cur_instance->sd_img[r][c][2] = ref_gradient_x * y_local;
-					cur_instance->sd_img[r][c][3] = ref_gradient_y;
-					cur_instance->sd_img[r][c][4] = ref_gradient_y * x_local;
-					cur_instance->sd_img[r][c][5] = ref_gradient_y * y_local;
-
-					for (int i = 0; i < 6; i++)
-					{
-						for (int j = 0; j < 6; j++)
-						{
-							cur_instance->hessian(i, j) += (cur_instance->sd_img[r][c][i] * cur_instance->sd_img[r][c][j]);
-						}
-					}
+					local_coor.x = x_local;
+					local_coor.y = y_local;
+					warped_coor = p_current.warp(local_coor);
+					global_coor = instance->tar_subset->center + warped_coor;
+					instance->tar_subset->eg_mat(r, c) = tar_interp->compute(global_coor);
 				}
 			}
+			float tar_mean_norm = instance->tar_subset->zeroMeanNorm();
 
-			//calculate the inversed Hessian matrix
-			cur_instance->inv_hessian = cur_instance->hessian.inverse();
+			//calculate error image
+			instance->error_img = instance->tar_subset->eg_mat * (ref_mean_norm / tar_mean_norm)
+				- (instance->ref_subset->eg_mat);
 
-			//set target subset
-			cur_instance->tar_subset->center = (Point2D)*poi;
+			//calculate ZNSSD
+			znssd = instance->error_img.squaredNorm() / (ref_mean_norm * ref_mean_norm);
 
-			//get initial guess
-			Deformation2D1 p_initial(poi->deformation.u, poi->deformation.ux, poi->deformation.uy,
-				poi->deformation.v, poi->deformation.vx, poi->deformation.vy);
+			//stop at the initial guess if its ZNCC is lower than the pruning threshold
+			if (iteration_counter == 1 && 0.5f * (2 - znssd) < prune_zncc)
+			{
+				break;
+			}
 
-			//IC-GN iteration
-			int iteration_counter = 0; //initialize iteration counter
-			Deformation2D1 p_current, p_increment;
-			p_current.setDeformation(p_initial);
-			float dp_norm_max, znssd;
-			Point2D local_coor, warped_coor, global_coor;
-			do
+			//calculate numerator
+			float numerator[6] = { 0.f };
+			for (int r = 0; r < subset_height; r++)
 			{
-				iteration_counter++;
-				//reconstruct target subset
-				for (int r = 0; r < subset_height; r++)
+				for (int c = 0; c < subset_width; c++)
 				{
-					for (int c = 0; c < subset_width; c++)
+					for (int i = 0; i < 6; i++)
 					{
-						int x_local = c - subset_radius_x;
-						int y_local = r - subset_radius_y;
-						local_coor.x = x_local;
-						local_coor.y = y_local;
-						warped_coor = p_current.warp(local_coor);
-						global_coor = cur_instance->tar_subset->center + warped_coor;
-						cur_instance->tar_subset->eg_mat(r, c) = tar_interp->compute(global_coor);
+						numerator[i] += (instance->sd_img[r][c][i] * instance->error_img(r, c));
 					}
 				}
-				float tar_mean_norm = cur_instance->tar_subset->zeroMeanNorm();
-
-				//calculate error image
-				cur_instance->error_img = cur_instance->tar_subset->eg_mat * (ref_mean_norm / tar_mean_norm)
-					- (cur_instance->ref_subset->eg_mat);
-
-				//calculate ZNSSD
-				znssd = cur_instance->error_img.squaredNorm() / (ref_mean_norm * ref_mean_norm);
+			}
 
-				//calculate numerator
-				float numerator[6] = { 0.f };
-				for (int r = 0; r < subset_height; r++)
+			//calculate dp
+			float dp[6] = { 0.f };
+			for (int i = 0; i < 6; i++)
+			{
+				for (int j = 0; j < 6; j++)
 				{
-					for (int c = 0; c < subset_width; c++)
-					{
-						for (int i = 0; i < 6; i++)
-						{
-							numerator[i] += (cur_instance->sd_img[r][c][i] * cur_instance->error_img(r, c));
-						}
-					}
+					dp[i] += (instance->inv_hessian(i, j) * numerator[j]);
 				}
+			}
+			p_increment.setDeformation(dp);
+
+			//update warp
+			p_current.warp_matrix = p_current.warp_matrix * p_increment.warp_matrix.inverse();
+
+			//update p
+			p_current.setDeformation();
+
+			//check convergence
+			int subset_radius_x2 = subset_radius_x * subset_radius_x;
+			int subset_radius_y2 = subset_radius_y * subset_radius_y;
+
+			dp_norm_max = 0.f;
+			dp_norm_max += p_increment.u * p_increment.u;
+			dp_norm_max += p_increment.ux * p_increment.ux * subset_radius_x2;
+			dp_norm_max += p_increment.uy * p_increment.uy * subset_radius_y2;
+			dp_norm_max += p_increment.v * p_increment.v;
+			dp_norm_max += p_increment.vx * p_increment.vx * subset_radius_x2;
+			dp_norm_max += p_increment.vy * p_increment.vy * subset_radius_y2;
+
+			dp_norm_max = sqrt(dp_norm_max);
+		} while (iteration_counter < stop_condition && dp_norm_max >= conv_criterion);
+
+		//store the final result
+		poi->deformation.u = p_current.u;
+		poi->deformation.ux = p_current.ux;
+		poi->deformation.uy = p_current.uy;
+		poi->deformation.v = p_current.v;
+		poi->deformation.vx = p_current.vx;
+		poi->deformation.vy = p_current.vy;
+
+		//save the parameters for output
+		poi->result.u0 = p_initial.u;
+		poi->result.v0 = p_initial.v;
+		poi->result.zncc = 0.5f * (2 - znssd);
+		poi->result.iteration = (float)iteration_counter;
+		poi->result.convergence = dp_norm_max;
+	}
 
-				//calculate dp
-				float dp[6] = { 0.f };
-				for (int i = 0; i < 6; i++)
-				{
-					for (int j = 0; j < 6; j++)
-					{
-						dp[i] += (cur_instance->inv_hessian(i, j) * numerator[j]);
-					}
-				}
-				p_increment.setDeformation(dp);
+	void ICGN2D1::compute(POI2D* poi)
+	{
+		//set instance w.r.t. thread id 
+		ICGN2D1_* cur_instance = getInstance();
 
-				//update warp
-				p_current.warp_matrix = p_current.warp_matrix * p_increment.warp_matrix.inverse();
+		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
+			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1
+			|| fabs(poi->deformation.u) >= ref_img->width || fabs(poi->deformation.v) >= ref_img->height
+			|| poi->result.zncc < 0 || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v))
+		{
+			poi->result.zncc = poi->result.zncc < -1 ? poi->result.zncc : -1;
+		}
+		else
+		{
+			setRefSubset(cur_instance, poi);
+			iterate(cur_instance, poi, -1.f);
+		}
 
-				//update p
-				p_current.setDeformation();
+		//check if the case of NaN occurs for ZNCC or displacments
+		if (std::isnan(poi->result.zncc) || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v))
+		{
+			poi->deformation.u = poi->result.u0;
+			poi->deformation.v = poi->result.v0;
+			poi->result.zncc = -5;
+		}
+	}
 
-				//check convergence
-				int subset_radius_x2 = subset_radius_x * subset_radius_x;
-				int subset_radius_y2 = subset_radius_y * subset_radius_y;
+	bool ICGN2D1::prepareCandidates(POI2D* poi)
+	{
+		//set instance w.r.t. thread id
+		ICGN2D1_* cur_instance = getInstance();
+		cur_instance->ref_prepared = false;
 
-				dp_norm_max = 0.f;
-				dp_norm_max += p_increment.u * p_increment.u;
-				dp_norm_max += p_increment.ux * p_increment.ux * subset_radius_x2;
-				dp_norm_max += p_increment.uy * p_increment.uy * subset_radius_y2;
-				dp_norm_max += p_increment.v * p_increment.v;
-				dp_norm_max += p_increment.vx * p_increment.vx * subset_radius_x2;
-				dp_norm_max += p_increment.vy * p_increment.vy * subset_radius_y2;
+		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
+			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1)
+		{
+			return false;
+		}
 
-				dp_norm_max = sqrt(dp_norm_max);
-			} while (iteration_counter < stop_condition && dp_norm_max >= conv_criterion);
+		//a subset of uniform gray has no zero-mean norm to normalize the correlation
+		setRefSubset(cur_instance, poi);
+		cur_instance->ref_prepared = cur_instance->ref_mean_norm > 0.f;
+		return cur_instance->ref_prepared;
+	}
 
-			//store the final result
-			poi->deformation.u = p_current.u;
-			poi->deformation.ux = p_current.ux;
-			poi->deformation.uy = p_current.uy;
-			poi->deformation.v = p_current.v;
-			poi->deformation.vx = p_current.vx;
-			poi->deformation.vy = p_current.vy;
+	void ICGN2D1::computeCandidate(POI2D* candidate, float prune_zncc)
+	{
+		//set instance w.r.t. thread id
+		ICGN2D1_* cur_instance = getInstance();
 
-			//save the parameters for output
-			poi->result.u0 = p_initial.u;
-			poi->result.v0 = p_initial.v;
-			poi->result.zncc = 0.5f * (2 - znssd);
-			poi->result.iteration = (float)iteration_counter;
-			poi->result.convergence = dp_norm_max;
+		//called inside parallel regions, thus a candidate without prepared reference subset is marked instead of throwing
+		if (!cur_instance->ref_prepared || cur_instance->ref_subset->center.x != candidate->x
+			|| cur_instance->ref_subset->center.y != candidate->y)
+		{
+			candidate->result.zncc = -1;
+		}
+		else if (fabs(candidate->deformation.u) >= ref_img->width || fabs(candidate->deformation.v) >= ref_img->height
+			|| candidate->result.zncc < 0 || std::isnan(candidate->deformation.u) || std::isnan(candidate->deformation.v))
+		{
+			candidate->result.zncc = candidate->result.zncc < -1 ? candidate->result.zncc : -1;
+		}
+		else
+		{
+			iterate(cur_instance, candidate, prune_zncc);
 		}
 
 		//check if the case of NaN occurs for ZNCC or displacments
-		if (std::isnan(poi->result.zncc) || std::isnan(poi->deformation.u) || std::isnan(poi->deformation.v))
+		if (std::isnan(candidate->result.zncc) || std::isnan(candidate->deformation.u) || std::isnan(candidate->deformation.v))
 		{
-			poi->deformation.u = poi->result.u0;
-			poi->deformation.v = poi->result.v0;
-			poi->result.zncc = -5;
+			candidate->deformation.u = candidate->result.u0;
+			candidate->deformation.v = candidate->result.v0;
+			candidate->result.zncc = -5;
 		}
 	}
 
 	void ICGN2D1::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
 	}
 
 	//functions for self-adaptive subset
 	void ICGN2D1::compute(POI2D* poi, Point2D subset_radius)
 	{
 		//set instance w.r.t. thread id
-		ICGN2D1_* cur_instance = getInstance(omp_get_thread_num());
+		ICGN2D1_* cur_instance = workspace.local();
 
 		//update the instance according to the subset dimension of current POI
 		ICGN2D1_::update(cur_instance, poi->subset_radius.x, poi->subset_radius.y);
@@ -486,12 +547,7 @@ namespace opencorr
 
 	void ICGN2D1::compute(std::vector<POI2D>& poi_queue, Point2D subset_radius)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i], subset_radius);
-		}
+		scheduler.run(poi_queue, [this, subset_radius](POI2D* poi) { compute(poi, subset_radius); });
 	}
 
 	//////////////////////////////////////////////////////////////////////////////
@@ -548,18 +604,27 @@ namespace opencorr
 		instance->sd_img = new3D(subset_height, subset_width, 12);
 	}
 
-	ICGN2D2_* ICGN2D2::getInstance(int tid)
+	ICGN2D2_* ICGN2D2::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
+		ICGN2D2_* instance = workspace.local();
+
+		//follow the subset radius of engine, which may be changed after the instance is created
+		if (instance->ref_subset->radius_x != subset_radius_x || instance->ref_subset->radius_y != subset_radius_y)
 		{
-			throw std::string("CPU thread ID over limit");
+			ICGN2D2_::update(instance, subset_radius_x, subset_radius_y);
 		}
 
-		return instance_pool[tid];
+		return instance;
 	}
 
 	ICGN2D2::ICGN2D2(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number)
-		: ref_gradient(nullptr), tar_interp(nullptr)
+		: ref_gradient(nullptr), tar_interp(nullptr),
+		workspace([this] { return ICGN2D2_::allocate(this->subset_radius_x, this->subset_radius_y); },
+			[](ICGN2D2_* instance)
+			{
+				ICGN2D2_::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
@@ -567,24 +632,12 @@ namespace opencorr
 		this->stop_condition = stop_condition;
 
 		this->thread_number = thread_number;
-		for (int i = 0; i < thread_number; i++)
-		{
-			ICGN2D2_* instance = ICGN2D2_::allocate(subset_radius_x, subset_radius_y);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	ICGN2D2::~ICGN2D2()
 	{
 		delete ref_gradient;
 		delete tar_interp;
-
-		for (auto& instance : instance_pool)
-		{
-			ICGN2D2_::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	void ICGN2D2::setIteration(float conv_criterion, float stop_condition)
@@ -633,7 +686,7 @@ namespace opencorr
 	void ICGN2D2::compute(POI2D* poi)
 	{
 		//set instance w.r.t. thread id 
-		ICGN2D2_* cur_instance = getInstance(omp_get_thread_num());
+		ICGN2D2_* cur_instance = getInstance();
 
 		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
 			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1
@@ -821,12 +874,7 @@ namespace opencorr
 
 	void ICGN2D2::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
 	}
 
 
@@ -893,17 +941,28 @@ namespace opencorr
 		instance->sd_img = new4D(dim_z, dim_y, dim_x, 12);
 	}
 
-	ICGN3D1_* ICGN3D1::getInstance(int tid)
+	ICGN3D1_* ICGN3D1::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
+		ICGN3D1_* instance = workspace.local();
+
+		//follow the subset radius of engine, which may be changed after the instance is created
+		if (instance->ref_subset->radius_x != subset_radius_x || instance->ref_subset->radius_y != subset_radius_y
+			|| instance->ref_subset->radius_z != subset_radius_z)
 		{
-			throw std::string("CPU thread ID over limit");
+			ICGN3D1_::update(instance, subset_radius_x, subset_radius_y, subset_radius_z);
 		}
-		return instance_pool[tid];
+
+		return instance;
 	}
 
 	ICGN3D1::ICGN3D1(int subset_radius_x, int subset_radius_y, int subset_radius_z, float conv_criterion, float stop_condition, int thread_number)
-		: ref_gradient(nullptr), tar_interp(nullptr)
+		: ref_gradient(nullptr), tar_interp(nullptr),
+		workspace([this] { return ICGN3D1_::allocate(this->subset_radius_x, this->subset_radius_y, this->subset_radius_z); },
+			[](ICGN3D1_* instance)
+			{
+				ICGN3D1_::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
@@ -911,25 +970,12 @@ namespace opencorr
 		this->conv_criterion = conv_criterion;
 		this->stop_condition = stop_condition;
 		this->thread_number = thread_number;
-
-		for (int i = 0; i < thread_number; i++)
-		{
-			ICGN3D1_* instance = ICGN3D1_::allocate(subset_radius_x, subset_radius_y, subset_radius_z);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	ICGN3D1::~ICGN3D1()
 	{
 		delete ref_gradient;
 		delete tar_interp;
-
-		for (auto& instance : instance_pool)
-		{
-			ICGN3D1_::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	void ICGN3D1::setIteration(float conv_criterion, float stop_condition)
@@ -979,7 +1025,7 @@ namespace opencorr
 	void ICGN3D1::compute(POI3D* poi)
 	{
 		//set instance w.r.t. thread id 
-		ICGN3D1_* cur_instance = getInstance(omp_get_thread_num());
+		ICGN3D1_* cur_instance = getInstance();
 
 		if ((poi->x - subset_radius_x) < 0 || (poi->y - subset_radius_y) < 0 || (poi->z - subset_radius_z) < 0
 			|| (poi->x + subset_radius_x) > (ref_img->dim_x - 1) || (poi->y + subset_radius_y) > (ref_img->dim_y - 1) || (poi->z + subset_radius_z) > (ref_img->dim_z - 1)
@@ -1172,12 +1218,7 @@ namespace opencorr
 
 	void ICGN3D1::compute(std::vector<POI3D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI3D* poi) { compute(poi); });
 	}
 
 }//namespace opencorr
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include "oc_poi.h"
 #include "oc_point.h"
 #include "oc_subset.h"
+#include "oc_workspace.h"
 
 namespace opencorr
 {
@@ -40,6 +41,8 @@ namespace opencorr
 		Eigen::MatrixXf error_img;
 		Matrix6f hessian, inv_hessian;
 		float*** sd_img; //steepest descent image
+		float ref_mean_norm; //zero-mean norm of reference subset
+		bool ref_prepared; //reference subset is built by prepareCandidates() and has texture
 
 		static ICGN2D1_* allocate(int subset_radius_x, int subset_radius_y);
 		static void release(ICGN2D1_* instance);
@@ -55,8 +58,11 @@ namespace opencorr
 		float conv_criterion; //convergence criterion: norm of maximum deformation increment in subset
 		float stop_condition; //stop condition: max iteration
 
-		std::vector<ICGN2D1_*> instance_pool; //pool of instances for multi-thread processing
-		ICGN2D1_* getInstance(int tid); //get an instance according to the number of current thread id
+		Workspace<ICGN2D1_> workspace; //instances of the threads running this engine
+		ICGN2D1_* getInstance(); //instance of calling thread
+
+		void setRefSubset(ICGN2D1_* instance, POI2D* poi); //fill reference subset and build the inversed Hessian matrix
+		void iterate(ICGN2D1_* instance, POI2D* poi, float prune_zncc); //IC-GN iteration starting from the deformation of POI
 
 	public:
 		ICGN2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number);
@@ -69,6 +75,14 @@ namespace opencorr
 		void compute(POI2D* poi);
 		void compute(std::vector<POI2D>& poi_queue);
 
+		//functions for multiple candidates of one POI, e.g. the trials along epipolar line,
+		//the reference subset and its Hessian matrix are built once in the instance of current thread,
+		//candidates with ZNCC of initial guess lower than prune_zncc are not iterated further.
+		//prepareCandidates() returns false for a subset out of image or without texture, then the ZNCC of
+		//candidates is set as -1
+		bool prepareCandidates(POI2D* poi);
+		void computeCandidate(POI2D* candidate, float prune_zncc);
+
 		void setIteration(float conv_criterion, float stop_condition);
 		void setIteration(POI2D* poi);
 
@@ -106,8 +120,8 @@ namespace opencorr
 		float conv_criterion;
 		float stop_condition;
 
-		std::vector<ICGN2D2_*> instance_pool;
-		ICGN2D2_* getInstance(int tid);
+		Workspace<ICGN2D2_> workspace;
+		ICGN2D2_* getInstance();
 
 	public:
 		ICGN2D2(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number);
@@ -153,8 +167,8 @@ namespace opencorr
 		float conv_criterion; //convergence criterion: norm of maximum displacement increment in subset
 		float stop_condition; //stop condition: max iteration
 
-		std::vector<ICGN3D1_*> instance_pool; //pool of instances for multi-thread processing
-		ICGN3D1_* getInstance(int tid); //get an instance according to the number of current thread id
+		Workspace<ICGN3D1_> workspace; //instances of the threads running this engine
+		ICGN3D1_* getInstance(); //instance of calling thread
 
 	public:
 		ICGN3D1(int subset_radius_x, int subset_radius_y, int subset_radius_z,
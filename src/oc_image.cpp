@@ -12,12 +12,82 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <cstring>
 #include <fstream>
 
+#include "oc_columnar.h"
 #include "oc_image.h"
 
 namespace opencorr
 {
+	static size_t pixelSize(int pixel_type)
+	{
+		switch (pixel_type)
+		{
+		case PIXEL_UINT8:
+			return sizeof(uint8_t);
+		case PIXEL_UINT16:
+			return sizeof(uint16_t);
+		case PIXEL_FLOAT32:
+			return sizeof(float);
+		default:
+			throw std::string("Unknown type of pixel in buffer");
+		}
+	}
+
+	//convert a row of pixels into floats, output_step is the number of floats between neighbouring outputs
+	static void convertRow(const char* row, int pixel_type, int length, float* output, size_t output_step)
+	{
+		switch (pixel_type)
+		{
+		case PIXEL_UINT8:
+			for (int i = 0; i < length; i++)
+			{
+				output[i * output_step] = (float)((const uint8_t*)row)[i];
+			}
+			break;
+		case PIXEL_UINT16:
+			for (int i = 0; i < length; i++)
+			{
+				uint16_t value;
+				std::memcpy(&value, row + sizeof(uint16_t) * i, sizeof(uint16_t));
+				output[i * output_step] = (float)value;
+			}
+			break;
+		default:
+			for (int i = 0; i < length; i++)
+			{
+				float value;
+				std::memcpy(&value, row + sizeof(float) * i, sizeof(float));
+				output[i * output_step] = value;
+			}
+			break;
+		}
+	}
+
+	//fill the default steps of packed data and check the given ones
+	static void checkSteps(const void* data, int dim_x, int dim_y, int dim_z, int pixel_type, size_t& row_step, size_t& slice_step)
+	{
+		if (data == nullptr || dim_x <= 0 || dim_y <= 0 || dim_z <= 0)
+		{
+			throw std::string("Invalid buffer of image");
+		}
+
+		size_t pixel_size = pixelSize(pixel_type);
+		if (row_step == 0)
+		{
+			row_step = pixel_size * dim_x;
+		}
+		if (slice_step == 0)
+		{
+			slice_step = row_step * dim_y;
+		}
+		if (row_step < pixel_size * dim_x || slice_step < row_step * (dim_y - 1) + pixel_size * dim_x)
+		{
+			throw std::string("Steps of buffer are smaller than the size of image");
+		}
+	}
+
 	//2D image
 	Image2D::Image2D(int width, int height)
 	{
@@ -43,6 +113,12 @@ namespace opencorr
 		cv::cv2eigen(cv_mat, eg_mat);
 	}
 
+	Image2D::Image2D(const void* data, int width, int height, int pixel_type, size_t row_step)
+		: height(0), width(0)
+	{
+		load(data, width, height, pixel_type, row_step);
+	}
+
 	void Image2D::load(std::string file_path)
 	{
 		cv_mat = cv::imread(file_path, cv::IMREAD_GRAYSCALE);
@@ -64,6 +140,32 @@ namespace opencorr
 		cv::cv2eigen(cv_mat, eg_mat);
 	}
 
+	void Image2D::load(const void* data, int width, int height, int pixel_type, size_t row_step)
+	{
+		size_t slice_step = 0;
+		checkSteps(data, width, height, 1, pixel_type, row_step, slice_step);
+
+		int cv_type = pixel_type == PIXEL_UINT8 ? CV_8UC1 : (pixel_type == PIXEL_UINT16 ? CV_16UC1 : CV_32FC1);
+		cv_mat = cv::Mat(height, width, cv_type, const_cast<void*>(data), row_step);
+		file_path.clear();
+
+		if (this->width != width || this->height != height)
+		{
+			this->width = width;
+			this->height = height;
+			eg_mat.resize(height, width);
+		}
+
+		//eg_mat is column-major, each row of frame is written with a stride of height
+		const char* frame_data = (const char*)data;
+		float* matrix_data = eg_mat.data();
+#pragma omp parallel for
+		for (int r = 0; r < height; r++)
+		{
+			convertRow(frame_data + row_step * r, pixel_type, width, matrix_data + r, (size_t)height);
+		}
+	}
+
 
 	//3D image
 	Image3D::Image3D(int dim_x, int dim_y, int dim_z)
@@ -93,21 +195,108 @@ namespace opencorr
 		}
 	}
 
+	Image3D::Image3D(float* data, int dim_x, int dim_y, int dim_z, int ownership, size_t row_step, size_t slice_step,
+		std::function<void(float*)> deleter)
+		: dim_x(0), dim_y(0), dim_z(0)
+	{
+		attach(data, dim_x, dim_y, dim_z, ownership, row_step, slice_step, deleter);
+	}
+
 	Image3D::~Image3D()
 	{
-		if (vol_mat != nullptr)
+		release();
+	}
+
+	void Image3D::release()
+	{
+		if (vol_mat == nullptr)
+		{
+			return;
+		}
+
+		if (buffer == nullptr)
 		{
 			delete3D(vol_mat);
+			return;
+		}
+
+		//only the tables of row pointers belong to the image
+		free(vol_mat[0]);
+		free(vol_mat);
+		vol_mat = nullptr;
+
+		if (buffer_deleter)
+		{
+			buffer_deleter(buffer);
 		}
+		buffer = nullptr;
+		buffer_deleter = nullptr;
 	}
 
-	void Image3D::loadBin(std::string file_path)
+	void Image3D::attach(float* data, int dim_x, int dim_y, int dim_z, int ownership, size_t row_step, size_t slice_step,
+		std::function<void(float*)> deleter)
 	{
-		if (vol_mat != nullptr)
+		checkSteps(data, dim_x, dim_y, dim_z, PIXEL_FLOAT32, row_step, slice_step);
+		if (row_step % sizeof(float) != 0 || slice_step % sizeof(float) != 0)
 		{
-			delete3D(vol_mat);
+			throw std::string("Steps of float buffer must be multiples of 4 bytes");
+		}
+
+		release();
+
+		float** row_table = (float**)malloc(sizeof(float*) * dim_z * dim_y);
+		vol_mat = (float***)malloc(sizeof(float**) * dim_z);
+		for (int i = 0; i < dim_z; i++)
+		{
+			for (int j = 0; j < dim_y; j++)
+			{
+				row_table[i * dim_y + j] = (float*)((char*)data + slice_step * i + row_step * j);
+			}
+			vol_mat[i] = row_table + i * dim_y;
+		}
+
+		buffer = data;
+		if (ownership == BUFFER_ADOPT)
+		{
+			buffer_deleter = deleter ? deleter : [](float* data) { free(data); };
+		}
+
+		file_path.clear();
+		this->dim_x = dim_x;
+		this->dim_y = dim_y;
+		this->dim_z = dim_z;
+	}
+
+	void Image3D::load(const void* data, int dim_x, int dim_y, int dim_z, int pixel_type, size_t row_step, size_t slice_step)
+	{
+		checkSteps(data, dim_x, dim_y, dim_z, pixel_type, row_step, slice_step);
+
+		if (buffer != nullptr || vol_mat == nullptr || this->dim_x != dim_x || this->dim_y != dim_y || this->dim_z != dim_z)
+		{
+			release();
+			vol_mat = new3D(dim_z, dim_y, dim_x);
 		}
 
+		file_path.clear();
+		this->dim_x = dim_x;
+		this->dim_y = dim_y;
+		this->dim_z = dim_z;
+
+		const char* volume_data = (const char*)data;
+		long long row_number = (long long)dim_z * dim_y;
+#pragma omp parallel for
+		for (long long i = 0; i < row_number; i++)
+		{
+			int z = (int)(i / dim_y);
+			int y = (int)(i % dim_y);
+			convertRow(volume_data + slice_step * z + row_step * y, pixel_type, dim_x, vol_mat[z][y], 1);
+		}
+	}
+
+	void Image3D::loadBin(std::string file_path)
+	{
+		release();
+
 		std::ifstream file_in;
 		file_in.open(file_path, std::ios::in | std::ios::binary);
 
@@ -139,12 +328,81 @@ namespace opencorr
 		file_in.close();
 	}
 
-	void Image3D::loadTiff(std::string file_path)
+	//validate the header of a bin file against the size of file
+	static void readBinHeader(const MappedFile& mapped_file, std::string file_path, int dimension[3])
 	{
-		if (vol_mat != nullptr)
+		if (mapped_file.size() < sizeof(int) * 3)
 		{
-			delete3D(vol_mat);
+			throw std::string("Invalid bin file: " + file_path);
 		}
+		std::memcpy(dimension, mapped_file.data(), sizeof(int) * 3);
+
+		uint64_t voxel_number = (uint64_t)mapped_file.size() / sizeof(float);
+		if (dimension[0] <= 0 || dimension[1] <= 0 || dimension[2] <= 0
+			|| (uint64_t)dimension[0] * dimension[1] * dimension[2] > voxel_number - 3)
+		{
+			throw std::string("Invalid bin file: " + file_path);
+		}
+	}
+
+	void Image3D::getBinDimension(std::string file_path, int& dim_x, int& dim_y, int& dim_z)
+	{
+		MappedFile mapped_file;
+		if (!mapped_file.open(file_path))
+		{
+			throw std::string("Failed to map file " + file_path);
+		}
+
+		int dimension[3];
+		readBinHeader(mapped_file, file_path, dimension);
+		dim_x = dimension[0];
+		dim_y = dimension[1];
+		dim_z = dimension[2];
+	}
+
+	void Image3D::loadBin(std::string file_path, int begin_x, int begin_y, int begin_z, int dim_x, int dim_y, int dim_z)
+	{
+		MappedFile mapped_file;
+		if (!mapped_file.open(file_path))
+		{
+			throw std::string("Failed to map file " + file_path);
+		}
+
+		int dimension[3];
+		readBinHeader(mapped_file, file_path, dimension);
+		if (dim_x <= 0 || dim_y <= 0 || dim_z <= 0 || begin_x < 0 || begin_y < 0 || begin_z < 0
+			|| begin_x + dim_x > dimension[0] || begin_y + dim_y > dimension[1] || begin_z + dim_z > dimension[2])
+		{
+			throw std::string("Block exceeds the volume in bin file: " + file_path);
+		}
+
+		if (buffer != nullptr || vol_mat == nullptr || this->dim_x != dim_x || this->dim_y != dim_y || this->dim_z != dim_z)
+		{
+			release();
+			vol_mat = new3D(dim_z, dim_y, dim_x);
+		}
+
+		this->file_path = file_path;
+		this->dim_x = dim_x;
+		this->dim_y = dim_y;
+		this->dim_z = dim_z;
+
+		//the rows of block are copied from the mapped file, 64-bit offsets for volumes larger than 4 GB
+		const float* volume_data = (const float*)(mapped_file.data() + sizeof(int) * 3);
+		long long row_number = (long long)dim_z * dim_y;
+#pragma omp parallel for
+		for (long long i = 0; i < row_number; i++)
+		{
+			int z = (int)(i / dim_y);
+			int y = (int)(i % dim_y);
+			size_t row_offset = ((size_t)(begin_z + z) * dimension[1] + (begin_y + y)) * dimension[0] + begin_x;
+			std::memcpy(vol_mat[z][y], volume_data + row_offset, sizeof(float) * dim_x);
+		}
+	}
+
+	void Image3D::loadTiff(std::string file_path)
+	{
+		release();
 
 		//read a tiff image consisting of multiple pages and store it in a vector of cv::Mat
 		std::vector<cv::Mat> tiff_mat;
@@ -17,6 +17,8 @@
 #ifndef _IMAGE_H_
 #define _IMAGE_H_
 
+#include <cstdint>
+#include <functional>
 #include <Eigen>
 #include <opencv2/opencv.hpp>
 #include <opencv2/world.hpp>
@@ -26,6 +28,21 @@
 
 namespace opencorr
 {
+	//type of pixels or voxels in caller's buffer
+	enum PixelType
+	{
+		PIXEL_UINT8 = 0,
+		PIXEL_UINT16 = 1,
+		PIXEL_FLOAT32 = 2
+	};
+
+	//how Image3D holds caller's buffer
+	enum BufferOwnership
+	{
+		BUFFER_VIEW = 0, //the caller keeps the buffer valid and unchanged until the image is reloaded or destroyed
+		BUFFER_ADOPT = 1 //the image releases the buffer with the given deleter, or free() if none
+	};
+
 	class Image2D
 	{
 	public:
@@ -38,9 +55,16 @@ namespace opencorr
 
 		Image2D(int width, int height);
 		Image2D(std::string file_path);
+		Image2D(const void* data, int width, int height, int pixel_type, size_t row_step = 0);
 		~Image2D() = default;
 
 		void load(std::string file_path);
+
+		//take a frame from caller's buffer instead of file, row_step is the number of bytes between neighbouring
+		//rows (0 for packed rows). cv_mat becomes a header on the buffer without copy, thus the buffer must stay
+		//valid while cv_mat is used (SIFT requires PIXEL_UINT8). eg_mat, used by the other 2D modules, is filled
+		//in one parallel pass and keeps its memory if the size of frame does not change
+		void load(const void* data, int width, int height, int pixel_type, size_t row_step = 0);
 	};
 
 	class Image3D
@@ -53,11 +77,34 @@ namespace opencorr
 
 		Image3D(int dim_x, int dim_y, int dim_z);
 		Image3D(std::string file_path);
+		Image3D(float* data, int dim_x, int dim_y, int dim_z, int ownership, size_t row_step = 0, size_t slice_step = 0,
+			std::function<void(float*)> deleter = nullptr);
 		~Image3D();
 
 		void loadBin(std::string file_path);
 		void loadTiff(std::string file_path);
 		void load(std::string file_path);
+
+		//load the block [begin_x, begin_x + dim_x) x [begin_y, begin_y + dim_y) x [begin_z, begin_z + dim_z) of
+		//a bin file through memory mapping, only the pages holding the block are read from disk
+		void loadBin(std::string file_path, int begin_x, int begin_y, int begin_z, int dim_x, int dim_y, int dim_z);
+		static void getBinDimension(std::string file_path, int& dim_x, int& dim_y, int& dim_z); //read the header only
+
+		//view or adopt caller's buffer of float voxels arranged as [z][y][x], without copy. row_step and
+		//slice_step are the numbers of bytes between neighbouring rows and slices (0 for packed data), only
+		//the tables of row pointers are allocated
+		void attach(float* data, int dim_x, int dim_y, int dim_z, int ownership, size_t row_step = 0, size_t slice_step = 0,
+			std::function<void(float*)> deleter = nullptr);
+
+		//convert caller's buffer of any PixelType into the image in one parallel pass, the buffer is not kept
+		//after return. The memory of image is reused if the dimensions do not change
+		void load(const void* data, int dim_x, int dim_y, int dim_z, int pixel_type, size_t row_step = 0, size_t slice_step = 0);
+
+	private:
+		float* buffer = nullptr; //caller's buffer, nullptr if vol_mat owns its data
+		std::function<void(float*)> buffer_deleter; //empty for a viewed buffer
+
+		void release();
 	};
 
 }//namespace opencorr
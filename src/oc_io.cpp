@@ -12,13 +12,840 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
+#include <omp.h>
 
 #include "oc_io.h"
 
 namespace opencorr
 {
+	//parse a float in [begin, end), plain decimal numbers with up to 15 significant digits are converted with one
+	//multiplication or division in double, which is exact for the powers of 10 used here, others go to strtof
+	static float parseFloat(const char* begin, const char* end)
+	{
+		static const double power10[13] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12 };
+
+		const char* p = begin;
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+		const char* token = p;
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			p++;
+		}
+
+		unsigned long long mantissa = 0;
+		int significant_digits = 0, digit_number = 0, exponent = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			significant_digits += (mantissa != 0);
+			digit_number++;
+			p++;
+			if (significant_digits > 15)
+			{
+				break;
+			}
+		}
+		if (p < end && *p == '.' && significant_digits <= 15)
+		{
+			p++;
+			while (p < end && *p >= '0' && *p <= '9')
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				significant_digits += (mantissa != 0);
+				digit_number++;
+				exponent--;
+				p++;
+				if (significant_digits > 15)
+				{
+					break;
+				}
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E') && digit_number > 0)
+		{
+			const char* q = p + 1;
+			bool negative_exponent = false;
+			if (q < end && (*q == '-' || *q == '+'))
+			{
+				negative_exponent = (*q == '-');
+				q++;
+			}
+			int exponent_value = 0;
+			while (q < end && *q >= '0' && *q <= '9' && exponent_value < 1000)
+			{
+				exponent_value = exponent_value * 10 + (*q - '0');
+				q++;
+			}
+			exponent += negative_exponent ? -exponent_value : exponent_value;
+			p = q;
+		}
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+
+		//the division in double is rounded to float once more. For a mantissa of up to 15 digits and 10^k with k <= 12,
+		//a decimal that is not a midpoint of floats stays farther from the midpoint than half an ulp of double, thus
+		//the twice rounded value is the same as strtof. It covers the output of formatFixed() with 8 decimals
+		if (p == end && digit_number > 0 && significant_digits <= 15 && exponent >= -12 && exponent <= 0)
+		{
+			double value = (double)mantissa / power10[-exponent];
+			return (float)(negative ? -value : value);
+		}
+
+		//fall back for long numbers, nan, inf and irregular tokens
+		char buffer[64];
+		size_t length = std::min((size_t)(end - token), sizeof(buffer) - 1);
+		std::memcpy(buffer, token, length);
+		buffer[length] = '\0';
+		return std::strtof(buffer, nullptr);
+	}
+
+	//write a float in fixed notation with 8 decimals, the same as the output of iostream in fixed mode with
+	//precision of 8. The fraction of a float times 1e8 is exact in double, thus the rounding (half to even)
+	//is done once. Up to 64 characters are written, the end of output is returned
+	char* formatFixed(float value, char* output)
+	{
+		double magnitude = std::fabs((double)value);
+		if (!(magnitude < 1e15))
+		{
+			int length = std::snprintf(output, 64, "%.8f", (double)value);
+			return output + length;
+		}
+
+		if (std::signbit(value))
+		{
+			*output++ = '-';
+		}
+
+		double integer_part = std::floor(magnitude);
+		unsigned long long integer = (unsigned long long)integer_part;
+		unsigned long long fraction = (unsigned long long)std::nearbyint((magnitude - integer_part) * 1e8);
+		if (fraction >= 100000000ULL)
+		{
+			integer++;
+			fraction -= 100000000ULL;
+		}
+
+		char digits[20];
+		int digit_number = 0;
+		do
+		{
+			digits[digit_number++] = (char)('0' + integer % 10);
+			integer /= 10;
+		} while (integer > 0);
+		while (digit_number > 0)
+		{
+			*output++ = digits[--digit_number];
+		}
+
+		*output++ = '.';
+		for (int i = 7; i >= 0; i--)
+		{
+			output[i] = (char)('0' + fraction % 10);
+			fraction /= 10;
+		}
+
+		return output + 8;
+	}
+
+	//get the next non-blank row from position, the line break is excluded
+	static bool nextRow(const char*& position, const char* end, const char*& row_begin, const char*& row_end)
+	{
+		while (position < end)
+		{
+			const char* line_end = (const char*)std::memchr(position, '\n', end - position);
+			if (line_end == nullptr)
+			{
+				line_end = end;
+			}
+
+			row_begin = position;
+			row_end = line_end;
+			position = line_end < end ? line_end + 1 : end;
+
+			if (row_end > row_begin && *(row_end - 1) == '\r')
+			{
+				row_end--;
+			}
+
+			const char* c = row_begin;
+			while (c < row_end && (*c == ' ' || *c == '\t'))
+			{
+				c++;
+			}
+			if (c < row_end)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//get the first field_number values in a row, empty fields are skipped and missing values are set as 0
+	static void parseRow(const char* row_begin, const char* row_end, const string& delimiter, int field_number, float* values)
+	{
+		size_t delimiter_length = delimiter.length();
+		const char* p = row_begin;
+		int value_number = 0;
+
+		while (p < row_end && value_number < field_number)
+		{
+			const char* q = delimiter_length == 1 ? (const char*)std::memchr(p, delimiter[0], row_end - p)
+				: std::search(p, row_end, delimiter.begin(), delimiter.end());
+			if (q == nullptr)
+			{
+				q = row_end;
+			}
+
+			if (q > p)
+			{
+				values[value_number++] = parseFloat(p, q);
+			}
+
+			p = q + delimiter_length;
+		}
+
+		for (; value_number < field_number; value_number++)
+		{
+			values[value_number] = 0.f;
+		}
+	}
+
+	//read a csv table skipping its header line, the file is mapped and split at line boundaries across threads.
+	//values of rows are stored in sequence, field_number values per row, the number of rows is returned
+	static size_t loadCSV(const string& file_path, const string& delimiter, int field_number, vector<float>& values)
+	{
+		MappedFile mapped_file;
+		if (!mapped_file.open(file_path))
+		{
+			std::cerr << "failed to read file " << file_path << std::endl;
+			values.clear();
+			return 0;
+		}
+
+		const char* begin = mapped_file.data();
+		const char* end = begin + mapped_file.size();
+		const char* header_end = (const char*)std::memchr(begin, '\n', end - begin);
+		begin = header_end == nullptr ? end : header_end + 1;
+
+		//each chunk holds the rows beginning in it
+		int chunk_number = std::max(1, std::min(omp_get_max_threads(), (int)((end - begin) / 65536) + 1));
+		vector<const char*> chunk_begin(chunk_number + 1, end);
+		for (int i = 0; i < chunk_number; i++)
+		{
+			const char* p = begin + (end - begin) * i / chunk_number;
+			if (p > begin && *(p - 1) != '\n')
+			{
+				const char* line_end = (const char*)std::memchr(p, '\n', end - p);
+				p = line_end == nullptr ? end : line_end + 1;
+			}
+			chunk_begin[i] = p;
+		}
+
+		//count rows in chunks, then parse them to their final positions
+		vector<size_t> chunk_rows(chunk_number + 1, 0);
+#pragma omp parallel for
+		for (int i = 0; i < chunk_number; i++)
+		{
+			const char* position = chunk_begin[i];
+			const char* row_begin;
+			const char* row_end;
+			size_t row_number = 0;
+			while (position < chunk_begin[i + 1] && nextRow(position, chunk_begin[i + 1], row_begin, row_end))
+			{
+				row_number++;
+			}
+			chunk_rows[i + 1] = row_number;
+		}
+		for (int i = 0; i < chunk_number; i++)
+		{
+			chunk_rows[i + 1] += chunk_rows[i];
+		}
+
+		values.resize(chunk_rows[chunk_number] * field_number);
+#pragma omp parallel for
+		for (int i = 0; i < chunk_number; i++)
+		{
+			const char* position = chunk_begin[i];
+			const char* row_begin;
+			const char* row_end;
+			float* row_values = values.data() + chunk_rows[i] * field_number;
+			while (position < chunk_begin[i + 1] && nextRow(position, chunk_begin[i + 1], row_begin, row_end))
+			{
+				parseRow(row_begin, row_end, delimiter, field_number, row_values);
+				row_values += field_number;
+			}
+		}
+
+		return chunk_rows[chunk_number];
+	}
+
+	//write rows of a csv table, each thread formats a block of rows into its own buffer, then the buffers are
+	//written in order. get_row fills the values of a POI
+	template <typename T, typename F>
+	static void saveCSV(std::ofstream& file_out, vector<T>& poi_queue, const string& delimiter, int field_number, F get_row)
+	{
+		const long long block_rows = 4096;
+		int thread_number = omp_get_max_threads();
+		long long queue_length = (long long)poi_queue.size();
+		size_t row_capacity = field_number * (64 + delimiter.length()) + 1;
+
+		vector<vector<char>> buffer(thread_number, vector<char>(block_rows * row_capacity));
+		vector<size_t> buffer_size(thread_number, 0);
+
+		for (long long block_begin = 0; block_begin < queue_length; block_begin += block_rows * thread_number)
+		{
+#pragma omp parallel for
+			for (int t = 0; t < thread_number; t++)
+			{
+				long long row_begin = block_begin + block_rows * t;
+				long long row_end = std::min(row_begin + block_rows, queue_length);
+				char* output = buffer[t].data();
+				float row_values[64];
+
+				for (long long i = row_begin; i < row_end; i++)
+				{
+					get_row(poi_queue[i], row_values);
+					for (int j = 0; j < field_number; j++)
+					{
+						output = formatFixed(row_values[j], output);
+						std::memcpy(output, delimiter.data(), delimiter.length());
+						output += delimiter.length();
+					}
+					*output++ = '\n';
+				}
+				buffer_size[t] = output - buffer[t].data();
+			}
+
+			for (int t = 0; t < thread_number; t++)
+			{
+				file_out.write(buffer[t].data(), buffer_size[t]);
+			}
+		}
+	}
+
+	//byte offset of a variable in POI for maps, -1 for unknown variable
+	static long long getMapOffset(POI2D& poi, char variable)
+	{
+		const float* field = nullptr;
+		switch (variable)
+		{
+		case 'u': field = &poi.deformation.u; break;
+		case 'v': field = &poi.deformation.v; break;
+		case 'c': field = &poi.result.zncc; break; //ZNCC value
+		case 'd': field = &poi.result.convergence; break; //final ||delta_p||
+		case 'i': field = &poi.result.iteration; break; //iteration steps
+		case 'f': field = &poi.result.feature; break; //number of neighbor features
+		case 'x': field = &poi.strain.exx; break;
+		case 'y': field = &poi.strain.eyy; break;
+		case 'r': field = &poi.strain.exy; break;
+		default: return -1;
+		}
+		return (long long)((const char*)field - (const char*)&poi);
+	}
+
+	static long long getMapOffset(POI2DS& poi, char variable)
+	{
+		const float* field = nullptr;
+		switch (variable)
+		{
+		case 'u': field = &poi.deformation.u; break;
+		case 'v': field = &poi.deformation.v; break;
+		case 'w': field = &poi.deformation.w; break;
+		case 'c': field = &poi.result.r1r2_zncc; break;
+		case 'd': field = &poi.result.r1t1_zncc; break;
+		case 'e': field = &poi.result.r1t2_zncc; break;
+		case 'x': field = &poi.strain.exx; break;
+		case 'y': field = &poi.strain.eyy; break;
+		case 'z': field = &poi.strain.ezz; break;
+		case 'r': field = &poi.strain.exy; break;
+		case 's': field = &poi.strain.eyz; break;
+		case 't': field = &poi.strain.ezx; break;
+		default: return -1;
+		}
+		return (long long)((const char*)field - (const char*)&poi);
+	}
+
+	static long long getMapOffset(POI3D& poi, char variable)
+	{
+		const float* field = nullptr;
+		switch (variable)
+		{
+		case 'u': field = &poi.deformation.u; break;
+		case 'v': field = &poi.deformation.v; break;
+		case 'w': field = &poi.deformation.w; break;
+		case 'c': field = &poi.result.zncc; break;
+		case 'x': field = &poi.strain.exx; break;
+		case 'y': field = &poi.strain.eyy; break;
+		case 'z': field = &poi.strain.ezz; break;
+		case 'r': field = &poi.strain.exy; break;
+		case 's': field = &poi.strain.eyz; break;
+		case 't': field = &poi.strain.ezx; break;
+		default: return -1;
+		}
+		return (long long)((const char*)field - (const char*)&poi);
+	}
+
+	static inline int getMapZ(Point2D&)
+	{
+		return 0;
+	}
+
+	static inline int getMapZ(Point3D& point)
+	{
+		return (int)point.z;
+	}
+
+	//cell of map where a POI falls, -1 for the POIs out of map
+	template <typename T>
+	static long long getMapCell(T& poi, int map_dimension[3], int downsampling)
+	{
+		int x = (int)poi.x;
+		int y = (int)poi.y;
+		int z = getMapZ(poi);
+		if (x < 0 || y < 0 || z < 0)
+		{
+			return -1;
+		}
+		x /= downsampling;
+		y /= downsampling;
+		z /= downsampling;
+		if (x >= map_dimension[0] || y >= map_dimension[1] || z >= map_dimension[2])
+		{
+			return -1;
+		}
+		return ((long long)z * map_dimension[1] + y) * map_dimension[0] + x;
+	}
+
+	//rasterize the variables of POIs onto dense maps, the maps are stored one after another, with x the fastest.
+	//When downsampling is 1, the last POI in queue is kept among the POIs at the same pixel, otherwise POIs in a cell
+	//are averaged, summed in the order of queue so that the maps do not depend on the number of threads
+	template <typename T>
+	static void rasterizeMaps(vector<T>& poi_queue, vector<long long>& field_offsets, int map_dimension[3], int downsampling,
+		vector<float>& maps)
+	{
+		int variable_number = (int)field_offsets.size();
+		size_t map_size = (size_t)map_dimension[0] * map_dimension[1] * map_dimension[2];
+		maps.assign(map_size * variable_number, 0.f);
+
+		long long queue_length = (long long)poi_queue.size();
+		if (downsampling == 1)
+		{
+			//a serial pass marks the last POI at each pixel, then only that POI writes the pixel
+			vector<long long> cell_owner(map_size, -1);
+			for (long long i = 0; i < queue_length; i++)
+			{
+				long long cell = getMapCell(poi_queue[i], map_dimension, downsampling);
+				if (cell >= 0)
+				{
+					cell_owner[cell] = i;
+				}
+			}
+
+#pragma omp parallel for
+			for (long long i = 0; i < queue_length; i++)
+			{
+				long long cell = getMapCell(poi_queue[i], map_dimension, downsampling);
+				if (cell < 0 || cell_owner[cell] != i)
+				{
+					continue;
+				}
+				const char* poi_data = (const char*)&poi_queue[i];
+				for (int v = 0; v < variable_number; v++)
+				{
+					maps[map_size * v + cell] = *(const float*)(poi_data + field_offsets[v]);
+				}
+			}
+			return;
+		}
+
+		//group the POIs by cell with a counting sort, which keeps the order of queue within each cell
+		vector<long long> poi_cell(queue_length);
+#pragma omp parallel for
+		for (long long i = 0; i < queue_length; i++)
+		{
+			poi_cell[i] = getMapCell(poi_queue[i], map_dimension, downsampling);
+		}
+
+		vector<long long> cell_begin(map_size + 1, 0);
+		for (long long i = 0; i < queue_length; i++)
+		{
+			if (poi_cell[i] >= 0)
+			{
+				cell_begin[poi_cell[i] + 1]++;
+			}
+		}
+		for (size_t i = 0; i < map_size; i++)
+		{
+			cell_begin[i + 1] += cell_begin[i];
+		}
+
+		vector<long long> cell_poi(cell_begin[map_size]);
+		vector<long long> cell_fill(cell_begin.begin(), cell_begin.end() - 1);
+		for (long long i = 0; i < queue_length; i++)
+		{
+			if (poi_cell[i] >= 0)
+			{
+				cell_poi[cell_fill[poi_cell[i]]++] = i;
+			}
+		}
+
+		//each cell is averaged by a single thread
+		long long cell_number = (long long)map_size;
+#pragma omp parallel for schedule(dynamic, 1024)
+		for (long long cell = 0; cell < cell_number; cell++)
+		{
+			long long poi_begin = cell_begin[cell];
+			long long poi_end = cell_begin[cell + 1];
+			if (poi_begin == poi_end)
+			{
+				continue;
+			}
+			for (int v = 0; v < variable_number; v++)
+			{
+				float sum = 0.f;
+				for (long long j = poi_begin; j < poi_end; j++)
+				{
+					const char* poi_data = (const char*)&poi_queue[cell_poi[j]];
+					sum += *(const float*)(poi_data + field_offsets[v]);
+				}
+				maps[map_size * v + cell] = sum / (float)(poi_end - poi_begin);
+			}
+		}
+	}
+
+	//write a map as text, each row of map is a line, and an empty line follows each slice of 3D map
+	static void saveMapText(const string& file_path, const string& delimiter, const float* map, int map_dimension[3], bool volume)
+	{
+		std::ofstream file_out(file_path);
+		if (!file_out.is_open())
+		{
+			throw std::string("Failed to open file " + file_path);
+		}
+
+		const long long block_rows = 256;
+		int thread_number = omp_get_max_threads();
+		long long row_number = (long long)map_dimension[1] * map_dimension[2];
+		size_t row_capacity = map_dimension[0] * (64 + delimiter.length()) + 2;
+
+		vector<vector<char>> buffer(thread_number, vector<char>(block_rows * row_capacity));
+		vector<size_t> buffer_size(thread_number, 0);
+
+		for (long long block_begin = 0; block_begin < row_number; block_begin += block_rows * thread_number)
+		{
+#pragma omp parallel for
+			for (int t = 0; t < thread_number; t++)
+			{
+				long long row_begin = block_begin + block_rows * t;
+				long long row_end = std::min(row_begin + block_rows, row_number);
+				char* output = buffer[t].data();
+
+				for (long long r = row_begin; r < row_end; r++)
+				{
+					const float* row_values = map + (size_t)map_dimension[0] * r;
+					for (int c = 0; c < map_dimension[0]; c++)
+					{
+						output = formatFixed(row_values[c], output);
+						std::memcpy(output, delimiter.data(), delimiter.length());
+						output += delimiter.length();
+					}
+					*output++ = '\n';
+					if (volume && (r + 1) % map_dimension[1] == 0)
+					{
+						*output++ = '\n';
+					}
+				}
+				buffer_size[t] = output - buffer[t].data();
+			}
+
+			for (int t = 0; t < thread_number; t++)
+			{
+				file_out.write(buffer[t].data(), buffer_size[t]);
+			}
+		}
+
+		if (!file_out.good())
+		{
+			throw std::string("Failed to write file " + file_path);
+		}
+		file_out.close();
+	}
+
+	//write a map of float as raw data (x the fastest, then y and z) or as TIFF, one page per slice in 3D
+	static void saveMapBinary(const string& file_path, int format, const float* map, int map_dimension[3])
+	{
+		std::ofstream file_out(file_path, std::ios::out | std::ios::binary);
+		if (!file_out.is_open())
+		{
+			throw std::string("Failed to open file " + file_path);
+		}
+
+		size_t page_size = sizeof(float) * map_dimension[0] * map_dimension[1];
+		size_t map_size = page_size * map_dimension[2];
+
+		if (format == MAP_TIFF)
+		{
+			//little-endian baseline TIFF with 32-bit float samples, all the IFDs are placed before the data
+			const int tag_number = 10;
+			const size_t ifd_size = 2 + 12 * tag_number + 4;
+			size_t data_begin = 8 + ifd_size * map_dimension[2];
+			if (data_begin + map_size > 0xFFFFFFFFULL)
+			{
+				throw std::string("Map exceeds the size limit of TIFF, save it as raw data: " + file_path);
+			}
+
+			vector<char> head(data_begin, 0);
+			char* p = head.data();
+			auto put16 = [&p](uint16_t value) { std::memcpy(p, &value, 2); p += 2; };
+			auto put32 = [&p](uint32_t value) { std::memcpy(p, &value, 4); p += 4; };
+			auto putTag = [&](uint16_t tag, uint16_t type, uint32_t value)
+			{
+				put16(tag);
+				put16(type);
+				put32(1);
+				if (type == 3)
+				{
+					put16((uint16_t)value);
+					put16(0);
+				}
+				else
+				{
+					put32(value);
+				}
+			};
+
+			std::memcpy(p, "II", 2);
+			p += 2;
+			put16(42);
+			put32(8);
+			for (int i = 0; i < map_dimension[2]; i++)
+			{
+				uint32_t next_ifd = i + 1 < map_dimension[2] ? (uint32_t)(8 + ifd_size * (i + 1)) : 0;
+				put16(tag_number);
+				putTag(256, 4, map_dimension[0]); //image width
+				putTag(257, 4, map_dimension[1]); //image length
+				putTag(258, 3, 32); //bits per sample
+				putTag(259, 3, 1); //no compression
+				putTag(262, 3, 1); //black is zero
+				putTag(273, 4, (uint32_t)(data_begin + page_size * i)); //strip offset
+				putTag(277, 3, 1); //samples per pixel
+				putTag(278, 4, map_dimension[1]); //rows per strip
+				putTag(279, 4, (uint32_t)page_size); //strip byte count
+				putTag(339, 3, 3); //sample format of IEEE float
+				put32(next_ifd);
+			}
+			file_out.write(head.data(), head.size());
+		}
+
+		file_out.write((const char*)map, map_size);
+		if (!file_out.good())
+		{
+			throw std::string("Failed to write file " + file_path);
+		}
+		file_out.close();
+	}
+
+	//rasterize and save the maps of variables, each map is saved in the file path with suffix of variable
+	template <typename T>
+	static void saveMaps(vector<T>& poi_queue, const string& file_path, const string& delimiter, string variables,
+		int format, int downsampling, int dimension[3], bool volume, T empty_poi)
+	{
+		if (downsampling < 1)
+		{
+			throw std::string("Downsampling of maps should be a positive integer");
+		}
+
+		vector<long long> field_offsets;
+		for (int i = 0; i < (int)variables.size(); i++)
+		{
+			long long offset = getMapOffset(empty_poi, variables[i]);
+			if (offset < 0)
+			{
+				throw std::string("Unknown variable of map: ") + variables[i];
+			}
+			field_offsets.push_back(offset);
+		}
+
+		int map_dimension[3];
+		for (int i = 0; i < 3; i++)
+		{
+			map_dimension[i] = (std::max(dimension[i], 1) + downsampling - 1) / downsampling;
+		}
+
+		vector<float> maps;
+		rasterizeMaps(poi_queue, field_offsets, map_dimension, downsampling, maps);
+
+		size_t map_size = (size_t)map_dimension[0] * map_dimension[1] * map_dimension[2];
+		size_t separator = file_path.find_last_of("/\\");
+		size_t extension = file_path.find_last_of('.');
+		if (extension == string::npos || (separator != string::npos && extension < separator))
+		{
+			extension = file_path.length();
+		}
+
+		for (int i = 0; i < (int)variables.size(); i++)
+		{
+			string map_path = file_path.substr(0, extension) + "_" + variables[i] + file_path.substr(extension);
+			if (format == MAP_TEXT)
+			{
+				saveMapText(map_path, delimiter, maps.data() + map_size * i, map_dimension, volume);
+			}
+			else
+			{
+				saveMapBinary(map_path, format, maps.data() + map_size * i, map_dimension);
+			}
+		}
+	}
+
+	//names and byte offsets of the float fields in POI, used to write and read columnar files
+	static void addColumnarField(vector<string>& names, vector<size_t>& offsets, const char* name, const void* poi, const float* field)
+	{
+		names.push_back(name);
+		offsets.push_back((size_t)((const char*)field - (const char*)poi));
+	}
+
+	void getColumnarFields(POI2D& poi, vector<string>& names, vector<size_t>& offsets)
+	{
+		const char* deformation_names[12] = { "u", "ux", "uy", "uxx", "uxy", "uyy", "v", "vx", "vy", "vxx", "vxy", "vyy" };
+		const char* result_names[6] = { "u0", "v0", "ZNCC", "iteration", "convergence", "feature" };
+		const char* strain_names[3] = { "exx", "eyy", "exy" };
+
+		addColumnarField(names, offsets, "x", &poi, &poi.x);
+		addColumnarField(names, offsets, "y", &poi, &poi.y);
+		for (int i = 0; i < 12; i++)
+		{
+			addColumnarField(names, offsets, deformation_names[i], &poi, &poi.deformation.p[i]);
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			addColumnarField(names, offsets, result_names[i], &poi, &poi.result.r[i]);
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			addColumnarField(names, offsets, strain_names[i], &poi, &poi.strain.e[i]);
+		}
+		addColumnarField(names, offsets, "subset_rx", &poi, &poi.subset_radius.x);
+		addColumnarField(names, offsets, "subset_ry", &poi, &poi.subset_radius.y);
+	}
+
+	void getColumnarFields(POI2DS& poi, vector<string>& names, vector<size_t>& offsets)
+	{
+		const char* deformation_names[3] = { "u", "v", "w" };
+		const char* result_names[9] = { "r1r2_ZNCC", "r1t1_ZNCC", "r1t2_ZNCC", "r2_x", "r2_y", "t1_x", "t1_y", "t2_x", "t2_y" };
+		const char* strain_names[6] = { "exx", "eyy", "ezz", "exy", "eyz", "ezx" };
+
+		addColumnarField(names, offsets, "x", &poi, &poi.x);
+		addColumnarField(names, offsets, "y", &poi, &poi.y);
+		for (int i = 0; i < 3; i++)
+		{
+			addColumnarField(names, offsets, deformation_names[i], &poi, &poi.deformation.p[i]);
+		}
+		for (int i = 0; i < 9; i++)
+		{
+			addColumnarField(names, offsets, result_names[i], &poi, &poi.result.r[i]);
+		}
+		addColumnarField(names, offsets, "ref_x", &poi, &poi.ref_coor.x);
+		addColumnarField(names, offsets, "ref_y", &poi, &poi.ref_coor.y);
+		addColumnarField(names, offsets, "ref_z", &poi, &poi.ref_coor.z);
+		addColumnarField(names, offsets, "tar_x", &poi, &poi.tar_coor.x);
+		addColumnarField(names, offsets, "tar_y", &poi, &poi.tar_coor.y);
+		addColumnarField(names, offsets, "tar_z", &poi, &poi.tar_coor.z);
+		for (int i = 0; i < 6; i++)
+		{
+			addColumnarField(names, offsets, strain_names[i], &poi, &poi.strain.e[i]);
+		}
+		addColumnarField(names, offsets, "subset_rx", &poi, &poi.subset_radius.x);
+		addColumnarField(names, offsets, "subset_ry", &poi, &poi.subset_radius.y);
+	}
+
+	void getColumnarFields(POI3D& poi, vector<string>& names, vector<size_t>& offsets)
+	{
+		const char* deformation_names[12] = { "u", "ux", "uy", "uz", "v", "vx", "vy", "vz", "w", "wx", "wy", "wz" };
+		const char* result_names[7] = { "u0", "v0", "w0", "ZNCC", "iteration", "convergence", "feature" };
+		const char* strain_names[6] = { "exx", "eyy", "ezz", "exy", "eyz", "ezx" };
+
+		addColumnarField(names, offsets, "x", &poi, &poi.x);
+		addColumnarField(names, offsets, "y", &poi, &poi.y);
+		addColumnarField(names, offsets, "z", &poi, &poi.z);
+		for (int i = 0; i < 12; i++)
+		{
+			addColumnarField(names, offsets, deformation_names[i], &poi, &poi.deformation.p[i]);
+		}
+		for (int i = 0; i < 7; i++)
+		{
+			addColumnarField(names, offsets, result_names[i], &poi, &poi.result.r[i]);
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			addColumnarField(names, offsets, strain_names[i], &poi, &poi.strain.e[i]);
+		}
+		addColumnarField(names, offsets, "subset_rx", &poi, &poi.subset_radius.x);
+		addColumnarField(names, offsets, "subset_ry", &poi, &poi.subset_radius.y);
+		addColumnarField(names, offsets, "subset_rz", &poi, &poi.subset_radius.z);
+	}
+
+	template <typename T>
+	static void saveColumnar(string file_path, int poi_type, int dimension[3], vector<T>& poi_queue, T empty_poi)
+	{
+		vector<string> names;
+		vector<size_t> offsets;
+		getColumnarFields(empty_poi, names, offsets);
+
+		ColumnarTable::write(file_path, poi_type, dimension, (const char*)poi_queue.data(), sizeof(T),
+			poi_queue.size(), names, offsets);
+	}
+
+	//scatter the columns in mapped file into POIs, fields missing in file are left as zero
+	template <typename T>
+	static vector<T> loadColumnar(ColumnarTable& table, int poi_type, T empty_poi)
+	{
+		if (table.getType() != poi_type)
+		{
+			throw std::string("Type of POI in columnar file does not match");
+		}
+
+		vector<string> names;
+		vector<size_t> offsets;
+		getColumnarFields(empty_poi, names, offsets);
+
+		vector<T> poi_queue(table.getPOINumber(), empty_poi);
+		long long queue_length = (long long)poi_queue.size();
+		char* poi_data = (char*)poi_queue.data();
+
+		for (int f = 0; f < (int)names.size(); f++)
+		{
+			const float* column = table.getColumn(names[f]);
+			if (column == nullptr)
+			{
+				continue;
+			}
+
+			char* field_data = poi_data + offsets[f];
+#pragma omp parallel for
+			for (long long i = 0; i < queue_length; i++)
+			{
+				*(float*)(field_data + sizeof(T) * i) = column[i];
+			}
+		}
+
+		return poi_queue;
+	}
+
 	IO2D::IO2D() {}
 
 	IO2D::~IO2D() {}
@@ -59,125 +886,60 @@ namespace opencorr
 	}
 
 	void IO2D::setHeight(int height)
-	{
-		this->height = height;
-	}
-
-	vector<POI2D> IO2D::loadTable2D()
-	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
-		{
-			std::cerr << "failed to read file " << file_path << std::endl;
-		}
-
-		string data_line;
-		getline(file_in, data_line);
-		vector<POI2D> poi_queue;
-		size_t position1, position2;
-		string variable;
-		vector<float> key_buffer;
-
-		while (getline(file_in, data_line))
-		{
-			position1 = 0;
-			position2 = 0;
-			std::vector<float>().swap(key_buffer);
-			do
-			{
-				position2 = data_line.find(delimiter, position1);
-				if (position2 == string::npos)
-				{
-					position2 = data_line.length();
-				}
+	{
+		this->height = height;
+	}
 
-				variable = data_line.substr(position1, position2 - position1);
-				if (!variable.empty())
-				{
-					key_buffer.push_back(std::stof(variable));
-				}
+	vector<POI2D> IO2D::loadTable2D()
+	{
+		//x, y, u, v, result and strain
+		const int field_number = 13;
+		vector<float> values;
+		long long row_number = (long long)loadCSV(file_path, delimiter, field_number, values);
 
-				position1 = position2 + delimiter.length();
-			} while (position2 < data_line.length() && position1 < data_line.length());
+		vector<POI2D> poi_queue(row_number, POI2D(0, 0));
 
-			float x = key_buffer[0];
-			float y = key_buffer[1];
-			POI2D current_POI(x, y);
+#pragma omp parallel for
+		for (long long i = 0; i < row_number; i++)
+		{
+			const float* row_values = values.data() + field_number * i;
+			POI2D current_POI(row_values[0], row_values[1]);
 
-			current_POI.deformation.u = key_buffer[2];
-			current_POI.deformation.v = key_buffer[3];
+			current_POI.deformation.u = row_values[2];
+			current_POI.deformation.v = row_values[3];
 
 			int current_index = 4;
 			int array_size = (int)(sizeof(current_POI.result.r) / sizeof(current_POI.result.r[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.result.r[i] = key_buffer[current_index + i];
+				current_POI.result.r[j] = row_values[current_index + j];
 			}
 
 			current_index += array_size;
 			array_size = (int)(sizeof(current_POI.strain.e) / sizeof(current_POI.strain.e[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.strain.e[i] = key_buffer[current_index + i];
+				current_POI.strain.e[j] = row_values[current_index + j];
 			}
 
-			poi_queue.push_back(current_POI);
+			poi_queue[i] = current_POI;
 		}
-		file_in.close();
 
 		return poi_queue;
 	}
 
 	vector<Point2D> IO2D::loadPoint2D(string file_path)
 	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
-		{
-			std::cerr << "failed to read file " << file_path << std::endl;
-		}
+		vector<float> values;
+		long long point_number = (long long)loadCSV(file_path, delimiter, 2, values);
 
-		string data_line;
-		getline(file_in, data_line);
-		vector<Point2D> point_queue;
-		size_t position1, position2;
-		string variable;
-		vector<float> key_buffer;
-		int point_number = 0;
+		vector<Point2D> point_queue(point_number);
 
-		while (getline(file_in, data_line))
+#pragma omp parallel for
+		for (long long i = 0; i < point_number; i++)
 		{
-			point_number++;
-			position1 = 0;
-			position2 = 0;
-			std::vector<float>().swap(key_buffer);
-
-			position2 = data_line.find(delimiter, position1);
-			if (position2 == string::npos)
-			{
-				std::cerr << "failed to read POI at line: " << point_number << std::endl;
-			}
-
-			variable = data_line.substr(position1, position2 - position1);
-			if (!variable.empty())
-			{
-				key_buffer.push_back(std::stof(variable));
-			}
-
-			position1 = position2 + delimiter.length();
-			position2 = data_line.length();
-			variable = data_line.substr(position1, position2 - position1);
-			if (!variable.empty())
-			{
-				key_buffer.push_back(std::stof(variable));
-			}
-
-			float x = key_buffer[0];
-			float y = key_buffer[1];
-			Point2D current_point(x, y);
-
-			point_queue.push_back(current_point);
+			point_queue[i] = Point2D(values[i * 2], values[i * 2 + 1]);
 		}
-		file_in.close();
 
 		return point_queue;
 	}
@@ -185,8 +947,6 @@ namespace opencorr
 	void IO2D::saveTable2D(vector<POI2D>& poi_queue)
 	{
 		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
 
 		if (file_out.is_open())
 		{
@@ -211,30 +971,32 @@ namespace opencorr
 			file_out << "subset_ry" << delimiter;
 			file_out << std::endl;
 
-			for (vector<POI2D>::iterator iter = poi_queue.begin(); iter != poi_queue.end(); iter++)
+			saveCSV(file_out, poi_queue, delimiter, 15, [](POI2D& poi, float* row_values)
 			{
-				file_out << iter->x << delimiter;
-				file_out << iter->y << delimiter;
+				row_values[0] = poi.x;
+				row_values[1] = poi.y;
 
-				file_out << iter->deformation.u << delimiter;
-				file_out << iter->deformation.v << delimiter;
+				row_values[2] = poi.deformation.u;
+				row_values[3] = poi.deformation.v;
 
-				int array_size = (int)(sizeof(iter->result.r) / sizeof(iter->result.r[0]));
+				int current_index = 4;
+				int array_size = (int)(sizeof(poi.result.r) / sizeof(poi.result.r[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->result.r[i] << delimiter;
+					row_values[current_index + i] = poi.result.r[i];
 				}
 
-				array_size = (int)(sizeof(iter->strain.e) / sizeof(iter->strain.e[0]));
+				current_index += array_size;
+				array_size = (int)(sizeof(poi.strain.e) / sizeof(poi.strain.e[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->strain.e[i] << delimiter;
+					row_values[current_index + i] = poi.strain.e[i];
 				}
 
-				file_out << iter->subset_radius.x << delimiter;
-				file_out << iter->subset_radius.y << delimiter;
-				file_out << std::endl;
-			}
+				current_index += array_size;
+				row_values[current_index] = poi.subset_radius.x;
+				row_values[current_index + 1] = poi.subset_radius.y;
+			});
 		}
 		file_out.close();
 	}
@@ -242,8 +1004,6 @@ namespace opencorr
 	void IO2D::saveDeformationTable2D(vector<POI2D>& poi_queue)
 	{
 		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
 
 		if (file_out.is_open())
 		{
@@ -268,181 +1028,92 @@ namespace opencorr
 			file_out << "subset_ry" << delimiter;
 			file_out << std::endl;
 
-			for (vector<POI2D>::iterator iter = poi_queue.begin(); iter != poi_queue.end(); iter++)
+			saveCSV(file_out, poi_queue, delimiter, 16, [](POI2D& poi, float* row_values)
 			{
-				file_out << iter->x << delimiter;
-				file_out << iter->y << delimiter;
+				row_values[0] = poi.x;
+				row_values[1] = poi.y;
 
-				int array_size = (int)(sizeof(iter->deformation.p) / sizeof(iter->deformation.p[0]));
+				int array_size = (int)(sizeof(poi.deformation.p) / sizeof(poi.deformation.p[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->deformation.p[i] << delimiter;
+					row_values[2 + i] = poi.deformation.p[i];
 				}
-				file_out << iter->subset_radius.x << delimiter;
-				file_out << iter->subset_radius.y << delimiter;
-				file_out << std::endl;
-			}
+
+				row_values[2 + array_size] = poi.subset_radius.x;
+				row_values[3 + array_size] = poi.subset_radius.y;
+			});
 		}
 		file_out.close();
 	}
 
 	void IO2D::saveMap2D(vector<POI2D>& poi_queue, char variable)
 	{
-		int height = getHeight();
-		int width = getWidth();
-		Eigen::MatrixXf output_map = Eigen::MatrixXf::Zero(height, width);
-
-		switch (variable)
+		POI2D empty_poi(0, 0);
+		vector<long long> field_offsets(1, getMapOffset(empty_poi, variable));
+		if (field_offsets[0] < 0)
 		{
-		case 'u':
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].deformation.u;
-			}
-			break;
-		case 'v':
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].deformation.v;
-			}
-			break;
-		case 'c': //ZNCC value
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.zncc;
-			}
-			break;
-		case 'd': //final ||delta_p||
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.convergence;
-			}
-			break;
-		case 'i': //iteration steps
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.iteration;
-			}
-			break;
-		case 'f': //number of neighbor features
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.feature;
-			}
-			break;
-		case 'x': //strain exx
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.exx;
-			}
-			break;
-		case 'y': //strain eyy
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.eyy;
-			}
-			break;
-		case 'r': //strain exy
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.exy;
-			}
-			break;
-		default:
 			return;
 		}
 
-		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
-		if (file_out.is_open())
-		{
-			for (int r = 0; r < height; r++)
-			{
-				for (int c = 0; c < width; c++)
-				{
-					file_out << output_map(r, c) << delimiter;
-				}
-				file_out << std::endl;
-			}
-		}
-		file_out.close();
+		int map_dimension[3] = { width, height, 1 };
+		vector<float> output_map;
+		rasterizeMaps(poi_queue, field_offsets, map_dimension, 1, output_map);
+		saveMapText(file_path, delimiter, output_map.data(), map_dimension, false);
+	}
+
+	void IO2D::saveMaps2D(vector<POI2D>& poi_queue, string variables, int format, int downsampling)
+	{
+		int dimension[3] = { width, height, 1 };
+		saveMaps(poi_queue, file_path, delimiter, variables, format, downsampling, dimension, false, POI2D(0, 0));
 	}
 
 	vector<POI2DS> IO2D::loadTable2DS()
 	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
-		{
-			std::cerr << "failed to read file " << file_path << std::endl;
-		}
+		//x, y, deformation, result, coordinates in ref and tar, and strain
+		const int field_number = 26;
+		vector<float> values;
+		long long row_number = (long long)loadCSV(file_path, delimiter, field_number, values);
 
-		string data_line;
-		getline(file_in, data_line);
-		vector<POI2DS> poi_queue;
-		size_t position1, position2;
-		string variable;
-		vector<float> key_buffer;
+		vector<POI2DS> poi_queue(row_number, POI2DS(0, 0));
 
-		while (getline(file_in, data_line))
+#pragma omp parallel for
+		for (long long i = 0; i < row_number; i++)
 		{
-			position1 = 0;
-			position2 = 0;
-			vector<float>().swap(key_buffer);
-			do
-			{
-				position2 = data_line.find(delimiter, position1);
-				if (position2 == string::npos)
-				{
-					position2 = data_line.length();
-				}
-
-				variable = data_line.substr(position1, position2 - position1);
-				if (!variable.empty())
-				{
-					key_buffer.push_back(std::stof(variable));
-				}
-
-				position1 = position2 + delimiter.length();
-			} while (position2 < data_line.length() && position1 < data_line.length());
-
-			float x = key_buffer[0];
-			float y = key_buffer[1];
-			POI2DS current_POI(x, y);
+			const float* row_values = values.data() + field_number * i;
+			POI2DS current_POI(row_values[0], row_values[1]);
 
 			int current_index = 2;
 			int array_size = (int)(sizeof(current_POI.deformation.p) / sizeof(current_POI.deformation.p[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.deformation.p[i] = key_buffer[current_index + i];
+				current_POI.deformation.p[j] = row_values[current_index + j];
 			}
 
 			current_index += array_size;
 			array_size = (int)(sizeof(current_POI.result.r) / sizeof(current_POI.result.r[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.result.r[i] = key_buffer[current_index + i];
+				current_POI.result.r[j] = row_values[current_index + j];
 			}
 
 			current_index += array_size;
-			current_POI.ref_coor.x = key_buffer[current_index];
-			current_POI.ref_coor.y = key_buffer[current_index + 1];
-			current_POI.ref_coor.z = key_buffer[current_index + 2];
+			current_POI.ref_coor.x = row_values[current_index];
+			current_POI.ref_coor.y = row_values[current_index + 1];
+			current_POI.ref_coor.z = row_values[current_index + 2];
 
-			current_POI.tar_coor.x = key_buffer[current_index + 3];
-			current_POI.tar_coor.y = key_buffer[current_index + 4];
-			current_POI.tar_coor.z = key_buffer[current_index + 5];
+			current_POI.tar_coor.x = row_values[current_index + 3];
+			current_POI.tar_coor.y = row_values[current_index + 4];
+			current_POI.tar_coor.z = row_values[current_index + 5];
 
 			current_index += 6;
 			array_size = (int)(sizeof(current_POI.strain.e) / sizeof(current_POI.strain.e[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.strain.e[i] = key_buffer[current_index + i];
+				current_POI.strain.e[j] = row_values[current_index + j];
 			}
 
-			poi_queue.push_back(current_POI);
+			poi_queue[i] = current_POI;
 		}
-		file_in.close();
 
 		return poi_queue;
 	}
@@ -450,8 +1121,6 @@ namespace opencorr
 	void IO2D::saveTable2DS(vector<POI2DS>& poi_queue)
 	{
 		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
 
 		if (file_out.is_open())
 		{
@@ -491,147 +1160,104 @@ namespace opencorr
 			file_out << "subset_ry" << delimiter;
 			file_out << std::endl;
 
-			for (vector<POI2DS>::iterator iter = poi_queue.begin(); iter != poi_queue.end(); iter++)
+			saveCSV(file_out, poi_queue, delimiter, 28, [](POI2DS& poi, float* row_values)
 			{
-				file_out << iter->x << delimiter;
-				file_out << iter->y << delimiter;
+				row_values[0] = poi.x;
+				row_values[1] = poi.y;
 
-				int array_size = (int)(sizeof(iter->deformation.p) / sizeof(iter->deformation.p[0]));
+				int current_index = 2;
+				int array_size = (int)(sizeof(poi.deformation.p) / sizeof(poi.deformation.p[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->deformation.p[i] << delimiter;
+					row_values[current_index + i] = poi.deformation.p[i];
 				}
 
-				array_size = (int)(sizeof(iter->result.r) / sizeof(iter->result.r[0]));
+				current_index += array_size;
+				array_size = (int)(sizeof(poi.result.r) / sizeof(poi.result.r[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->result.r[i] << delimiter;
+					row_values[current_index + i] = poi.result.r[i];
 				}
 
-				file_out << iter->ref_coor.x << delimiter;
-				file_out << iter->ref_coor.y << delimiter;
-				file_out << iter->ref_coor.z << delimiter;
+				current_index += array_size;
+				row_values[current_index] = poi.ref_coor.x;
+				row_values[current_index + 1] = poi.ref_coor.y;
+				row_values[current_index + 2] = poi.ref_coor.z;
 
-				file_out << iter->tar_coor.x << delimiter;
-				file_out << iter->tar_coor.y << delimiter;
-				file_out << iter->tar_coor.z << delimiter;
+				row_values[current_index + 3] = poi.tar_coor.x;
+				row_values[current_index + 4] = poi.tar_coor.y;
+				row_values[current_index + 5] = poi.tar_coor.z;
 
-				array_size = (int)(sizeof(iter->strain.e) / sizeof(iter->strain.e[0]));
+				current_index += 6;
+				array_size = (int)(sizeof(poi.strain.e) / sizeof(poi.strain.e[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->strain.e[i] << delimiter;
+					row_values[current_index + i] = poi.strain.e[i];
 				}
-				file_out << iter->subset_radius.x << delimiter;
-				file_out << iter->subset_radius.y << delimiter;
-				file_out << std::endl;
-			}
+
+				current_index += array_size;
+				row_values[current_index] = poi.subset_radius.x;
+				row_values[current_index + 1] = poi.subset_radius.y;
+			});
 		}
 		file_out.close();
 	}
 
 	void IO2D::saveMap2DS(vector<POI2DS>& poi_queue, char variable)
 	{
-		int height = getHeight();
-		int width = getWidth();
-		Eigen::MatrixXf output_map = Eigen::MatrixXf::Zero(height, width);
-
-		switch (variable)
+		POI2DS empty_poi(0, 0);
+		vector<long long> field_offsets(1, getMapOffset(empty_poi, variable));
+		if (field_offsets[0] < 0)
 		{
-		case 'u':
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].deformation.u;
-			}
-			break;
-		case 'v':
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].deformation.v;
-			}
-			break;
-		case 'w':
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].deformation.w;
-			}
-			break;
-		case 'c': //ZNCC value in matching between the two reference images
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.r1r2_zncc;
-			}
-			break;
-		case 'd': //ZNCC value in matching between the reference image and the target image from same view
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.r1t1_zncc;
-			}
-			break;
-		case 'e': //ZNCC value in matching between the reference image and the target image from different views
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].result.r1t2_zncc;
-			}
-			break;
-		case 'x': //strain exx
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.exx;
-			}
-			break;
-		case 'y': //strain eyy
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.eyy;
-			}
-			break;
-		case 'z': //strain ezz
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.ezz;
-			}
-			break;
-		case 'r': //strain exy
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.exy;
-			}
-			break;
-		case 's': //strain eyz
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.eyz;
-			}
-			break;
-		case 't': //strain ezx
-			for (int i = 0; i < poi_queue.size(); i++)
-			{
-				output_map((int)poi_queue[i].y, (int)poi_queue[i].x) = poi_queue[i].strain.ezx;
-			}
-			break;
-		default:
 			return;
 		}
 
-		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
+		int map_dimension[3] = { width, height, 1 };
+		vector<float> output_map;
+		rasterizeMaps(poi_queue, field_offsets, map_dimension, 1, output_map);
+		saveMapText(file_path, delimiter, output_map.data(), map_dimension, false);
+	}
 
-		if (file_out.is_open())
-		{
-			for (int r = 0; r < height; r++)
-			{
-				for (int c = 0; c < width; c++)
-				{
-					file_out << output_map(r, c) << delimiter;
-				}
-				file_out << std::endl;
-			}
-		}
-		file_out.close();
+	void IO2D::saveMaps2DS(vector<POI2DS>& poi_queue, string variables, int format, int downsampling)
+	{
+		int dimension[3] = { width, height, 1 };
+		saveMaps(poi_queue, file_path, delimiter, variables, format, downsampling, dimension, false, POI2DS(0, 0));
+	}
+
+	void IO2D::saveColumnar2D(vector<POI2D>& poi_queue)
+	{
+		int dimension[3] = { width, height, 0 };
+		saveColumnar(file_path, COLUMNAR_POI2D, dimension, poi_queue, POI2D(0, 0));
+	}
+
+	vector<POI2D> IO2D::loadColumnar2D()
+	{
+		ColumnarTable table;
+		table.open(file_path);
+		setWidth(table.getDimension(0));
+		setHeight(table.getDimension(1));
+
+		return loadColumnar(table, COLUMNAR_POI2D, POI2D(0, 0));
+	}
+
+	void IO2D::saveColumnar2DS(vector<POI2DS>& poi_queue)
+	{
+		int dimension[3] = { width, height, 0 };
+		saveColumnar(file_path, COLUMNAR_POI2DS, dimension, poi_queue, POI2DS(0, 0));
+	}
+
+	vector<POI2DS> IO2D::loadColumnar2DS()
+	{
+		ColumnarTable table;
+		table.open(file_path);
+		setWidth(table.getDimension(0));
+		setHeight(table.getDimension(1));
+
+		return loadColumnar(table, COLUMNAR_POI2DS, POI2DS(0, 0));
 	}
 
 
+
 	IO3D::IO3D() {}
 
 	IO3D::~IO3D() {}
@@ -688,150 +1314,71 @@ namespace opencorr
 
 	vector<POI3D> IO3D::loadTable3D()
 	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
-		{
-			std::cerr << "failed to read file " << file_path << std::endl;
-		}
+		//x, y, z, u, v, w, result, gradients of displacement, strain and subset radius
+		const int field_number = 31;
+		vector<float> values;
+		long long row_number = (long long)loadCSV(file_path, delimiter, field_number, values);
 
-		string data_line;
-		getline(file_in, data_line);
-		vector<POI3D> poi_queue;
-		size_t position1, position2;
-		string variable;
-		vector<float> key_buffer;
+		vector<POI3D> poi_queue(row_number, POI3D(0, 0, 0));
 
-		while (getline(file_in, data_line))
+#pragma omp parallel for
+		for (long long i = 0; i < row_number; i++)
 		{
-			position1 = 0;
-			position2 = 0;
-			vector<float>().swap(key_buffer);
-			do
-			{
-				position2 = data_line.find(delimiter, position1);
-				if (position2 == string::npos)
-				{
-					position2 = data_line.length();
-				}
-
-				variable = data_line.substr(position1, position2 - position1);
-				if (!variable.empty())
-				{
-					key_buffer.push_back(std::stof(variable));
-				}
+			const float* row_values = values.data() + field_number * i;
+			POI3D current_POI(row_values[0], row_values[1], row_values[2]);
 
-				position1 = position2 + delimiter.length();
-			} while (position2 < data_line.length() && position1 < data_line.length());
-
-			float x = key_buffer[0];
-			float y = key_buffer[1];
-			float z = key_buffer[2];
-			POI3D current_POI(x, y, z);
-
-			current_POI.deformation.u = key_buffer[3];
-			current_POI.deformation.v = key_buffer[4];
-			current_POI.deformation.w = key_buffer[5];
+			current_POI.deformation.u = row_values[3];
+			current_POI.deformation.v = row_values[4];
+			current_POI.deformation.w = row_values[5];
 
 			int current_index = 6;
 			int array_size = (int)(sizeof(current_POI.result.r) / sizeof(current_POI.result.r[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.result.r[i] = key_buffer[current_index + i];
+				current_POI.result.r[j] = row_values[current_index + j];
 			}
 
 			current_index += array_size;
-			current_POI.deformation.ux = key_buffer[current_index];
-			current_POI.deformation.uy = key_buffer[current_index + 1];
-			current_POI.deformation.uz = key_buffer[current_index + 2];
-			current_POI.deformation.vx = key_buffer[current_index + 3];
-			current_POI.deformation.vy = key_buffer[current_index + 4];
-			current_POI.deformation.vz = key_buffer[current_index + 5];
-			current_POI.deformation.wx = key_buffer[current_index + 6];
-			current_POI.deformation.wy = key_buffer[current_index + 7];
-			current_POI.deformation.wz = key_buffer[current_index + 8];
-			array_size = 9;
-
-			current_index += array_size;
+			current_POI.deformation.ux = row_values[current_index];
+			current_POI.deformation.uy = row_values[current_index + 1];
+			current_POI.deformation.uz = row_values[current_index + 2];
+			current_POI.deformation.vx = row_values[current_index + 3];
+			current_POI.deformation.vy = row_values[current_index + 4];
+			current_POI.deformation.vz = row_values[current_index + 5];
+			current_POI.deformation.wx = row_values[current_index + 6];
+			current_POI.deformation.wy = row_values[current_index + 7];
+			current_POI.deformation.wz = row_values[current_index + 8];
+
+			current_index += 9;
 			array_size = (int)(sizeof(current_POI.strain.e) / sizeof(current_POI.strain.e[0]));
-			for (int i = 0; i < array_size; i++)
+			for (int j = 0; j < array_size; j++)
 			{
-				current_POI.strain.e[i] = key_buffer[current_index + i];
+				current_POI.strain.e[j] = row_values[current_index + j];
 			}
 
 			current_index += array_size;
-			current_POI.subset_radius.x = key_buffer[current_index];
-			current_POI.subset_radius.y = key_buffer[current_index + 1];
-			current_POI.subset_radius.z = key_buffer[current_index + 2];
+			current_POI.subset_radius.x = row_values[current_index];
+			current_POI.subset_radius.y = row_values[current_index + 1];
+			current_POI.subset_radius.z = row_values[current_index + 2];
 
-			poi_queue.push_back(current_POI);
+			poi_queue[i] = current_POI;
 		}
-		file_in.close();
 
 		return poi_queue;
 	}
 
 	vector<Point3D> IO3D::loadPoint3D(string file_path)
 	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
-		{
-			std::cerr << "failed to read file " << file_path << std::endl;
-		}
+		vector<float> values;
+		long long point_number = (long long)loadCSV(file_path, delimiter, 3, values);
 
-		string data_line;
-		getline(file_in, data_line);
-		vector<Point3D> point_queue;
-		size_t position1, position2;
-		string variable;
-		vector<float> key_buffer;
-		int point_number = 0;
+		vector<Point3D> point_queue(point_number);
 
-		while (getline(file_in, data_line))
+#pragma omp parallel for
+		for (long long i = 0; i < point_number; i++)
 		{
-			point_number++;
-			position1 = 0;
-			position2 = 0;
-			vector<float>().swap(key_buffer);
-
-			//get x
-			position2 = data_line.find(delimiter, position1);
-			if (position2 == string::npos)
-			{
-				std::cerr << "failed to read POI at line: " << point_number << std::endl;
-			}
-
-			variable = data_line.substr(position1, position2 - position1);
-			if (!variable.empty())
-			{
-				key_buffer.push_back(std::stof(variable));
-			}
-
-			//get y
-			position1 = position2 + delimiter.length();
-			position2 = data_line.find(delimiter, position1);
-			variable = data_line.substr(position1, position2 - position1);
-			if (!variable.empty())
-			{
-				key_buffer.push_back(std::stof(variable));
-			}
-
-			//get z
-			position1 = position2 + delimiter.length();
-			position2 = data_line.length();
-			variable = data_line.substr(position1, position2 - position1);
-			if (!variable.empty())
-			{
-				key_buffer.push_back(std::stof(variable));
-			}
-
-			float x = key_buffer[0];
-			float y = key_buffer[1];
-			float z = key_buffer[2];
-			Point3D current_point(x, y, z);
-
-			point_queue.push_back(current_point);
+			point_queue[i] = Point3D(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]);
 		}
-		file_in.close();
 
 		return point_queue;
 	}
@@ -839,8 +1386,6 @@ namespace opencorr
 	void IO3D::saveTable3D(vector<POI3D>& poi_queue)
 	{
 		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
 
 		if (file_out.is_open())
 		{
@@ -882,138 +1427,69 @@ namespace opencorr
 			file_out << "subset_rz" << delimiter;
 			file_out << std::endl;
 
-			for (vector<POI3D>::iterator iter = poi_queue.begin(); iter != poi_queue.end(); iter++)
+			saveCSV(file_out, poi_queue, delimiter, 31, [](POI3D& poi, float* row_values)
 			{
-				file_out << iter->x << delimiter;
-				file_out << iter->y << delimiter;
-				file_out << iter->z << delimiter;
+				row_values[0] = poi.x;
+				row_values[1] = poi.y;
+				row_values[2] = poi.z;
 
-				file_out << iter->deformation.u << delimiter;
-				file_out << iter->deformation.v << delimiter;
-				file_out << iter->deformation.w << delimiter;
+				row_values[3] = poi.deformation.u;
+				row_values[4] = poi.deformation.v;
+				row_values[5] = poi.deformation.w;
 
-				int array_size = (int)(sizeof(iter->result.r) / sizeof(iter->result.r[0]));
+				int current_index = 6;
+				int array_size = (int)(sizeof(poi.result.r) / sizeof(poi.result.r[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->result.r[i] << delimiter;
+					row_values[current_index + i] = poi.result.r[i];
 				}
 
-				file_out << iter->deformation.ux << delimiter;
-				file_out << iter->deformation.uy << delimiter;
-				file_out << iter->deformation.uz << delimiter;
-				file_out << iter->deformation.vx << delimiter;
-				file_out << iter->deformation.vy << delimiter;
-				file_out << iter->deformation.vz << delimiter;
-				file_out << iter->deformation.wx << delimiter;
-				file_out << iter->deformation.wy << delimiter;
-				file_out << iter->deformation.wz << delimiter;
-
-				array_size = (int)(sizeof(iter->strain.e) / sizeof(iter->strain.e[0]));
+				current_index += array_size;
+				row_values[current_index] = poi.deformation.ux;
+				row_values[current_index + 1] = poi.deformation.uy;
+				row_values[current_index + 2] = poi.deformation.uz;
+				row_values[current_index + 3] = poi.deformation.vx;
+				row_values[current_index + 4] = poi.deformation.vy;
+				row_values[current_index + 5] = poi.deformation.vz;
+				row_values[current_index + 6] = poi.deformation.wx;
+				row_values[current_index + 7] = poi.deformation.wy;
+				row_values[current_index + 8] = poi.deformation.wz;
+
+				current_index += 9;
+				array_size = (int)(sizeof(poi.strain.e) / sizeof(poi.strain.e[0]));
 				for (int i = 0; i < array_size; i++)
 				{
-					file_out << iter->strain.e[i] << delimiter;
+					row_values[current_index + i] = poi.strain.e[i];
 				}
 
-				file_out << iter->subset_radius.x << delimiter;
-				file_out << iter->subset_radius.y << delimiter;
-				file_out << iter->subset_radius.z << delimiter;
-				file_out << std::endl;
-			}
+				current_index += array_size;
+				row_values[current_index] = poi.subset_radius.x;
+				row_values[current_index + 1] = poi.subset_radius.y;
+				row_values[current_index + 2] = poi.subset_radius.z;
+			});
 		}
 		file_out.close();
 	}
 
 	void IO3D::saveMap3D(vector<POI3D>& poi_queue, char variable)
 	{
-		int queue_length = (int)poi_queue.size();
-		float*** output_map = new3D(getDimZ(), getDimY(), getDimX());
-
-		switch (variable)
+		POI3D empty_poi(0, 0, 0);
+		vector<long long> field_offsets(1, getMapOffset(empty_poi, variable));
+		if (field_offsets[0] < 0)
 		{
-		case 'u':
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].deformation.u;
-			}
-			break;
-		case 'v':
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].deformation.v;
-			}
-			break;
-		case 'w':
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].deformation.w;
-			}
-			break;
-		case 'c': //ZNCC value
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].result.zncc;
-			}
-			break;
-		case 'x': //strain exx
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.exx;
-			}
-			break;
-		case 'y': //strain eyy
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.eyy;
-			}
-			break;
-		case 'z': //strain ezz
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.ezz;
-			}
-			break;
-		case 'r': //strain exy
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.exy;
-			}
-			break;
-		case 's': //strain eyz
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.eyz;
-			}
-			break;
-		case 't': //strain ezx
-			for (int i = 0; i < queue_length; i++)
-			{
-				output_map[(int)poi_queue[i].z][(int)poi_queue[i].y][(int)poi_queue[i].x] = poi_queue[i].strain.ezx;
-			}
-			break;
-		default:
 			return;
 		}
 
-		std::ofstream file_out(file_path);
-		file_out.setf(std::ios::fixed);
-		file_out << std::setprecision(8);
+		int map_dimension[3] = { dim_x, dim_y, dim_z };
+		vector<float> output_map;
+		rasterizeMaps(poi_queue, field_offsets, map_dimension, 1, output_map);
+		saveMapText(file_path, delimiter, output_map.data(), map_dimension, true);
+	}
 
-		if (file_out.is_open())
-		{
-			for (int i = 0; i < getDimZ(); i++)
-			{
-				for (int j = 0; j < getDimY(); j++)
-				{
-					for (int k = 0; k < getDimX(); k++)
-					{
-						file_out << output_map[i][j][k] << delimiter;
-					}
-					file_out << std::endl;
-				}
-				file_out << std::endl;
-			}
-		}
-		file_out.close();
+	void IO3D::saveMaps3D(vector<POI3D>& poi_queue, string variables, int format, int downsampling)
+	{
+		int dimension[3] = { dim_x, dim_y, dim_z };
+		saveMaps(poi_queue, file_path, delimiter, variables, format, downsampling, dimension, true, POI3D(0, 0, 0));
 	}
 
 	void IO3D::saveMatrixBin(vector<POI3D>& poi_queue)
@@ -1024,83 +1500,207 @@ namespace opencorr
 		if (!file_out.is_open())
 		{
 			std::cerr << "failed to open file " << file_path << std::endl;
+			return;
 		}
 
 		//head information, including the number of POIs and the three dimensions of image
-		int queue_length = (int)poi_queue.size();
-		int head_info[4];
-		head_info[0] = queue_length;
+		size_t queue_length = poi_queue.size();
+		int32_t head_info[4];
+		head_info[0] = queue_length <= INT32_MAX ? (int32_t)queue_length : -1;
 		head_info[1] = dim_x;
 		head_info[2] = dim_y;
 		head_info[3] = dim_z;
+		file_out.write((char*)head_info, sizeof(head_info));
+		if (head_info[0] < 0)
+		{
+			int64_t extended_length = (int64_t)queue_length;
+			file_out.write((char*)&extended_length, sizeof(extended_length));
+		}
 
-		//create a 1D array and fill it with output data of POIs
-		int result_length = 7;
-		int data_length = result_length * queue_length;
-		float* data_array = new float[data_length];
+		//fill the rows of POIs block by block, instead of a copy of whole queue
+		const int result_length = MatrixBinView::ROW_LENGTH;
+		const size_t block_length = 262144;
+		vector<float> data_array(result_length * std::min(queue_length, block_length));
 
-		for (int i = 0; i < queue_length; i++)
+		for (size_t block_begin = 0; block_begin < queue_length; block_begin += block_length)
 		{
-			data_array[i * result_length] = poi_queue[i].x;
-			data_array[i * result_length + 1] = poi_queue[i].y;
-			data_array[i * result_length + 2] = poi_queue[i].z;
-			data_array[i * result_length + 3] = poi_queue[i].deformation.u;
-			data_array[i * result_length + 4] = poi_queue[i].deformation.v;
-			data_array[i * result_length + 5] = poi_queue[i].deformation.w;
-			data_array[i * result_length + 6] = poi_queue[i].result.zncc;
-		}
+			long long block_size = (long long)std::min(block_length, queue_length - block_begin);
+			const POI3D* block_poi = poi_queue.data() + block_begin;
 
-		//write head information
-		file_out.write((char*)head_info, sizeof(head_info[0]) * 4);
+#pragma omp parallel for
+			for (long long i = 0; i < block_size; i++)
+			{
+				float* row = &data_array[i * result_length];
+				row[MATRIX_X] = block_poi[i].x;
+				row[MATRIX_Y] = block_poi[i].y;
+				row[MATRIX_Z] = block_poi[i].z;
+				row[MATRIX_U] = block_poi[i].deformation.u;
+				row[MATRIX_V] = block_poi[i].deformation.v;
+				row[MATRIX_W] = block_poi[i].deformation.w;
+				row[MATRIX_ZNCC] = block_poi[i].result.zncc;
+			}
 
-		//write data
-		file_out.write((char*)data_array, sizeof(data_array[0]) * data_length);
+			file_out.write((char*)data_array.data(), sizeof(float) * result_length * block_size);
+		}
 
+		if (!file_out.good())
+		{
+			std::cerr << "failed to write file " << file_path << std::endl;
+		}
 		file_out.close();
-
-		delete[] data_array;
 	}
 
 	vector<POI3D> IO3D::loadMatrixBin()
 	{
-		std::ifstream file_in(file_path);
-		if (!file_in)
+		vector<POI3D> poi_queue;
+		MatrixBinView matrix;
+		try
 		{
-			std::cerr << "failed to open file " << file_path << std::endl;
+			matrix.open(file_path);
+		}
+		catch (std::string& error)
+		{
+			std::cerr << error << std::endl;
+			return poi_queue;
 		}
 
-		//read head information
-		int head_info[4];
-		file_in.read((char*)head_info, sizeof(head_info[0]) * 4);
-		int queue_length = head_info[0];
-		setDimX(head_info[1]);
-		setDimY(head_info[2]);
-		setDimZ(head_info[3]);
+		setDimX(matrix.getDimension(0));
+		setDimY(matrix.getDimension(1));
+		setDimZ(matrix.getDimension(2));
+		matrix.toQueue(poi_queue);
 
-		int result_length = 7;
-		int data_length = result_length * queue_length;
-		float* data_array = new float[data_length];
-		file_in.read((char*)data_array, sizeof(float) * data_length);
-		file_in.close();
+		return poi_queue;
+	}
 
-		vector<POI3D> poi_queue;
-		POI3D empty_poi(0, 0, 0);
-		poi_queue.resize(queue_length, empty_poi);
+	void IO3D::saveColumnar3D(vector<POI3D>& poi_queue)
+	{
+		int dimension[3] = { dim_x, dim_y, dim_z };
+		saveColumnar(file_path, COLUMNAR_POI3D, dimension, poi_queue, POI3D(0, 0, 0));
+	}
+
+	vector<POI3D> IO3D::loadColumnar3D()
+	{
+		ColumnarTable table;
+		table.open(file_path);
+		setDimX(table.getDimension(0));
+		setDimY(table.getDimension(1));
+		setDimZ(table.getDimension(2));
+
+		return loadColumnar(table, COLUMNAR_POI3D, POI3D(0, 0, 0));
+	}
+
+
+
+	MatrixBinView::MatrixBinView() : matrix_data(nullptr), poi_number(0)
+	{
+		dimension[0] = 0;
+		dimension[1] = 0;
+		dimension[2] = 0;
+	}
+
+	MatrixBinView::~MatrixBinView()
+	{
+		close();
+	}
+
+	void MatrixBinView::open(string file_path)
+	{
+		close();
 
-		for (int i = 0; i < queue_length; i++)
+		if (!mapped_file.open(file_path))
 		{
-			poi_queue[i].x = data_array[i * result_length];
-			poi_queue[i].y = data_array[i * result_length + 1];
-			poi_queue[i].z = data_array[i * result_length + 2];
-			poi_queue[i].deformation.u = data_array[i * result_length + 3];
-			poi_queue[i].deformation.v = data_array[i * result_length + 4];
-			poi_queue[i].deformation.w = data_array[i * result_length + 5];
-			poi_queue[i].result.zncc = data_array[i * result_length + 6];
+			throw std::string("Failed to map file " + file_path);
 		}
 
-		delete[] data_array;
+		const char* data = mapped_file.data();
+		size_t data_size = mapped_file.size();
 
-		return poi_queue;
+		//read the header through memcpy, the extended number of POIs is not aligned to 8 bytes in general
+		int32_t head_info[4];
+		int64_t queue_length = -1;
+		size_t header_size = sizeof(head_info);
+		if (data_size >= header_size)
+		{
+			std::memcpy(head_info, data, sizeof(head_info));
+			queue_length = head_info[0];
+			if (head_info[0] == -1 && data_size >= header_size + sizeof(int64_t))
+			{
+				std::memcpy(&queue_length, data + header_size, sizeof(int64_t));
+				header_size += sizeof(int64_t);
+			}
+		}
+
+		//the rows must fill the rest of file exactly
+		const uint64_t row_size = sizeof(float) * ROW_LENGTH;
+		if (queue_length < 0 || (uint64_t)queue_length > (data_size - header_size) / row_size
+			|| header_size + row_size * (uint64_t)queue_length != data_size
+			|| head_info[1] < 0 || head_info[2] < 0 || head_info[3] < 0)
+		{
+			mapped_file.close();
+			throw std::string("Invalid binary matrix: " + file_path);
+		}
+
+		matrix_data = (const float*)(data + header_size);
+		poi_number = (size_t)queue_length;
+		dimension[0] = head_info[1];
+		dimension[1] = head_info[2];
+		dimension[2] = head_info[3];
+	}
+
+	void MatrixBinView::close()
+	{
+		mapped_file.close();
+		matrix_data = nullptr;
+		poi_number = 0;
+		dimension[0] = 0;
+		dimension[1] = 0;
+		dimension[2] = 0;
+	}
+
+	size_t MatrixBinView::getPOINumber() const
+	{
+		return poi_number;
+	}
+
+	int MatrixBinView::getDimension(int axis) const
+	{
+		return (axis >= 0 && axis < 3) ? dimension[axis] : 0;
+	}
+
+	const float* MatrixBinView::getRow(size_t poi_index) const
+	{
+		return poi_index < poi_number ? matrix_data + ROW_LENGTH * poi_index : nullptr;
+	}
+
+	MatrixBinColumn MatrixBinView::getColumn(int field) const
+	{
+		MatrixBinColumn column;
+		column.data = (matrix_data != nullptr && field >= 0 && field < ROW_LENGTH) ? matrix_data + field : nullptr;
+		column.stride = ROW_LENGTH;
+		column.size = column.data != nullptr ? poi_number : 0;
+
+		return column;
+	}
+
+	void MatrixBinView::toQueue(vector<POI3D>& poi_queue) const
+	{
+		POI3D empty_poi(0, 0, 0);
+		poi_queue.assign(poi_number, empty_poi);
+
+		long long queue_length = (long long)poi_number;
+#pragma omp parallel for
+		for (long long i = 0; i < queue_length; i++)
+		{
+			const float* row = matrix_data + ROW_LENGTH * i;
+			POI3D& poi = poi_queue[i];
+			poi.x = row[MATRIX_X];
+			poi.y = row[MATRIX_Y];
+			poi.z = row[MATRIX_Z];
+			poi.deformation.u = row[MATRIX_U];
+			poi.deformation.v = row[MATRIX_V];
+			poi.deformation.w = row[MATRIX_W];
+			poi.result.zncc = row[MATRIX_ZNCC];
+		}
 	}
 
 }//namespace opencorr
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "oc_columnar.h"
 #include "oc_poi.h"
 
 using std::vector;
@@ -27,6 +28,22 @@ using std::string;
 
 namespace opencorr
 {
+	//names and byte offsets of the float fields in POIs, in the order of columnar files
+	void getColumnarFields(POI2D& poi, vector<string>& names, vector<size_t>& offsets);
+	void getColumnarFields(POI2DS& poi, vector<string>& names, vector<size_t>& offsets);
+	void getColumnarFields(POI3D& poi, vector<string>& names, vector<size_t>& offsets);
+
+	//write a float in fixed notation with 8 decimals, up to 64 characters, return the end of output
+	char* formatFixed(float value, char* output);
+
+	//format of maps saved with saveMaps2D, saveMaps2DS and saveMaps3D
+	enum MapFormat
+	{
+		MAP_TEXT = 0, //values separated by delimiter, the same as saveMap2D, saveMap2DS and saveMap3D
+		MAP_RAW = 1, //32-bit float without header, x the fastest, then y and z
+		MAP_TIFF = 2 //32-bit float TIFF, one page per slice in 3D
+	};
+
 	//This module is made to input data from csv table and output data to csv data
 	class IO2D
 	{
@@ -60,6 +77,11 @@ namespace opencorr
 		//variable: 'u', 'v', 'c'(zncc), 'd'(convergence), 'i'(iteration), 'f'(feature), 'x' (exx), 'y' (eyy), 'r' (exy)
 		void saveMap2D(vector<POI2D>& poi_queue, char variable);
 
+		//save the maps of several variables in one pass, e.g. "uvxyr", each map is saved in the file path with suffix
+		//of the variable, e.g. map_u.tif for map.tif. The maps are downsampled by an integer factor, averaging the
+		//POIs in a cell
+		void saveMaps2D(vector<POI2D>& poi_queue, string variables, int format, int downsampling = 1);
+
 		//load deformation of POIs from saved date table
 		vector<POI2DS> loadTable2DS();
 
@@ -67,6 +89,14 @@ namespace opencorr
 
 		//variable: 'u', 'v', 'w', 'c'(r1r2_zncc), 'd'(r1t1_zncc), 'e'(r1t2_zncc), 'x' (exx), 'y' (eyy), 'z' (ezz), 'r' (exy) , 's' (eyz), 't' (ezx)
 		void saveMap2DS(vector<POI2DS>& poi_queue, char variable);
+		void saveMaps2DS(vector<POI2DS>& poi_queue, string variables, int format, int downsampling = 1);
+
+		//save and load all the fields of POIs in binary columnar format, the width and height are kept in header,
+		//use ColumnarTable to access the columns without loading the whole file
+		void saveColumnar2D(vector<POI2D>& poi_queue);
+		vector<POI2D> loadColumnar2D();
+		void saveColumnar2DS(vector<POI2DS>& poi_queue);
+		vector<POI2DS> loadColumnar2DS();
 	};
 
 	class IO3D
@@ -103,10 +133,75 @@ namespace opencorr
 		//variable: 'u', 'v', 'w', 'c'(zncc), 'x' (exx), 'y' (eyy), 'z' (ezz), 'r' (exy) , 's' (eyz), 't' (ezx)
 		void saveMap3D(vector<POI3D>& poi_queue, char variable);
 
-		//save and load deformation of POIs into a binary matrix
+		//save the maps of several variables in one pass, see IO2D::saveMaps2D
+		void saveMaps3D(vector<POI3D>& poi_queue, string variables, int format, int downsampling = 1);
+
+		//save and load deformation of POIs into a binary matrix, see MatrixBinView for the layout. The file is
+		//mapped in loading and converted into the queue in parallel
 		void saveMatrixBin(vector<POI3D>& poi_queue);
 		vector<POI3D> loadMatrixBin();
 
+		//save and load all the fields of POIs in binary columnar format, the dimensions are kept in header
+		void saveColumnar3D(vector<POI3D>& poi_queue);
+		vector<POI3D> loadColumnar3D();
+
+	};
+
+	//fields in each row of binary matrix
+	enum MatrixBinField
+	{
+		MATRIX_X = 0,
+		MATRIX_Y = 1,
+		MATRIX_Z = 2,
+		MATRIX_U = 3,
+		MATRIX_V = 4,
+		MATRIX_W = 5,
+		MATRIX_ZNCC = 6
+	};
+
+	//a field of all the POIs in binary matrix, the neighbouring values are one row apart
+	struct MatrixBinColumn
+	{
+		const float* data;
+		size_t stride; //number of floats in a row
+		size_t size; //number of POIs
+
+		float operator[](size_t index) const
+		{
+			return data[index * stride];
+		}
+	};
+
+	//zero-copy view of a binary matrix saved by IO3D::saveMatrixBin, through memory mapping. The header consists
+	//of 4 int32: the number of POIs, dim_x, dim_y and dim_z. For more than INT_MAX POIs, the first int32 is -1
+	//and followed by the number of POIs in int64. Then come the rows of POIs, 7 floats in each row
+	class MatrixBinView
+	{
+	private:
+		MappedFile mapped_file;
+		const float* matrix_data;
+		size_t poi_number;
+		int dimension[3];
+
+	public:
+		static const int ROW_LENGTH = 7;
+
+		MatrixBinView();
+		~MatrixBinView();
+
+		//the header is validated against the size of file
+		void open(string file_path);
+		void close();
+
+		size_t getPOINumber() const;
+		int getDimension(int axis) const;
+
+		//pointers into mapped file, valid until close()
+		const float* getRow(size_t poi_index) const;
+		MatrixBinColumn getColumn(int field) const;
+
+		//bulk conversion into a queue of POIs, which is resized to the number of POIs
+		void toQueue(vector<POI3D>& poi_queue) const;
 	};
 
 }//namespace opencorr
@@ -0,0 +1,256 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+
+#include "oc_multiview.h"
+
+namespace opencorr
+{
+	//maximum squared reprojection error over the views selected by mask
+	inline double maxReprojection(const double* projection, const double* image_x, const double* image_y,
+		int view_number, unsigned int mask, const double* space_coor)
+	{
+		double max_error = 0;
+		for (int i = 0; i < view_number; i++)
+		{
+			if ((mask >> i & 1u) == 0)
+			{
+				continue;
+			}
+
+			const double* P = projection + 12 * i;
+			double depth = P[8] * space_coor[0] + P[9] * space_coor[1] + P[10] * space_coor[2] + P[11];
+			double error_x = (P[0] * space_coor[0] + P[1] * space_coor[1] + P[2] * space_coor[2] + P[3]) / depth - image_x[i];
+			double error_y = (P[4] * space_coor[0] + P[5] * space_coor[1] + P[6] * space_coor[2] + P[7]) / depth - image_y[i];
+			max_error = std::max(max_error, error_x * error_x + error_y * error_y);
+		}
+
+		return max_error;
+	}
+
+	//triangulate with the valid views, then reject views one by one while the reprojection error exceeds the threshold,
+	//as the least squares solution spreads the error of an outlier over all views, the rejected view is the one
+	//whose removal leads to the smallest reprojection error of the others
+	inline unsigned int reconstructPoint(const double* projection, const double* image_x, const double* image_y,
+		int view_number, float outlier_threshold, int min_views, double* space_coor)
+	{
+		unsigned int mask = 0;
+		int valid_number = 0;
+		for (int i = 0; i < view_number; i++)
+		{
+			if (!std::isnan(image_x[i]) && !std::isnan(image_y[i]))
+			{
+				mask |= 1u << i;
+				valid_number++;
+			}
+		}
+
+		if (valid_number < 2 || !Stereovision::triangulateViews(projection, image_x, image_y, view_number, mask, space_coor))
+		{
+			return 0;
+		}
+		if (outlier_threshold <= 0)
+		{
+			return mask;
+		}
+
+		double threshold2 = (double)outlier_threshold * outlier_threshold;
+		double error = maxReprojection(projection, image_x, image_y, view_number, mask, space_coor);
+		while (error > threshold2 && valid_number > min_views)
+		{
+			unsigned int best_mask = 0;
+			double best_error = 0;
+			double best_coor[3];
+			for (int i = 0; i < view_number; i++)
+			{
+				unsigned int trial_mask = mask & ~(1u << i);
+				double trial_coor[3];
+				if (trial_mask == mask || !Stereovision::triangulateViews(projection, image_x, image_y, view_number, trial_mask, trial_coor))
+				{
+					continue;
+				}
+
+				double trial_error = maxReprojection(projection, image_x, image_y, view_number, trial_mask, trial_coor);
+				if (best_mask == 0 || trial_error < best_error)
+				{
+					best_mask = trial_mask;
+					best_error = trial_error;
+					best_coor[0] = trial_coor[0];
+					best_coor[1] = trial_coor[1];
+					best_coor[2] = trial_coor[2];
+				}
+			}
+
+			if (best_mask == 0)
+			{
+				break;
+			}
+
+			mask = best_mask;
+			error = best_error;
+			space_coor[0] = best_coor[0];
+			space_coor[1] = best_coor[1];
+			space_coor[2] = best_coor[2];
+			valid_number--;
+		}
+
+		return mask;
+	}
+
+	Multiview::Multiview(std::vector<Calibration*>& view_cams, int thread_number)
+	{
+		updateCameras(view_cams);
+		this->thread_number = thread_number;
+		outlier_threshold = 0.f;
+		min_views = 2;
+	}
+
+	Multiview::~Multiview() {}
+
+	void Multiview::updateCameras(std::vector<Calibration*>& view_cams)
+	{
+		if (view_cams.size() < 2 || view_cams.size() > 32)
+		{
+			throw std::string("Number of views should be within 2 to 32");
+		}
+
+		this->view_cams = view_cams;
+		view_number = (int)view_cams.size();
+	}
+
+	void Multiview::setOutlier(float outlier_threshold, int min_views)
+	{
+		this->outlier_threshold = outlier_threshold;
+		this->min_views = min_views < 2 ? 2 : min_views;
+	}
+
+	void Multiview::prepare()
+	{
+		projection.resize(12 * view_number);
+		for (int i = 0; i < view_number; i++)
+		{
+			view_cams[i]->updateMatrices();
+			for (int r = 0; r < 3; r++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					projection[12 * i + 4 * r + c] = (double)view_cams[i]->projection_matrix(r, c);
+				}
+			}
+		}
+	}
+
+	Point3D Multiview::reconstruct(std::vector<Point2D>& view_points)
+	{
+		if ((int)view_points.size() != view_number)
+		{
+			throw std::string("Mismatched number of views");
+		}
+		if ((int)projection.size() != 12 * view_number)
+		{
+			throw std::string("Projection matrices not prepared");
+		}
+
+		double image_x[32], image_y[32];
+		for (int i = 0; i < view_number; i++)
+		{
+			Point2D undistorted_point = view_cams[i]->undistort(view_points[i]);
+			image_x[i] = undistorted_point.x;
+			image_y[i] = undistorted_point.y;
+		}
+
+		Point3D space_3d_point;
+		double space_coor[3];
+		if (reconstructPoint(projection.data(), image_x, image_y, view_number, outlier_threshold, min_views, space_coor) != 0)
+		{
+			space_3d_point.x = (float)space_coor[0];
+			space_3d_point.y = (float)space_coor[1];
+			space_3d_point.z = (float)space_coor[2];
+		}
+
+		return space_3d_point;
+	}
+
+	void Multiview::reconstruct(std::vector<std::vector<float>>& view_x, std::vector<std::vector<float>>& view_y,
+		std::vector<float>& space_x, std::vector<float>& space_y, std::vector<float>& space_z, std::vector<int>* view_mask)
+	{
+		if ((int)view_x.size() != view_number || (int)view_y.size() != view_number)
+		{
+			throw std::string("Mismatched number of views");
+		}
+		if ((int)projection.size() != 12 * view_number)
+		{
+			throw std::string("Projection matrices not prepared");
+		}
+
+		int queue_length = (int)view_x[0].size();
+		for (int i = 0; i < view_number; i++)
+		{
+			if ((int)view_x[i].size() != queue_length || (int)view_y[i].size() != queue_length)
+			{
+				throw std::string("Mismatched length of coordinate arrays");
+			}
+		}
+
+		space_x.resize(queue_length);
+		space_y.resize(queue_length);
+		space_z.resize(queue_length);
+		if (view_mask != nullptr)
+		{
+			view_mask->resize(queue_length);
+		}
+
+		//the points are undistorted in chunks through the batch interface of Calibration, then solved point by point
+		const int chunk_size = 1024;
+		int chunk_number = (queue_length + chunk_size - 1) / chunk_size;
+
+#pragma omp parallel for
+		for (int k = 0; k < chunk_number; k++)
+		{
+			int chunk_begin = k * chunk_size;
+			int chunk_length = std::min(chunk_size, queue_length - chunk_begin);
+
+			std::vector<float> undistorted_x(view_number * chunk_size), undistorted_y(view_number * chunk_size);
+			for (int i = 0; i < view_number; i++)
+			{
+				view_cams[i]->undistort(&view_x[i][chunk_begin], &view_y[i][chunk_begin],
+					&undistorted_x[i * chunk_size], &undistorted_y[i * chunk_size], chunk_length);
+			}
+
+			double image_x[32], image_y[32];
+			for (int j = 0; j < chunk_length; j++)
+			{
+				for (int i = 0; i < view_number; i++)
+				{
+					image_x[i] = undistorted_x[i * chunk_size + j];
+					image_y[i] = undistorted_y[i * chunk_size + j];
+				}
+
+				double space_coor[3];
+				unsigned int mask = reconstructPoint(projection.data(), image_x, image_y, view_number, outlier_threshold, min_views, space_coor);
+
+				int idx = chunk_begin + j;
+				space_x[idx] = mask != 0 ? (float)space_coor[0] : 0.f;
+				space_y[idx] = mask != 0 ? (float)space_coor[1] : 0.f;
+				space_z[idx] = mask != 0 ? (float)space_coor[2] : 0.f;
+				if (view_mask != nullptr)
+				{
+					(*view_mask)[idx] = (int)mask;
+				}
+			}
+		}
+	}
+
+}//namespace opencorr
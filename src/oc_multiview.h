@@ -0,0 +1,56 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _MULTIVIEW_H_
+#define _MULTIVIEW_H_
+
+#include "oc_array.h"
+#include "oc_calibration.h"
+#include "oc_point.h"
+#include "oc_stereovision.h"
+
+namespace opencorr
+{
+	class Multiview
+	{
+	protected:
+		std::vector<Calibration*> view_cams; //intrinsics and extrinsics of the cameras, up to 32 views
+		int view_number;
+		int thread_number; //CPU thread number
+		std::vector<double> projection; //projection matrices in row-major order, 12 elements per view
+		float outlier_threshold; //reprojection error in pixels, views beyond it are rejected, non-positive value disables the rejection
+		int min_views; //minimum number of views kept in the rejection
+
+	public:
+		Multiview(std::vector<Calibration*>& view_cams, int thread_number);
+		~Multiview();
+
+		void updateCameras(std::vector<Calibration*>& view_cams);
+		void setOutlier(float outlier_threshold, int min_views);
+		void prepare();
+
+		//the points missing in some views are given as NaN, and at least two views are required
+		Point3D reconstruct(std::vector<Point2D>& view_points);
+
+		//batch reconstruction over arrays of coordinates, view_x[i][j] is the x coordinate of point j in view i,
+		//view_mask (optional) stores the views used for each point as bits, 0 for the points failed in reconstruction
+		void reconstruct(std::vector<std::vector<float>>& view_x, std::vector<std::vector<float>>& view_y,
+			std::vector<float>& space_x, std::vector<float>& space_y, std::vector<float>& space_z, std::vector<int>* view_mask = nullptr);
+	};
+
+}//namespace opencorr
+
+#endif //_MULTIVIEW_H_
@@ -72,30 +72,33 @@ namespace opencorr
 		instance->sd_img = new3D(subset_height, subset_width, 6);
 	}
 
-	NR2D1_* NR2D1::getInstance(int tid)
+	NR2D1_* NR2D1::getInstance()
 	{
-		if (tid >= (int)instance_pool.size())
+		NR2D1_* instance = workspace.local();
+
+		//follow the subset radius of engine, which may be changed after the instance is created
+		if (instance->ref_subset->radius_x != subset_radius_x || instance->ref_subset->radius_y != subset_radius_y)
 		{
-			throw std::string("CPU thread ID over limit");
+			NR2D1_::update(instance, subset_radius_x, subset_radius_y);
 		}
 
-		return instance_pool[tid];
+		return instance;
 	}
 
 	NR2D1::NR2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number)
-		: tar_gradient(nullptr)
+		: tar_gradient(nullptr),
+		workspace([this] { return NR2D1_::allocate(this->subset_radius_x, this->subset_radius_y); },
+			[](NR2D1_* instance)
+			{
+				NR2D1_::release(instance);
+				delete instance;
+			})
 	{
 		this->subset_radius_x = subset_radius_x;
 		this->subset_radius_y = subset_radius_y;
 		this->conv_criterion = conv_criterion;
 		this->stop_condition = stop_condition;
 		this->thread_number = thread_number;
-
-		for (int i = 0; i < thread_number; i++)
-		{
-			NR2D1_* instance = NR2D1_::allocate(subset_radius_x, subset_radius_y);
-			instance_pool.push_back(instance);
-		}
 	}
 
 	NR2D1::~NR2D1()
@@ -104,13 +107,6 @@ namespace opencorr
 		delete tar_interp;
 		delete tar_interp_x;
 		delete tar_interp_y;
-
-		for (auto& instance : instance_pool)
-		{
-			NR2D1_::release(instance);
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	void NR2D1::setIteration(float conv_criterion, float stop_condition)
@@ -173,7 +169,7 @@ namespace opencorr
 	void NR2D1::compute(POI2D* poi)
 	{
 		//set instance w.r.t. thread id 
-		NR2D1_* cur_instance = getInstance(omp_get_thread_num());
+		NR2D1_* cur_instance = getInstance();
 
 		if (poi->y - subset_radius_y < 0 || poi->x - subset_radius_x < 0
 			|| poi->y + subset_radius_y > ref_img->height - 1 || poi->x + subset_radius_x > ref_img->width - 1
@@ -333,12 +329,7 @@ namespace opencorr
 
 	void NR2D1::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i]);
-		}
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
 	}
 
 }//namespace opencorr
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include "oc_poi.h"
 #include "oc_point.h"
 #include "oc_subset.h"
+#include "oc_workspace.h"
 
 namespace opencorr
 {
@@ -59,8 +60,8 @@ namespace opencorr
 		float conv_criterion; //convergence criterion: norm of maximum deformation increment in subset
 		float stop_condition; //stop condition: max iteration
 
-		std::vector<NR2D1_*> instance_pool; //pool of instances for multi-thread processing
-		NR2D1_* getInstance(int tid); //get an instance according to the number of current thread id
+		Workspace<NR2D1_> workspace; //instances of the threads running this engine
+		NR2D1_* getInstance(); //instance of calling thread
 
 	public:
 		NR2D1(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition, int thread_number);
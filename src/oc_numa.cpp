@@ -0,0 +1,206 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#endif
+
+#include <algorithm>
+#include <omp.h>
+
+#include "oc_numa.h"
+
+namespace opencorr
+{
+	namespace
+	{
+		//NUMA nodes of the system, detected once
+		struct NumaTopology
+		{
+			int node_number;
+			std::vector<int> cpu_node; //node of each CPU, used on Linux only
+		};
+
+#if !defined(_WIN32) && defined(__linux__)
+		//parse a list of ranges in sysfs, e.g. "0-15,32-47"
+		std::vector<int> readCpuList(std::string file_path)
+		{
+			std::vector<int> cpus;
+			std::ifstream list_file(file_path);
+			std::string list;
+			if (!std::getline(list_file, list))
+			{
+				return cpus;
+			}
+
+			std::stringstream list_stream(list);
+			std::string range;
+			while (std::getline(list_stream, range, ','))
+			{
+				size_t dash = range.find('-');
+				try
+				{
+					int first = std::stoi(range.substr(0, dash));
+					int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+					for (int cpu = first; cpu <= last; cpu++)
+					{
+						cpus.push_back(cpu);
+					}
+				}
+				catch (...)
+				{
+					break;
+				}
+			}
+
+			return cpus;
+		}
+#endif
+
+		NumaTopology detectTopology()
+		{
+			NumaTopology topology;
+			topology.node_number = 1;
+
+#ifdef _WIN32
+			ULONG highest_node = 0;
+			if (GetNumaHighestNodeNumber(&highest_node))
+			{
+				topology.node_number = (int)highest_node + 1;
+			}
+#elif defined(__linux__)
+			std::vector<int> nodes = readCpuList("/sys/devices/system/node/online");
+			if (!nodes.empty())
+			{
+				topology.node_number = *std::max_element(nodes.begin(), nodes.end()) + 1;
+			}
+			for (int node = 0; node < topology.node_number; node++)
+			{
+				std::vector<int> cpus = readCpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+				for (auto& cpu : cpus)
+				{
+					if (cpu >= (int)topology.cpu_node.size())
+					{
+						topology.cpu_node.resize(cpu + 1, 0);
+					}
+					topology.cpu_node[cpu] = node;
+				}
+			}
+#endif
+
+			return topology;
+		}
+
+		const NumaTopology& getTopology()
+		{
+			static NumaTopology topology = detectTopology();
+			return topology;
+		}
+	}
+
+	int getNumaNodeNumber()
+	{
+		return getTopology().node_number;
+	}
+
+	int getNumaNode()
+	{
+		const NumaTopology& topology = getTopology();
+		if (topology.node_number == 1)
+		{
+			return 0;
+		}
+
+#ifdef _WIN32
+		PROCESSOR_NUMBER processor;
+		GetCurrentProcessorNumberEx(&processor);
+		USHORT node = 0;
+		if (GetNumaProcessorNodeEx(&processor, &node))
+		{
+			return (int)node;
+		}
+#elif defined(__linux__)
+		int cpu = sched_getcpu();
+		if (cpu >= 0 && cpu < (int)topology.cpu_node.size())
+		{
+			return topology.cpu_node[cpu];
+		}
+#endif
+
+		return 0;
+	}
+
+	void mapNumaTeam(NumaTeam& team)
+	{
+		int node = getNumaNode();
+
+#pragma omp single
+		{
+			team.thread_band.assign(omp_get_num_threads(), 0);
+		}
+		team.thread_band[omp_get_thread_num()] = node;
+#pragma omp barrier
+
+#pragma omp single
+		{
+			//replace the node of each thread with the rank of node among the nodes hosting the team
+			std::vector<int> nodes = team.thread_band;
+			std::sort(nodes.begin(), nodes.end());
+			nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+			team.band_number = (int)nodes.size();
+			team.band_threads.assign(team.band_number, 0);
+			team.thread_rank.assign(team.thread_band.size(), 0);
+			for (int i = 0; i < (int)team.thread_band.size(); i++)
+			{
+				int band = (int)(std::lower_bound(nodes.begin(), nodes.end(), team.thread_band[i]) - nodes.begin());
+				team.thread_band[i] = band;
+				team.thread_rank[i] = team.band_threads[band]++;
+			}
+		}
+	}
+
+	void getNumaBand(long long length, int band, int band_number, long long& begin, long long& end)
+	{
+		begin = length * band / band_number;
+		end = length * (band + 1) / band_number;
+	}
+
+	void numaFor(int length, std::function<void(int begin, int end)> body)
+	{
+		NumaTeam team;
+#pragma omp parallel
+		{
+			mapNumaTeam(team);
+
+			int thread_index = omp_get_thread_num();
+			int band = team.thread_band[thread_index];
+			long long band_begin, band_end, begin, end;
+			getNumaBand(length, band, team.band_number, band_begin, band_end);
+			getNumaBand(band_end - band_begin, team.thread_rank[thread_index], team.band_threads[band], begin, end);
+			if (begin < end)
+			{
+				body((int)(band_begin + begin), (int)(band_begin + end));
+			}
+		}
+	}
+
+}//namespace opencorr
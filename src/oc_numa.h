@@ -0,0 +1,52 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _NUMA_H_
+#define _NUMA_H_
+
+#include <functional>
+#include <vector>
+
+namespace opencorr
+{
+	int getNumaNodeNumber(); //number of NUMA nodes in the system, 1 if unknown
+	int getNumaNode(); //node of the CPU running calling thread, 0 if unknown
+
+	//threads of an OpenMP team grouped by the NUMA nodes they run on, the nodes without thread of the team are
+	//skipped. The threads should be bound to CPUs (e.g. OMP_PROC_BIND=close and OMP_PLACES=cores), otherwise
+	//a thread may move to another node after mapping
+	struct NumaTeam
+	{
+		int band_number; //number of nodes hosting the threads of team
+		std::vector<int> thread_band; //band of each thread, the bands follow the order of nodes
+		std::vector<int> thread_rank; //rank of each thread among the threads in its band
+		std::vector<int> band_threads; //number of threads in each band
+	};
+
+	//called by all the threads of a team inside a parallel region, team is shared by the threads and filled on return
+	void mapNumaTeam(NumaTeam& team);
+
+	//range [begin, end) of a band among band_number bands dividing [0, length) evenly
+	void getNumaBand(long long length, int band, int band_number, long long& begin, long long& end);
+
+	//process [0, length) along an axis of image in parallel, the threads on a node take the band of the node and
+	//divide it evenly. The arrays written here are first touched by the threads processing the POIs in them,
+	//as Scheduler divides the POIs into the same bands
+	void numaFor(int length, std::function<void(int begin, int end)> body);
+
+}//namespace opencorr
+
+#endif //_NUMA_H_
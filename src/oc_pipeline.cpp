@@ -0,0 +1,299 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <omp.h>
+
+#include "oc_pipeline.h"
+
+namespace opencorr
+{
+	PipelineFrame::PipelineFrame() : index(-1), slot(-1) {}
+
+	FramePipeline::FramePipeline(int frame_number)
+	{
+		this->frame_number = frame_number < 1 ? 1 : frame_number;
+		slot_number = this->frame_number;
+		core_budget = 0;
+		memory_budget = 0;
+		frame_memory = 0;
+		sequence_length = 0;
+		aborted = false;
+		start_time = 0.;
+		end_time = 0.;
+	}
+
+	int FramePipeline::addStage(std::string name, std::function<void(PipelineFrame&)> task, int threads, std::vector<int> dependencies)
+	{
+		int stage_index = (int)stages.size();
+		for (auto& dependency : dependencies)
+		{
+			if (dependency < 0 || dependency >= stage_index)
+			{
+				throw std::string("Stage " + name + " depends on a stage not added before");
+			}
+		}
+
+		PipelineStage stage;
+		stage.name = name;
+		stage.task = task;
+		stage.threads = threads < 1 ? 1 : threads;
+		stage.budget_threads = stage.threads;
+		stage.dependencies = dependencies;
+		stage.completed = 0;
+		stage.busy_time = 0.;
+		stage.max_time = 0.;
+		stages.push_back(stage);
+
+		applyBudget();
+		return stage_index;
+	}
+
+	void FramePipeline::setCoreBudget(int cores)
+	{
+		core_budget = cores;
+		applyBudget();
+	}
+
+	void FramePipeline::setMemoryBudget(size_t memory_budget, size_t frame_memory)
+	{
+		this->memory_budget = memory_budget;
+		this->frame_memory = frame_memory;
+		applyBudget();
+	}
+
+	void FramePipeline::applyBudget()
+	{
+		slot_number = frame_number;
+		if (memory_budget > 0 && frame_memory > 0)
+		{
+			size_t affordable = memory_budget / frame_memory;
+			slot_number = (int)std::max((size_t)1, std::min(affordable, (size_t)frame_number));
+		}
+
+		int requested_threads = 0;
+		for (auto& stage : stages)
+		{
+			requested_threads += stage.threads;
+		}
+
+		//every stage keeps at least one thread even if the budget is smaller than the number of stages
+		for (auto& stage : stages)
+		{
+			stage.budget_threads = stage.threads;
+			if (core_budget > 0 && requested_threads > core_budget)
+			{
+				stage.budget_threads = std::max(1, stage.threads * core_budget / requested_threads);
+			}
+		}
+	}
+
+	int FramePipeline::getSlotNumber() const
+	{
+		return slot_number;
+	}
+
+	int FramePipeline::getStageThreads(int stage_index) const
+	{
+		return stages[stage_index].budget_threads;
+	}
+
+	bool FramePipeline::ready(int stage_index, int frame_index) const
+	{
+		for (auto& dependency : stages[stage_index].dependencies)
+		{
+			if (stages[dependency].completed <= frame_index)
+			{
+				return false;
+			}
+		}
+
+		//the slot is free once all the stages have finished the frame occupying it
+		for (auto& stage : stages)
+		{
+			if (stage.completed <= frame_index - slot_number)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void FramePipeline::stageLoop(int stage_index)
+	{
+		PipelineStage& stage = stages[stage_index];
+		omp_set_num_threads(stage.budget_threads);
+
+		for (int frame_index = 0; frame_index < sequence_length; frame_index++)
+		{
+			int slot = frame_index % slot_number;
+			{
+				std::unique_lock<std::mutex> lock(pipeline_mutex);
+				pipeline_condition.wait(lock, [&] { return aborted || ready(stage_index, frame_index); });
+				if (aborted)
+				{
+					break;
+				}
+
+				//the first stage starting a frame takes over the slot
+				if (frames[slot].index != frame_index)
+				{
+					frames[slot].index = frame_index;
+					frames[slot].stage_time.assign(stages.size(), 0.);
+					frame_start[slot] = omp_get_wtime();
+				}
+			}
+
+			double stage_start = omp_get_wtime();
+			try
+			{
+				stage.task(frames[slot]);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(pipeline_mutex);
+				if (!error)
+				{
+					error = std::current_exception();
+				}
+				aborted = true;
+				pipeline_condition.notify_all();
+				break;
+			}
+			double stage_end = omp_get_wtime();
+
+			std::lock_guard<std::mutex> lock(pipeline_mutex);
+			stage.busy_time += stage_end - stage_start;
+			stage.max_time = std::max(stage.max_time, stage_end - stage_start);
+			stage.completed++;
+			frames[slot].stage_time[stage_index] = stage_end;
+
+			bool frame_done = true;
+			for (auto& other_stage : stages)
+			{
+				if (other_stage.completed <= frame_index)
+				{
+					frame_done = false;
+					break;
+				}
+			}
+			if (frame_done)
+			{
+				latency_record.push_back(stage_end - frame_start[slot]);
+				end_time = stage_end;
+			}
+			pipeline_condition.notify_all();
+		}
+	}
+
+	void FramePipeline::run(int sequence_length)
+	{
+		if (stages.empty())
+		{
+			throw std::string("No stage in pipeline");
+		}
+
+		applyBudget();
+		this->sequence_length = sequence_length;
+		aborted = false;
+		error = nullptr;
+		for (auto& stage : stages)
+		{
+			stage.completed = 0;
+			stage.busy_time = 0.;
+			stage.max_time = 0.;
+		}
+
+		//the frames are allocated once and recycled through the slots
+		frames.assign(slot_number, PipelineFrame());
+		for (int i = 0; i < slot_number; i++)
+		{
+			frames[i].slot = i;
+		}
+		frame_start.assign(slot_number, 0.);
+		latency_record.clear();
+
+		start_time = omp_get_wtime();
+		end_time = start_time;
+
+		std::vector<std::thread> stage_threads;
+		for (int i = 0; i < (int)stages.size(); i++)
+		{
+			stage_threads.push_back(std::thread(&FramePipeline::stageLoop, this, i));
+		}
+		for (auto& stage_thread : stage_threads)
+		{
+			stage_thread.join();
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+	PipelineStatistics FramePipeline::getStatistics() const
+	{
+		PipelineStatistics statistics;
+		statistics.completed_frames = (int)latency_record.size();
+		statistics.wall_time = end_time - start_time;
+		statistics.throughput = 0.;
+		statistics.latency_mean = 0.;
+		statistics.latency_max = 0.;
+		statistics.bottleneck = -1;
+
+		double longest_busy_time = -1.;
+		for (int i = 0; i < (int)stages.size(); i++)
+		{
+			const PipelineStage& stage = stages[i];
+			PipelineStageStatistics stage_statistics;
+			stage_statistics.name = stage.name;
+			stage_statistics.threads = stage.budget_threads;
+			stage_statistics.frames = stage.completed;
+			stage_statistics.busy_time = stage.busy_time;
+			stage_statistics.mean_time = stage.completed > 0 ? stage.busy_time / stage.completed : 0.;
+			stage_statistics.max_time = stage.max_time;
+			statistics.stages.push_back(stage_statistics);
+
+			if (stage.busy_time > longest_busy_time)
+			{
+				longest_busy_time = stage.busy_time;
+				statistics.bottleneck = i;
+			}
+		}
+
+		int completed = statistics.completed_frames;
+		if (completed == 0)
+		{
+			return statistics;
+		}
+
+		if (statistics.wall_time > 0)
+		{
+			statistics.throughput = completed / statistics.wall_time;
+		}
+
+		double latency_sum = 0.;
+		for (auto& value : latency_record)
+		{
+			latency_sum += value;
+			statistics.latency_max = std::max(statistics.latency_max, value);
+		}
+		statistics.latency_mean = latency_sum / completed;
+
+		return statistics;
+	}
+
+}//namespace opencorr
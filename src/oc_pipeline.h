@@ -0,0 +1,123 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opencorr
+{
+	//a frame in flight, the data of frame are kept by users in containers indexed with slot
+	class PipelineFrame
+	{
+	public:
+		int index; //index of frame in the sequence
+		int slot; //in [0, frame number in flight), e.g. to select the images and engines holding the data of this frame
+		std::vector<double> stage_time; //completion time stamps of stages, obtained with omp_get_wtime()
+
+		PipelineFrame();
+		~PipelineFrame() = default;
+	};
+
+	struct PipelineStageStatistics
+	{
+		std::string name;
+		int threads; //OpenMP threads actually used, after the core budget is applied
+		int frames; //frames processed
+		double busy_time; //sum of processing time, in seconds
+		double mean_time, max_time; //processing time of a frame, in seconds
+	};
+
+	struct PipelineStatistics
+	{
+		int completed_frames;
+		double wall_time; //in seconds
+		double throughput; //completed frames per second
+		double latency_mean, latency_max; //from the start of the first stage to the end of the last stage of a frame
+		int bottleneck; //stage with the longest busy time, which bounds the throughput
+		std::vector<PipelineStageStatistics> stages;
+	};
+
+	//pipeline processing a sequence of frames through a directed acyclic graph of stages. Each stage runs in its own
+	//thread with its own group of OpenMP threads, and processes the frames one by one in the order of sequence, thus
+	//a stage may keep states across frames, e.g. the results of last frame used as initial guess. A stage starts
+	//a frame once the stages it depends on have finished the frame, so stage k of frame t+1 overlaps with stage k+1
+	//of frame t. At most frame_number frames are in flight, a new frame waits for a free slot (back-pressure)
+	class FramePipeline
+	{
+	private:
+		struct PipelineStage
+		{
+			std::string name;
+			std::function<void(PipelineFrame&)> task;
+			int threads; //requested OpenMP threads
+			int budget_threads; //OpenMP threads after the core budget is applied
+			std::vector<int> dependencies;
+			int completed; //frames finished, in the order of sequence
+			double busy_time, max_time;
+		};
+
+		int frame_number; //requested frames in flight
+		int slot_number; //frames in flight after the memory budget is applied
+		int core_budget; //non-positive value disables the budget
+		size_t memory_budget, frame_memory; //in bytes, zero disables the budget
+
+		std::vector<PipelineStage> stages;
+		std::vector<PipelineFrame> frames;
+
+		int sequence_length;
+		bool aborted;
+		std::exception_ptr error; //the first exception thrown by a stage
+		std::mutex pipeline_mutex;
+		std::condition_variable pipeline_condition;
+
+		double start_time, end_time;
+		std::vector<double> frame_start; //start time of the first stage of each slot
+		std::vector<double> latency_record;
+
+		void applyBudget();
+		bool ready(int stage_index, int frame_index) const; //called with pipeline_mutex locked
+		void stageLoop(int stage_index);
+
+	public:
+		FramePipeline(int frame_number);
+		~FramePipeline() = default;
+
+		//the dependencies must be the indices of stages added before, return the index of new stage
+		int addStage(std::string name, std::function<void(PipelineFrame&)> task, int threads, std::vector<int> dependencies = std::vector<int>());
+
+		void setCoreBudget(int cores); //the OpenMP threads of stages are reduced in proportion if they exceed the budget
+		void setMemoryBudget(size_t memory_budget, size_t frame_memory); //limit the frames in flight to budget / memory of a frame
+
+		int getSlotNumber() const; //frames in flight, call it after the budgets are set to allocate the data of slots
+		int getStageThreads(int stage_index) const;
+
+		//process the frames [0, sequence_length), the first exception thrown by a stage stops the pipeline and is rethrown
+		void run(int sequence_length);
+
+		PipelineStatistics getStatistics() const; //valid after run()
+	};
+
+}//namespace opencorr
+
+#endif //_PIPELINE_H_
@@ -0,0 +1,376 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <cstring>
+#include <fstream>
+#include <omp.h>
+
+#include "oc_io.h"
+#include "oc_result_stream.h"
+
+namespace opencorr
+{
+	ResultStream::ResultStream(std::string file_path, int format)
+		: file_path(file_path), delimiter(","), format(format), file_size(0), frame_number(0), csv_type(0),
+		next_buffer(0), writing_buffer(-1), closing(false)
+	{
+		if (format != STREAM_COLUMNAR && format != STREAM_CSV)
+		{
+			throw std::string("Unknown format of ResultStream");
+		}
+
+		dimension[0] = 0;
+		dimension[1] = 0;
+		dimension[2] = 0;
+	}
+
+	ResultStream::~ResultStream()
+	{
+		try
+		{
+			close();
+		}
+		catch (std::string& error)
+		{
+			std::cerr << error << std::endl;
+		}
+	}
+
+	void ResultStream::setDelimiter(std::string delimiter)
+	{
+		this->delimiter = delimiter;
+	}
+
+	void ResultStream::setDimension(int dim_x, int dim_y, int dim_z)
+	{
+		dimension[0] = dim_x;
+		dimension[1] = dim_y;
+		dimension[2] = dim_z;
+	}
+
+	void ResultStream::open()
+	{
+		close();
+
+		data_file = std::fopen(file_path.c_str(), "wb");
+		index_file = std::fopen((file_path + ".idx").c_str(), "wb");
+		if (data_file == nullptr || index_file == nullptr)
+		{
+			close();
+			throw std::string("Failed to open file " + file_path);
+		}
+
+		file_size = 0;
+		frame_number = 0;
+		csv_type = 0;
+		next_buffer = 0;
+		writing_buffer = -1;
+		closing = false;
+		io_error.clear();
+		io_thread = std::thread(&ResultStream::ioLoop, this);
+	}
+
+	void ResultStream::close()
+	{
+		if (io_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				closing = true;
+			}
+			state_changed.notify_all();
+			io_thread.join();
+		}
+
+		if (data_file != nullptr)
+		{
+			std::fclose(data_file);
+			data_file = nullptr;
+		}
+		if (index_file != nullptr)
+		{
+			std::fclose(index_file);
+			index_file = nullptr;
+		}
+
+		if (!io_error.empty())
+		{
+			std::string error = io_error;
+			io_error.clear();
+			throw error;
+		}
+	}
+
+	void ResultStream::ioLoop()
+	{
+		std::unique_lock<std::mutex> lock(state_mutex);
+		while (true)
+		{
+			state_changed.wait(lock, [this] { return writing_buffer >= 0 || closing; });
+			if (writing_buffer < 0)
+			{
+				break;
+			}
+
+			std::vector<char>& frame_data = buffer[writing_buffer];
+			lock.unlock();
+
+			//the index entry is written after the frame is flushed
+			FrameIndex entry;
+			entry.offset = file_size;
+			entry.size = (uint64_t)frame_data.size();
+			bool succeed = std::fwrite(frame_data.data(), 1, frame_data.size(), data_file) == frame_data.size()
+				&& std::fflush(data_file) == 0
+				&& std::fwrite(&entry, sizeof(entry), 1, index_file) == 1
+				&& std::fflush(index_file) == 0;
+			file_size += entry.size;
+
+			lock.lock();
+			if (!succeed && io_error.empty())
+			{
+				io_error = "Failed to write file " + file_path;
+			}
+			writing_buffer = -1;
+			state_changed.notify_all();
+		}
+	}
+
+	void ResultStream::submit(int buffer_index)
+	{
+		{
+			std::unique_lock<std::mutex> lock(state_mutex);
+			state_changed.wait(lock, [this] { return writing_buffer < 0; });
+			if (!io_error.empty())
+			{
+				throw std::string(io_error);
+			}
+			writing_buffer = buffer_index;
+		}
+		state_changed.notify_all();
+
+		next_buffer = 1 - buffer_index;
+		frame_number++;
+	}
+
+	template <typename T>
+	void ResultStream::appendFrame(std::vector<T>& poi_queue, int poi_type, T empty_poi)
+	{
+		if (!io_thread.joinable())
+		{
+			throw std::string("ResultStream is not opened: " + file_path);
+		}
+
+		std::vector<std::string> names;
+		std::vector<size_t> offsets;
+		getColumnarFields(empty_poi, names, offsets);
+
+		std::vector<char>& frame_data = buffer[next_buffer];
+		if (format == STREAM_COLUMNAR)
+		{
+			ColumnarTable::pack(poi_type, dimension, (const char*)poi_queue.data(), sizeof(T), poi_queue.size(),
+				names, offsets, frame_data);
+			submit(next_buffer);
+			return;
+		}
+
+		//the header of csv table is written before the first frame, when I/O thread is idle
+		if (csv_type == 0)
+		{
+			std::string header = "frame" + delimiter;
+			for (int i = 0; i < (int)names.size(); i++)
+			{
+				header += names[i] + delimiter;
+			}
+			header += "\n";
+
+			if (std::fwrite(header.data(), 1, header.size(), data_file) != header.size())
+			{
+				throw std::string("Failed to write file " + file_path);
+			}
+			file_size = header.size();
+			csv_type = poi_type;
+		}
+		else if (csv_type != poi_type)
+		{
+			throw std::string("Type of POI differs from the previous frames in csv stream: " + file_path);
+		}
+
+		std::string frame_label = std::to_string(frame_number) + delimiter;
+		int field_number = (int)names.size();
+		size_t row_capacity = frame_label.size() + field_number * (64 + delimiter.size()) + 1;
+		int thread_number = omp_get_max_threads();
+		long long queue_length = (long long)poi_queue.size();
+
+		csv_buffer.resize(thread_number);
+		std::vector<size_t> part_size(thread_number + 1, 0);
+
+#pragma omp parallel for
+		for (int t = 0; t < thread_number; t++)
+		{
+			long long row_begin = queue_length * t / thread_number;
+			long long row_end = queue_length * (t + 1) / thread_number;
+			std::vector<char>& part = csv_buffer[t];
+			if (part.size() < (row_end - row_begin) * row_capacity)
+			{
+				part.resize((row_end - row_begin) * row_capacity);
+			}
+
+			char* output = part.data();
+			for (long long i = row_begin; i < row_end; i++)
+			{
+				const char* poi_data = (const char*)&poi_queue[i];
+				std::memcpy(output, frame_label.data(), frame_label.size());
+				output += frame_label.size();
+				for (int j = 0; j < field_number; j++)
+				{
+					output = formatFixed(*(const float*)(poi_data + offsets[j]), output);
+					std::memcpy(output, delimiter.data(), delimiter.size());
+					output += delimiter.size();
+				}
+				*output++ = '\n';
+			}
+			part_size[t + 1] = output - part.data();
+		}
+
+		for (int t = 0; t < thread_number; t++)
+		{
+			part_size[t + 1] += part_size[t];
+		}
+		frame_data.resize(part_size[thread_number]);
+		for (int t = 0; t < thread_number; t++)
+		{
+			std::memcpy(frame_data.data() + part_size[t], csv_buffer[t].data(), part_size[t + 1] - part_size[t]);
+		}
+
+		submit(next_buffer);
+	}
+
+	void ResultStream::append(std::vector<POI2D>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI2D, POI2D(0, 0));
+	}
+
+	void ResultStream::append(std::vector<POI2DS>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI2DS, POI2DS(0, 0));
+	}
+
+	void ResultStream::append(std::vector<POI3D>& poi_queue)
+	{
+		appendFrame(poi_queue, COLUMNAR_POI3D, POI3D(0, 0, 0));
+	}
+
+	int ResultStream::getFrameNumber() const
+	{
+		return frame_number;
+	}
+
+
+
+	ResultSequence::ResultSequence() : format(0) {}
+
+	ResultSequence::~ResultSequence()
+	{
+		close();
+	}
+
+	void ResultSequence::open(std::string file_path)
+	{
+		close();
+
+		if (!mapped_file.open(file_path))
+		{
+			throw std::string("Failed to map file " + file_path);
+		}
+
+		const char* data = mapped_file.data();
+		size_t data_size = mapped_file.size();
+		format = (data_size >= 4 && std::memcmp(data, "OCCB", 4) == 0) ? STREAM_COLUMNAR : STREAM_CSV;
+
+		//keep the entries in index file pointing to complete frames
+		std::ifstream index_in(file_path + ".idx", std::ios::in | std::ios::binary);
+		FrameIndex entry;
+		while (index_in.read((char*)&entry, sizeof(entry)))
+		{
+			if (entry.offset + entry.size > data_size)
+			{
+				break;
+			}
+			if (format == STREAM_COLUMNAR
+				&& ColumnarTable::getTableSize(data + entry.offset, data_size - entry.offset) != entry.size)
+			{
+				break;
+			}
+			frame_index.push_back(entry);
+		}
+
+		//recover the frames written after the last complete entry
+		if (format == STREAM_COLUMNAR)
+		{
+			uint64_t position = frame_index.empty() ? 0 : frame_index.back().offset + frame_index.back().size;
+			size_t frame_size;
+			while ((frame_size = ColumnarTable::getTableSize(data + position, data_size - position)) > 0)
+			{
+				entry.offset = position;
+				entry.size = frame_size;
+				frame_index.push_back(entry);
+				position += frame_size;
+			}
+		}
+	}
+
+	void ResultSequence::close()
+	{
+		mapped_file.close();
+		frame_index.clear();
+		format = 0;
+	}
+
+	int ResultSequence::getFormat() const
+	{
+		return format;
+	}
+
+	int ResultSequence::getFrameNumber() const
+	{
+		return (int)frame_index.size();
+	}
+
+	FrameIndex ResultSequence::getFrameIndex(int frame) const
+	{
+		if (frame < 0 || frame >= (int)frame_index.size())
+		{
+			throw std::string("Frame out of range in ResultSequence");
+		}
+
+		return frame_index[frame];
+	}
+
+	void ResultSequence::getFrame(int frame, ColumnarTable& table) const
+	{
+		if (format != STREAM_COLUMNAR)
+		{
+			throw std::string("Frames in csv format can not be viewed as columnar table");
+		}
+
+		FrameIndex entry = getFrameIndex(frame);
+		table.open(mapped_file.data() + entry.offset, (size_t)entry.size);
+	}
+
+	const char* ResultSequence::getFrameData(int frame) const
+	{
+		return mapped_file.data() + getFrameIndex(frame).offset;
+	}
+
+}//namespace opencorr
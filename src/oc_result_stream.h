@@ -0,0 +1,126 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _RESULT_STREAM_H_
+#define _RESULT_STREAM_H_
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "oc_columnar.h"
+#include "oc_poi.h"
+
+namespace opencorr
+{
+	enum StreamFormat
+	{
+		STREAM_COLUMNAR = 1, //each frame is a columnar table aligned to 64 bytes
+		STREAM_CSV = 2 //rows of all frames in one csv table, with the index of frame in the first column
+	};
+
+	//entry of index file, which is named as the data file plus ".idx"
+	struct FrameIndex
+	{
+		uint64_t offset; //offset of frame from the beginning of data file, in bytes
+		uint64_t size; //size of frame in bytes
+	};
+
+	//append results of a sequence of frames to a single file. A frame is packed in the calling thread while the
+	//previous one is written on an I/O thread, the offset of each frame is recorded in the index file once the
+	//frame is flushed. At most one frame is being written at any time, thus a crash loses at most one frame
+	class ResultStream
+	{
+	private:
+		std::string file_path;
+		std::string delimiter;
+		int format;
+		int dimension[3]; //width and height of image in 2D, dim_x, dim_y and dim_z in 3D
+
+		std::FILE* data_file = nullptr;
+		std::FILE* index_file = nullptr;
+		uint64_t file_size; //accessed by I/O thread after opening
+		int frame_number; //number of appended frames
+		int csv_type; //type of POI in csv table, 0 before the first frame
+
+		std::vector<char> buffer[2]; //double buffering, one is packed while the other is written
+		std::vector<std::vector<char>> csv_buffer; //rows formatted by each thread
+		int next_buffer; //buffer to pack next frame
+		int writing_buffer; //buffer being written, -1 if I/O thread is idle
+		bool closing;
+		std::string io_error;
+
+		std::thread io_thread;
+		std::mutex state_mutex;
+		std::condition_variable state_changed;
+
+		void ioLoop();
+		void submit(int buffer_index);
+
+		template <typename T>
+		void appendFrame(std::vector<T>& poi_queue, int poi_type, T empty_poi);
+
+	public:
+		ResultStream(std::string file_path, int format);
+		~ResultStream();
+
+		void setDelimiter(std::string delimiter);
+		void setDimension(int dim_x, int dim_y, int dim_z);
+
+		void open(); //create the data file and the index file, existing files are overwritten
+		void close(); //wait until all appended frames are written
+
+		//a frame can be reused once append() returns
+		void append(std::vector<POI2D>& poi_queue);
+		void append(std::vector<POI2DS>& poi_queue);
+		void append(std::vector<POI3D>& poi_queue);
+
+		int getFrameNumber() const;
+	};
+
+	//random access to the frames in a file written by ResultStream, through memory mapping. The frames written
+	//in columnar format but missing in index file, e.g. after a crash, are recovered by scanning the data file
+	class ResultSequence
+	{
+	private:
+		MappedFile mapped_file;
+		std::vector<FrameIndex> frame_index;
+		int format;
+
+	public:
+		ResultSequence();
+		~ResultSequence();
+
+		void open(std::string file_path);
+		void close();
+
+		int getFormat() const;
+		int getFrameNumber() const;
+		FrameIndex getFrameIndex(int frame) const;
+
+		//view a frame in columnar format, valid until close()
+		void getFrame(int frame, ColumnarTable& table) const;
+
+		//pointer to a frame in mapped file, for either format
+		const char* getFrameData(int frame) const;
+	};
+
+}//namespace opencorr
+
+#endif //_RESULT_STREAM_H_
@@ -0,0 +1,444 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <omp.h>
+
+#include "oc_numa.h"
+#include "oc_scheduler.h"
+
+namespace opencorr
+{
+	//range of tasks owned by a thread, modified with its mutex locked and read without lock when searching a victim
+	struct SchedulerRange
+	{
+		std::mutex range_mutex;
+		std::atomic<long long> begin;
+		std::atomic<long long> end;
+		char padding[64]; //keep the ranges of threads in different cache lines
+	};
+
+	//a POI costs one more than the iterations in its result, which is zero for a POI not processed yet
+	template <class POI>
+	void iterationPrefix(std::vector<POI>& poi_queue, std::vector<double>& cost_prefix)
+	{
+		long long queue_length = (long long)poi_queue.size();
+		cost_prefix.resize(queue_length + 1);
+		cost_prefix[0] = 0;
+		for (long long i = 0; i < queue_length; i++)
+		{
+			cost_prefix[i + 1] = cost_prefix[i] + 1 + std::max(poi_queue[i].result.iteration, 0.f);
+		}
+	}
+
+	double SchedulerReport::getUtilization(int thread_index) const
+	{
+		if (wall_time <= 0 || thread_index < 0 || thread_index >= (int)busy_time.size())
+		{
+			return 0;
+		}
+
+		return busy_time[thread_index] / wall_time;
+	}
+
+	double SchedulerReport::getMeanUtilization() const
+	{
+		if (busy_time.empty())
+		{
+			return 0;
+		}
+
+		double utilization = 0;
+		for (int i = 0; i < (int)busy_time.size(); i++)
+		{
+			utilization += getUtilization(i);
+		}
+
+		return utilization / busy_time.size();
+	}
+
+	Scheduler::Scheduler() : chunk_size(0), cost_source(COST_UNIFORM), numa_aware(true), numa_extent(0) {}
+
+	void Scheduler::setChunkSize(int chunk_size)
+	{
+		this->chunk_size = chunk_size > 0 ? chunk_size : 0;
+	}
+
+	void Scheduler::setCostSource(int cost_source)
+	{
+		this->cost_source = cost_source;
+	}
+
+	void Scheduler::setCosts(std::vector<float>& costs)
+	{
+		given_costs = costs;
+		cost_source = COST_GIVEN;
+	}
+
+	void Scheduler::setNumaAware(bool numa_aware)
+	{
+		this->numa_aware = numa_aware;
+	}
+
+	void Scheduler::setNumaExtent(float numa_extent)
+	{
+		this->numa_extent = numa_extent;
+	}
+
+	int Scheduler::getChunkSize() const
+	{
+		return chunk_size;
+	}
+
+	int Scheduler::getCostSource() const
+	{
+		return cost_source;
+	}
+
+	SchedulerReport Scheduler::getReport() const
+	{
+		std::lock_guard<std::mutex> lock(report_mutex);
+		return report;
+	}
+
+	void Scheduler::givenPrefix(long long task_number, std::vector<double>& cost_prefix) const
+	{
+		//the given costs are ignored if they do not match the batch
+		if (cost_source != COST_GIVEN || (long long)given_costs.size() != task_number)
+		{
+			return;
+		}
+
+		cost_prefix.resize(task_number + 1);
+		cost_prefix[0] = 0;
+		for (long long i = 0; i < task_number; i++)
+		{
+			cost_prefix[i + 1] = cost_prefix[i] + std::max(given_costs[i], 0.f);
+		}
+	}
+
+	void Scheduler::execute(long long task_number, std::vector<double>& cost_prefix, const std::vector<float>& positions,
+		std::function<void(long long)>& task)
+	{
+		//an empty prefix denotes uniform cost, so does a batch without any cost
+		bool uniform = cost_prefix.empty() || cost_prefix[task_number] <= 0;
+		auto weight = [&](long long begin, long long end)
+		{
+			return uniform ? (double)(end - begin) : cost_prefix[end] - cost_prefix[begin];
+		};
+
+		//the first position in [begin, end] where the weight from begin reaches target
+		auto locate = [&](long long begin, long long end, double target)
+		{
+			if (uniform)
+			{
+				return std::min(end, begin + (long long)std::ceil(target));
+			}
+			return std::min(end, (long long)(std::lower_bound(cost_prefix.begin() + begin, cost_prefix.begin() + end + 1,
+				cost_prefix[begin] + target) - cost_prefix.begin()));
+		};
+
+		int thread_number = 1;
+		NumaTeam team;
+		std::vector<int> thread_band, thread_rank, band_threads;
+		std::vector<long long> order; //tasks grouped by NUMA band, empty if the batch is not partitioned among nodes
+		std::unique_ptr<SchedulerRange[]> ranges;
+		double chunk_weight = 1;
+
+		SchedulerReport batch_report;
+		batch_report.task_number = task_number;
+
+		double start_time = omp_get_wtime();
+#pragma omp parallel
+		{
+			mapNumaTeam(team);
+
+#pragma omp single
+			{
+				thread_number = omp_get_num_threads();
+				ranges.reset(new SchedulerRange[thread_number]);
+
+				//threads on the same node share a band of the batch if the team spans more than one node
+				int band_number = 1;
+				thread_band.assign(thread_number, 0);
+				thread_rank.resize(thread_number);
+				for (int i = 0; i < thread_number; i++)
+				{
+					thread_rank[i] = i;
+				}
+				band_threads.assign(1, thread_number);
+				std::vector<long long> band_begin(2, 0);
+				band_begin[1] = task_number;
+
+				if (!positions.empty() && team.band_number > 1)
+				{
+					band_number = team.band_number;
+					thread_band = team.thread_band;
+					thread_rank = team.thread_rank;
+					band_threads = team.band_threads;
+
+					float extent = numa_extent;
+					if (extent <= 0)
+					{
+						extent = *std::max_element(positions.begin(), positions.end()) + 1;
+					}
+
+					//group the tasks by band, keeping their order within each band
+					std::vector<int> task_band(task_number);
+					band_begin.assign(band_number + 1, 0);
+					for (long long i = 0; i < task_number; i++)
+					{
+						int band = (int)(positions[i] * band_number / extent);
+						task_band[i] = std::max(0, std::min(band, band_number - 1));
+						band_begin[task_band[i] + 1]++;
+					}
+					for (int i = 0; i < band_number; i++)
+					{
+						band_begin[i + 1] += band_begin[i];
+					}
+
+					order.resize(task_number);
+					std::vector<long long> band_next(band_begin.begin(), band_begin.end() - 1);
+					for (long long i = 0; i < task_number; i++)
+					{
+						order[band_next[task_band[i]]++] = i;
+					}
+
+					if (!uniform)
+					{
+						std::vector<double> ordered_prefix(task_number + 1);
+						ordered_prefix[0] = 0;
+						for (long long i = 0; i < task_number; i++)
+						{
+							ordered_prefix[i + 1] = ordered_prefix[i] + cost_prefix[order[i] + 1] - cost_prefix[order[i]];
+						}
+						cost_prefix.swap(ordered_prefix);
+					}
+				}
+
+				//contiguous ranges of equal estimated cost in each band
+				for (int i = 0; i < thread_number; i++)
+				{
+					int band = thread_band[i];
+					long long begin = band_begin[band];
+					long long end = band_begin[band + 1];
+					double band_weight = weight(begin, end);
+					long long range_begin = thread_rank[i] == 0 ? begin : locate(begin, end, band_weight * thread_rank[i] / band_threads[band]);
+					long long range_end = thread_rank[i] == band_threads[band] - 1 ? end
+						: locate(begin, end, band_weight * (thread_rank[i] + 1) / band_threads[band]);
+					ranges[i].begin = range_begin;
+					ranges[i].end = std::max(range_begin, range_end);
+				}
+
+				//small chunks keep most of the tasks available for stealing
+				long long chunk_tasks = chunk_size;
+				if (chunk_tasks == 0)
+				{
+					chunk_tasks = std::max(1LL, std::min(64LL, task_number / ((long long)thread_number * 64)));
+				}
+				chunk_weight = chunk_tasks * weight(0, task_number) / std::max(task_number, 1LL);
+
+				batch_report.thread_number = thread_number;
+				batch_report.band_number = band_number;
+				batch_report.busy_time.assign(thread_number, 0);
+				batch_report.thread_tasks.assign(thread_number, 0);
+				batch_report.thread_steals.assign(thread_number, 0);
+			}
+
+			int thread_index = omp_get_thread_num();
+			SchedulerRange& own_range = ranges[thread_index];
+			double busy_time = 0;
+			long long thread_tasks = 0;
+			long long thread_steals = 0;
+
+			while (true)
+			{
+				//take a chunk from the head of own range
+				long long chunk_begin = 0, chunk_end = 0;
+				{
+					std::lock_guard<std::mutex> lock(own_range.range_mutex);
+					chunk_begin = own_range.begin;
+					long long range_end = own_range.end;
+					if (chunk_begin < range_end)
+					{
+						chunk_end = std::max(locate(chunk_begin, range_end, chunk_weight), chunk_begin + 1);
+						own_range.begin = chunk_end;
+					}
+				}
+
+				if (chunk_begin < chunk_end)
+				{
+					double chunk_start = omp_get_wtime();
+					for (long long i = chunk_begin; i < chunk_end; i++)
+					{
+						task(order.empty() ? i : order[i]);
+					}
+					busy_time += omp_get_wtime() - chunk_start;
+					thread_tasks += chunk_end - chunk_begin;
+					continue;
+				}
+
+				//steal the back half of the most loaded range, the threads on the same node are preferred
+				bool stolen = false;
+				while (!stolen)
+				{
+					int victim = -1;
+					double victim_weight = 0;
+					for (int pass = 0; pass < 2 && victim < 0; pass++)
+					{
+						for (int i = 0; i < thread_number; i++)
+						{
+							long long range_begin = ranges[i].begin;
+							long long range_end = ranges[i].end;
+							if (i != thread_index && (pass == 1 || thread_band[i] == thread_band[thread_index])
+								&& range_begin < range_end && weight(range_begin, range_end) >= victim_weight)
+							{
+								victim = i;
+								victim_weight = weight(range_begin, range_end);
+							}
+						}
+					}
+					if (victim < 0)
+					{
+						break;
+					}
+
+					long long steal_begin = 0, steal_end = 0;
+					{
+						std::lock_guard<std::mutex> lock(ranges[victim].range_mutex);
+						long long range_begin = ranges[victim].begin;
+						long long range_end = ranges[victim].end;
+						if (range_begin < range_end)
+						{
+							steal_begin = locate(range_begin, range_end, weight(range_begin, range_end) / 2);
+							steal_begin = std::min(steal_begin, range_end - 1);
+							steal_end = range_end;
+							ranges[victim].end = steal_begin;
+							stolen = true;
+						}
+					}
+
+					if (stolen)
+					{
+						std::lock_guard<std::mutex> lock(own_range.range_mutex);
+						own_range.begin = steal_begin;
+						own_range.end = steal_end;
+						thread_steals++;
+					}
+				}
+
+				if (!stolen)
+				{
+					break;
+				}
+			}
+
+			batch_report.busy_time[thread_index] = busy_time;
+			batch_report.thread_tasks[thread_index] = thread_tasks;
+			batch_report.thread_steals[thread_index] = thread_steals;
+		}
+		batch_report.wall_time = omp_get_wtime() - start_time;
+
+		std::lock_guard<std::mutex> lock(report_mutex);
+		report = batch_report;
+	}
+
+	void Scheduler::run(long long task_number, std::function<void(long long)> task)
+	{
+		std::vector<double> cost_prefix;
+		givenPrefix(task_number, cost_prefix);
+		execute(task_number, cost_prefix, std::vector<float>(), task);
+	}
+
+	void Scheduler::run(std::vector<POI2D>& poi_queue, std::function<void(POI2D*)> task)
+	{
+		long long queue_length = (long long)poi_queue.size();
+		std::vector<double> cost_prefix;
+		if (cost_source == COST_ITERATION)
+		{
+			iterationPrefix(poi_queue, cost_prefix);
+		}
+		else
+		{
+			givenPrefix(queue_length, cost_prefix);
+		}
+
+		//the POIs are divided among NUMA nodes along the same axis as the first touch in preparation
+		std::vector<float> positions;
+		if (numa_aware && getNumaNodeNumber() > 1)
+		{
+			positions.resize(queue_length);
+			for (long long i = 0; i < queue_length; i++)
+			{
+				positions[i] = poi_queue[i].x;
+			}
+		}
+
+		std::function<void(long long)> poi_task = [&](long long i) { task(&poi_queue[i]); };
+		execute(queue_length, cost_prefix, positions, poi_task);
+	}
+
+	void Scheduler::run(std::vector<POI2DS>& poi_queue, std::function<void(POI2DS*)> task)
+	{
+		long long queue_length = (long long)poi_queue.size();
+		std::vector<double> cost_prefix;
+		givenPrefix(queue_length, cost_prefix);
+
+		//the POIs are divided among NUMA nodes along the same axis as the first touch in preparation
+		std::vector<float> positions;
+		if (numa_aware && getNumaNodeNumber() > 1)
+		{
+			positions.resize(queue_length);
+			for (long long i = 0; i < queue_length; i++)
+			{
+				positions[i] = poi_queue[i].x;
+			}
+		}
+
+		std::function<void(long long)> poi_task = [&](long long i) { task(&poi_queue[i]); };
+		execute(queue_length, cost_prefix, positions, poi_task);
+	}
+
+	void Scheduler::run(std::vector<POI3D>& poi_queue, std::function<void(POI3D*)> task)
+	{
+		long long queue_length = (long long)poi_queue.size();
+		std::vector<double> cost_prefix;
+		if (cost_source == COST_ITERATION)
+		{
+			iterationPrefix(poi_queue, cost_prefix);
+		}
+		else
+		{
+			givenPrefix(queue_length, cost_prefix);
+		}
+
+		//the POIs are divided among NUMA nodes along the same axis as the first touch in preparation
+		std::vector<float> positions;
+		if (numa_aware && getNumaNodeNumber() > 1)
+		{
+			positions.resize(queue_length);
+			for (long long i = 0; i < queue_length; i++)
+			{
+				positions[i] = poi_queue[i].z;
+			}
+		}
+
+		std::function<void(long long)> poi_task = [&](long long i) { task(&poi_queue[i]); };
+		execute(queue_length, cost_prefix, positions, poi_task);
+	}
+
+}//namespace opencorr
@@ -0,0 +1,97 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "oc_poi.h"
+
+namespace opencorr
+{
+	//source of the estimated cost of each POI
+	enum SchedulerCost
+	{
+		COST_UNIFORM, //all the POIs are regarded as equally expensive
+		COST_ITERATION, //iteration number in the results of POIs, e.g. those of last frame kept as initial guess
+		COST_GIVEN //costs set through setCosts()
+	};
+
+	//statistics of the last batch
+	struct SchedulerReport
+	{
+		int thread_number = 0;
+		int band_number = 0; //NUMA nodes the batch is divided among, 1 if not divided
+		long long task_number = 0;
+		double wall_time = 0; //in seconds
+		std::vector<double> busy_time; //time spent on tasks by each thread, in seconds
+		std::vector<long long> thread_tasks; //number of tasks completed by each thread
+		std::vector<long long> thread_steals; //number of ranges stolen by each thread, from the threads on the same node first
+
+		double getUtilization(int thread_index) const; //busy time over wall time
+		double getMeanUtilization() const;
+	};
+
+	//dynamic distribution of a batch of POIs among OpenMP threads. The batch is divided into contiguous ranges of
+	//equal estimated cost, one for each thread, thus neighboring POIs are processed by the same thread. A thread
+	//takes small chunks from the head of its own range, and steals the back half of the most loaded range of other
+	//threads once its own range is exhausted. If the threads run on several NUMA nodes, the POIs are first divided
+	//into bands along x in 2D or z in 3D, one for each node, matching the first touch of gradients and interpolation
+	//coefficients in preparation (see numaFor()), and the threads on the same node are preferred in stealing
+	class Scheduler
+	{
+	private:
+		int chunk_size; //number of tasks taken at a time, 0 for automatic
+		int cost_source;
+		std::vector<float> given_costs;
+		bool numa_aware;
+		float numa_extent; //length of image along the axis divided among NUMA nodes, 0 for the extent of POIs
+
+		mutable std::mutex report_mutex;
+		SchedulerReport report;
+
+		void givenPrefix(long long task_number, std::vector<double>& cost_prefix) const;
+		//the prefix of costs is reordered together with the tasks if they are divided among NUMA nodes
+		void execute(long long task_number, std::vector<double>& cost_prefix, const std::vector<float>& positions,
+			std::function<void(long long)>& task);
+
+	public:
+		Scheduler();
+		~Scheduler() = default;
+
+		void setChunkSize(int chunk_size); //0 (default) sets the chunk automatically according to the batch
+		void setCostSource(int cost_source); //COST_UNIFORM by default
+		void setCosts(std::vector<float>& costs); //estimated costs of the tasks in next batches, switches to COST_GIVEN
+		void setNumaAware(bool numa_aware); //true (default) divides the POIs among NUMA nodes if the team spans several
+		void setNumaExtent(float numa_extent); //width of image in 2D or dim_z in 3D, set by setImages() of DIC and DVC
+
+		int getChunkSize() const;
+		int getCostSource() const;
+		SchedulerReport getReport() const;
+
+		//the iterations of POIs are read before any task starts, POI2DS uses the given costs only
+		void run(long long task_number, std::function<void(long long)> task);
+		void run(std::vector<POI2D>& poi_queue, std::function<void(POI2D*)> task);
+		void run(std::vector<POI2DS>& poi_queue, std::function<void(POI2DS*)> task);
+		void run(std::vector<POI3D>& poi_queue, std::function<void(POI3D*)> task);
+	};
+
+}//namespace opencorr
+
+#endif //_SCHEDULER_H_
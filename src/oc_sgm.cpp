@@ -0,0 +1,402 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "oc_sgm.h"
+
+namespace opencorr
+{
+	//Hamming distance between two census codes
+	inline uint16_t hammingDistance(uint64_t code1, uint64_t code2)
+	{
+#ifdef _MSC_VER
+		return (uint16_t)__popcnt64(code1 ^ code2);
+#else
+		return (uint16_t)__builtin_popcountll(code1 ^ code2);
+#endif
+	}
+
+	SGM::SGM(int census_radius_x, int census_radius_y, int min_disparity, int max_disparity, int thread_number)
+	{
+		if ((2 * census_radius_x + 1) * (2 * census_radius_y + 1) - 1 > 64)
+		{
+			throw std::string("Census window over 64 bits");
+		}
+
+		subset_radius_x = census_radius_x;
+		subset_radius_y = census_radius_y;
+		this->thread_number = thread_number;
+
+		setDisparity(min_disparity, max_disparity);
+		penalty1 = 8;
+		penalty2 = 96;
+		consistency_tolerance = 1;
+		memory_limit = (size_t)2 << 30;
+	}
+
+	SGM::~SGM() {}
+
+	void SGM::setDisparity(int min_disparity, int max_disparity)
+	{
+		if (max_disparity < min_disparity)
+		{
+			throw std::string("Maximum disparity smaller than minimum disparity");
+		}
+
+		this->min_disparity = min_disparity;
+		this->max_disparity = max_disparity;
+		disparity_number = max_disparity - min_disparity + 1;
+	}
+
+	void SGM::setPenalty(int penalty1, int penalty2)
+	{
+		//the aggregated costs of 8 paths are stored in 16-bit integers
+		if (penalty1 < 0 || penalty2 < penalty1 || 8 * (64 + penalty2) > 65535)
+		{
+			throw std::string("Invalid penalties");
+		}
+
+		this->penalty1 = penalty1;
+		this->penalty2 = penalty2;
+	}
+
+	void SGM::setConsistency(int consistency_tolerance)
+	{
+		this->consistency_tolerance = consistency_tolerance;
+	}
+
+	void SGM::setMemoryLimit(size_t memory_limit)
+	{
+		this->memory_limit = memory_limit;
+	}
+
+	void SGM::setRectification(Stereorectification* rectification)
+	{
+		this->rectification = rectification;
+	}
+
+	void SGM::census(Image2D* image, std::vector<uint64_t>& census_map)
+	{
+		int height = image->height;
+		int width = image->width;
+		census_map.assign((size_t)height * width, 0);
+
+		//neighbors out of image are clamped to the boundary
+#pragma omp parallel for
+		for (int r = 0; r < height; r++)
+		{
+			for (int c = 0; c < width; c++)
+			{
+				float center = image->eg_mat(r, c);
+				uint64_t code = 0;
+				for (int j = -subset_radius_y; j <= subset_radius_y; j++)
+				{
+					int y = std::min(std::max(r + j, 0), height - 1);
+					for (int i = -subset_radius_x; i <= subset_radius_x; i++)
+					{
+						if (i == 0 && j == 0)
+						{
+							continue;
+						}
+						int x = std::min(std::max(c + i, 0), width - 1);
+						code = (code << 1) | (image->eg_mat(y, x) < center ? 1 : 0);
+					}
+				}
+				census_map[(size_t)r * width + c] = code;
+			}
+		}
+	}
+
+	void SGM::matchRow(int y, uint16_t* cost_row)
+	{
+		int width = ref_img->width;
+		uint16_t max_cost = (uint16_t)((2 * subset_radius_x + 1) * (2 * subset_radius_y + 1) - 1);
+		const uint64_t* ref_row = &ref_census[(size_t)y * width];
+		const uint64_t* tar_row = &tar_census[(size_t)y * width];
+
+		for (int x = 0; x < width; x++)
+		{
+			uint16_t* cost = cost_row + (size_t)x * disparity_number;
+			for (int k = 0; k < disparity_number; k++)
+			{
+				int x_tar = x + min_disparity + k;
+				cost[k] = (x_tar >= 0 && x_tar < width) ? hammingDistance(ref_row[x], tar_row[x_tar]) : max_cost;
+			}
+		}
+	}
+
+	void SGM::updatePath(const uint16_t* cost, const uint16_t* previous, uint16_t* current, uint16_t* aggregated)
+	{
+		//the path starts at the boundary of image
+		if (previous == nullptr)
+		{
+			for (int k = 0; k < disparity_number; k++)
+			{
+				current[k] = cost[k];
+				aggregated[k] += cost[k];
+			}
+			return;
+		}
+
+		uint16_t previous_min = *std::min_element(previous, previous + disparity_number);
+		uint16_t jump_cost = (uint16_t)(previous_min + penalty2);
+		for (int k = 0; k < disparity_number; k++)
+		{
+			uint16_t path_cost = std::min(previous[k], jump_cost);
+			if (k > 0)
+			{
+				path_cost = std::min(path_cost, (uint16_t)(previous[k - 1] + penalty1));
+			}
+			if (k < disparity_number - 1)
+			{
+				path_cost = std::min(path_cost, (uint16_t)(previous[k + 1] + penalty1));
+			}
+			current[k] = (uint16_t)(cost[k] + path_cost - previous_min);
+			aggregated[k] += current[k];
+		}
+	}
+
+	void SGM::aggregateHorizontal()
+	{
+		int height = ref_img->height;
+		int width = ref_img->width;
+
+		//rows are independent in the horizontal paths
+#pragma omp parallel
+		{
+			std::vector<uint16_t> cost_row((size_t)width * disparity_number);
+			std::vector<uint16_t> path_buffer(2 * (size_t)disparity_number);
+			uint16_t* previous = path_buffer.data();
+			uint16_t* current = previous + disparity_number;
+
+#pragma omp for
+			for (int y = 0; y < height; y++)
+			{
+				matchRow(y, cost_row.data());
+				uint16_t* aggregated_row = &aggregated_cost[(size_t)y * width * disparity_number];
+
+				//from left to right
+				for (int x = 0; x < width; x++)
+				{
+					size_t offset = (size_t)x * disparity_number;
+					updatePath(&cost_row[offset], x > 0 ? previous : nullptr, current, aggregated_row + offset);
+					std::swap(previous, current);
+				}
+
+				//from right to left
+				for (int x = width - 1; x >= 0; x--)
+				{
+					size_t offset = (size_t)x * disparity_number;
+					updatePath(&cost_row[offset], x < width - 1 ? previous : nullptr, current, aggregated_row + offset);
+					std::swap(previous, current);
+				}
+			}
+		}
+	}
+
+	void SGM::aggregateVertical(bool downward)
+	{
+		int height = ref_img->height;
+		int width = ref_img->width;
+		size_t row_size = (size_t)width * disparity_number;
+
+		//the path buffers keep only two rows for each of the three paths, instead of a full cost volume
+		std::vector<uint16_t> cost_row(row_size);
+		std::vector<uint16_t> path_buffer(6 * row_size);
+		uint16_t* previous[3] = { &path_buffer[0], &path_buffer[row_size], &path_buffer[2 * row_size] };
+		uint16_t* current[3] = { &path_buffer[3 * row_size], &path_buffer[4 * row_size], &path_buffer[5 * row_size] };
+
+		int y_step = downward ? 1 : -1;
+		for (int i = 0; i < height; i++)
+		{
+			int y = downward ? i : height - 1 - i;
+			matchRow(y, cost_row.data());
+			uint16_t* aggregated_row = &aggregated_cost[(size_t)y * row_size];
+
+			//points in a row depend only on the previous row
+#pragma omp parallel for
+			for (int x = 0; x < width; x++)
+			{
+				size_t offset = (size_t)x * disparity_number;
+
+				//the three paths come from (x - y_step, y - y_step), (x, y - y_step), and (x + y_step, y - y_step)
+				for (int p = 0; p < 3; p++)
+				{
+					int x_previous = x + (p - 1) * y_step;
+					bool inside = i > 0 && x_previous >= 0 && x_previous < width;
+					const uint16_t* previous_path = inside ? previous[p] + (size_t)x_previous * disparity_number : nullptr;
+					updatePath(&cost_row[offset], previous_path, current[p] + offset, aggregated_row + offset);
+				}
+			}
+
+			for (int p = 0; p < 3; p++)
+			{
+				std::swap(previous[p], current[p]);
+			}
+		}
+	}
+
+	void SGM::selectDisparity()
+	{
+		int height = ref_img->height;
+		int width = ref_img->width;
+		int invalid_disparity = min_disparity - 1;
+
+		integer_disparity.resize(height, width);
+		subpixel_disparity.resize(height, width);
+
+#pragma omp parallel
+		{
+			std::vector<int> view2_disparity(width);
+			std::vector<uint16_t> view2_min_cost(width);
+
+#pragma omp for
+			for (int y = 0; y < height; y++)
+			{
+				const uint16_t* aggregated_row = &aggregated_cost[(size_t)y * width * disparity_number];
+
+				//disparities of view2 derived from the same cost volume for the left-right consistency check
+				if (consistency_tolerance >= 0)
+				{
+					std::fill(view2_disparity.begin(), view2_disparity.end(), invalid_disparity);
+					std::fill(view2_min_cost.begin(), view2_min_cost.end(), (uint16_t)65535);
+					for (int x = 0; x < width; x++)
+					{
+						const uint16_t* aggregated = aggregated_row + (size_t)x * disparity_number;
+						for (int k = 0; k < disparity_number; k++)
+						{
+							int x_tar = x + min_disparity + k;
+							if (x_tar >= 0 && x_tar < width && aggregated[k] < view2_min_cost[x_tar])
+							{
+								view2_min_cost[x_tar] = aggregated[k];
+								view2_disparity[x_tar] = min_disparity + k;
+							}
+						}
+					}
+				}
+
+				for (int x = 0; x < width; x++)
+				{
+					const uint16_t* aggregated = aggregated_row + (size_t)x * disparity_number;
+
+					//winner takes all among the disparities pointing into view2
+					int k_best = -1;
+					for (int k = 0; k < disparity_number; k++)
+					{
+						int x_tar = x + min_disparity + k;
+						if (x_tar >= 0 && x_tar < width && (k_best < 0 || aggregated[k] < aggregated[k_best]))
+						{
+							k_best = k;
+						}
+					}
+
+					int disparity = k_best < 0 ? invalid_disparity : min_disparity + k_best;
+					if (k_best >= 0 && consistency_tolerance >= 0
+						&& abs(view2_disparity[x + disparity] - disparity) > consistency_tolerance)
+					{
+						k_best = -1;
+						disparity = invalid_disparity;
+					}
+
+					integer_disparity(y, x) = disparity;
+					if (k_best < 0)
+					{
+						subpixel_disparity(y, x) = std::numeric_limits<float>::quiet_NaN();
+						continue;
+					}
+
+					//sub-pixel disparity through parabola fitting
+					float offset = 0.f;
+					if (k_best > 0 && k_best < disparity_number - 1)
+					{
+						float cost_left = aggregated[k_best - 1];
+						float cost_center = aggregated[k_best];
+						float cost_right = aggregated[k_best + 1];
+						float denominator = cost_left - 2 * cost_center + cost_right;
+						if (denominator > 0)
+						{
+							offset = 0.5f * (cost_left - cost_right) / denominator;
+						}
+					}
+					subpixel_disparity(y, x) = disparity + offset;
+				}
+			}
+		}
+	}
+
+	void SGM::prepare()
+	{
+		if (ref_img->height != tar_img->height || ref_img->width != tar_img->width)
+		{
+			throw std::string("Rectified images differ in dimensions");
+		}
+
+		//the aggregated cost volume holds all the pixels and disparities
+		size_t volume_size = (size_t)ref_img->height * ref_img->width * disparity_number;
+		if (volume_size > memory_limit / sizeof(uint16_t))
+		{
+			throw std::string("Aggregated cost volume exceeds the memory limit");
+		}
+
+		census(ref_img, ref_census);
+		census(tar_img, tar_census);
+
+		aggregated_cost.assign(volume_size, 0);
+		aggregateHorizontal();
+		aggregateVertical(true);
+		aggregateVertical(false);
+
+		selectDisparity();
+	}
+
+	void SGM::compute(POI2D* poi)
+	{
+		//location of POI in rectified view1
+		Point2D ref_point = (Point2D)*poi;
+		if (rectification != nullptr)
+		{
+			ref_point = rectification->view1ToRectified(ref_point);
+		}
+
+		int x = (int)floor(ref_point.x + 0.5f);
+		int y = (int)floor(ref_point.y + 0.5f);
+		if (x < 0 || y < 0 || x >= subpixel_disparity.cols() || y >= subpixel_disparity.rows()
+			|| std::isnan(subpixel_disparity(y, x)))
+		{
+			poi->result.zncc = -1;
+			return;
+		}
+
+		//counterpart in rectified view2, then in original view2 if the rectification is given
+		Point2D tar_point(ref_point.x + subpixel_disparity(y, x), ref_point.y);
+		if (rectification != nullptr)
+		{
+			tar_point = rectification->rectifiedToView2(tar_point);
+		}
+
+		poi->deformation.u = tar_point.x - poi->x;
+		poi->deformation.v = tar_point.y - poi->y;
+	}
+
+	void SGM::compute(std::vector<POI2D>& poi_queue)
+	{
+		scheduler.run(poi_queue, [this](POI2D* poi) { compute(poi); });
+	}
+
+}//namespace opencorr
\ No newline at end of file
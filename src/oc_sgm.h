@@ -0,0 +1,75 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _SGM_H_
+#define _SGM_H_
+
+#include <cstdint>
+
+#include "oc_array.h"
+#include "oc_dic.h"
+#include "oc_image.h"
+#include "oc_poi.h"
+#include "oc_point.h"
+#include "oc_stereorectification.h"
+
+namespace opencorr
+{
+	//this module is the implementation of
+	//H. Hirschmuller, IEEE Transactions on Pattern Analysis and Machine Intelligence (2008) 30(2): 328-341.
+	//https://doi.org/10.1109/TPAMI.2007.1166
+
+	class SGM : public DIC
+	{
+	protected:
+		int min_disparity, max_disparity; //range of disparity, the counterpart of (x, y) in view2 is (x + disparity, y)
+		int disparity_number; //number of integral disparities in the range
+		int penalty1, penalty2; //penalties for the change of disparity by one pixel and by more pixels
+		int consistency_tolerance; //tolerance of left-right consistency check, negative value disables the check
+		size_t memory_limit; //upper limit of the aggregated cost volume in bytes
+		Stereorectification* rectification = nullptr; //optional, converts the seeds into the coordinates of original views
+
+		std::vector<uint64_t> ref_census, tar_census; //census transform of the two rectified images
+		std::vector<uint16_t> aggregated_cost; //aggregated cost volume, rows of image, then columns, then disparities
+
+		void census(Image2D* image, std::vector<uint64_t>& census_map);
+		void matchRow(int y, uint16_t* cost_row); //matching costs of all pixels and disparities in a row
+		void updatePath(const uint16_t* cost, const uint16_t* previous, uint16_t* current, uint16_t* aggregated);
+		void aggregateHorizontal();
+		void aggregateVertical(bool downward); //vertical and diagonal paths, swept row by row
+		void selectDisparity();
+
+	public:
+		Eigen::MatrixXi integer_disparity; //integral disparity map, invalid points are set as min_disparity - 1
+		Eigen::MatrixXf subpixel_disparity; //sub-pixel disparity map, invalid points are set as NaN
+
+		SGM(int census_radius_x, int census_radius_y, int min_disparity, int max_disparity, int thread_number);
+		~SGM();
+
+		void setDisparity(int min_disparity, int max_disparity);
+		void setPenalty(int penalty1, int penalty2);
+		void setConsistency(int consistency_tolerance);
+		void setMemoryLimit(size_t memory_limit); //prepare() throws if the cost volume would exceed it
+		void setRectification(Stereorectification* rectification);
+
+		void prepare(); //census transform, cost aggregation and disparity selection over the rectified images
+		void compute(POI2D* poi); //set the deformation of POI as the seed of ICGN
+		void compute(std::vector<POI2D>& poi_queue);
+	};
+
+}//namespace opencorr
+
+#endif //_SGM_H_
\ No newline at end of file
@@ -0,0 +1,497 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <omp.h>
+
+#include "oc_stereo_stream.h"
+
+namespace opencorr
+{
+	StreamFrame::StreamFrame(int width, int height)
+		: view1_img(width, height), view2_img(width, height)
+	{
+		index = -1;
+		dropped = false;
+		dropped_pois = 0;
+		slot = -1;
+		ingest_time = 0.;
+		prepare_time = 0.;
+		match_time = 0.;
+		output_time = 0.;
+	}
+
+	StereoStream::StereoStream(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition,
+		int prepare_threads, int match_threads, int output_threads, int frame_number)
+	{
+		this->subset_radius_x = subset_radius_x;
+		this->subset_radius_y = subset_radius_y;
+		this->prepare_threads = prepare_threads;
+		this->match_threads = match_threads;
+		this->output_threads = output_threads;
+		this->frame_number = frame_number < 2 ? 2 : frame_number;
+		latency_budget = 0.;
+		zncc_threshold = 0.8f;
+		running = false;
+
+		for (int i = 0; i < 2; i++)
+		{
+			view1_icgn[i] = new ICGN2D1(subset_radius_x, subset_radius_y, conv_criterion, stop_condition, match_threads);
+			view2_icgn[i] = new ICGN2D1(subset_radius_x, subset_radius_y, conv_criterion, stop_condition, match_threads);
+		}
+
+		ingest_closed = false;
+		prepare_closed = false;
+		match_closed = false;
+		pushed_frames = 0;
+		ingest_dropped = 0;
+		stage_dropped = 0;
+		dropped_pois = 0;
+		first_ingest_time = 0.;
+		last_output_time = 0.;
+	}
+
+	StereoStream::~StereoStream()
+	{
+		if (running)
+		{
+			finish();
+		}
+
+		for (int i = 0; i < 2; i++)
+		{
+			delete view1_icgn[i];
+			delete view2_icgn[i];
+		}
+		releaseFrames();
+		delete ref_img;
+	}
+
+	void StereoStream::releaseFrames()
+	{
+		for (auto& frame : frame_pool)
+		{
+			delete frame;
+		}
+		frame_pool.clear();
+
+		delete free_queue;
+		delete ingest_queue;
+		delete prepared_queue;
+		delete matched_queue;
+		delete slot_queue;
+		free_queue = nullptr;
+		ingest_queue = nullptr;
+		prepared_queue = nullptr;
+		matched_queue = nullptr;
+		slot_queue = nullptr;
+	}
+
+	void StereoStream::setLatencyBudget(double latency_budget)
+	{
+		this->latency_budget = latency_budget;
+	}
+
+	void StereoStream::setTracking(float zncc_threshold)
+	{
+		this->zncc_threshold = zncc_threshold;
+	}
+
+	void StereoStream::setStereovision(Stereovision* stereovision)
+	{
+		this->stereovision = stereovision;
+	}
+
+	void StereoStream::setOutput(std::function<void(StreamFrame&)> output)
+	{
+		this->output = output;
+	}
+
+	void StereoStream::setReference(Image2D& ref_img, std::vector<POI2D>& view1_queue, std::vector<POI2D>& view2_queue)
+	{
+		if (running)
+		{
+			throw std::string("Reference cannot be changed while the stream is running");
+		}
+		if (view1_queue.size() != view2_queue.size())
+		{
+			throw std::string("Mismatched length of POI queues of the two views");
+		}
+
+		delete this->ref_img;
+		this->ref_img = new Image2D(ref_img.width, ref_img.height);
+		this->ref_img->eg_mat = ref_img.eg_mat;
+		view1_state = view1_queue;
+		view2_state = view2_queue;
+
+		//gradient maps of ref image are calculated only once for all frames
+		for (int i = 0; i < 2; i++)
+		{
+			view1_icgn[i]->setImages(*this->ref_img, *this->ref_img);
+			view1_icgn[i]->prepareRef();
+			view2_icgn[i]->setImages(*this->ref_img, *this->ref_img);
+			view2_icgn[i]->prepareRef();
+		}
+
+		//frames are allocated once and recycled through the queues
+		releaseFrames();
+		free_queue = new SPSCQueue<StreamFrame*>(frame_number);
+		ingest_queue = new SPSCQueue<StreamFrame*>(frame_number);
+		prepared_queue = new SPSCQueue<StreamFrame*>(frame_number);
+		matched_queue = new SPSCQueue<StreamFrame*>(frame_number);
+		slot_queue = new SPSCQueue<int>(2);
+		for (int i = 0; i < frame_number; i++)
+		{
+			StreamFrame* frame = new StreamFrame(ref_img.width, ref_img.height);
+			frame_pool.push_back(frame);
+			free_queue->push(frame);
+		}
+		slot_queue->push(0);
+		slot_queue->push(1);
+	}
+
+	void StereoStream::start()
+	{
+		if (ref_img == nullptr)
+		{
+			throw std::string("Reference is not set");
+		}
+		if (running)
+		{
+			return;
+		}
+
+		pushed_frames = 0;
+		ingest_dropped = 0;
+		stage_dropped = 0;
+		dropped_pois = 0;
+		first_ingest_time = 0.;
+		last_output_time = 0.;
+		latency_record.clear();
+
+		ingest_closed = false;
+		prepare_closed = false;
+		match_closed = false;
+		running = true;
+
+		prepare_thread = std::thread(&StereoStream::prepareStage, this);
+		match_thread = std::thread(&StereoStream::matchStage, this);
+		output_thread = std::thread(&StereoStream::outputStage, this);
+	}
+
+	bool StereoStream::push(Image2D& view1_img, Image2D& view2_img)
+	{
+		if (!running)
+		{
+			throw std::string("Stream is not started");
+		}
+		if (view1_img.width != ref_img->width || view1_img.height != ref_img->height
+			|| view2_img.width != ref_img->width || view2_img.height != ref_img->height)
+		{
+			throw std::string("Image dimensions differ from the reference");
+		}
+
+		double ingest_time = omp_get_wtime();
+		if (pushed_frames == 0)
+		{
+			first_ingest_time = ingest_time;
+		}
+		pushed_frames++;
+
+		//drop the frame instead of waiting if all frames are in flight
+		StreamFrame* frame = nullptr;
+		if (!free_queue->pop(frame))
+		{
+			ingest_dropped++;
+			return false;
+		}
+
+		frame->index = pushed_frames - 1;
+		frame->dropped = false;
+		frame->dropped_pois = 0;
+		frame->slot = -1;
+		frame->ingest_time = ingest_time;
+		frame->view1_img.eg_mat = view1_img.eg_mat;
+		frame->view2_img.eg_mat = view2_img.eg_mat;
+
+		ingest_queue->push(frame);
+		return true;
+	}
+
+	void StereoStream::finish()
+	{
+		if (!running)
+		{
+			return;
+		}
+
+		ingest_closed = true;
+		prepare_thread.join();
+		match_thread.join();
+		output_thread.join();
+		running = false;
+	}
+
+	void StereoStream::idle(int& idle_count)
+	{
+		//spin shortly for low latency, then sleep to leave the cores to busy stages
+		if (idle_count < 64)
+		{
+			idle_count++;
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+	void StereoStream::prepareStage()
+	{
+		omp_set_num_threads(prepare_threads);
+
+		StreamFrame* frame = nullptr;
+		int idle_count = 0;
+		while (true)
+		{
+			bool closed = ingest_closed.load();
+			if (!ingest_queue->pop(frame))
+			{
+				if (closed)
+				{
+					break;
+				}
+				idle(idle_count);
+				continue;
+			}
+			idle_count = 0;
+
+			//skip the preparation of frames already out of budget or superseded by a newer frame
+			if (latency_budget > 0 && (omp_get_wtime() - frame->ingest_time > latency_budget || !ingest_queue->empty()))
+			{
+				frame->dropped = true;
+			}
+			else
+			{
+				int slot = -1;
+				int slot_idle_count = 0;
+				while (!slot_queue->pop(slot))
+				{
+					idle(slot_idle_count);
+				}
+				frame->slot = slot;
+
+				view1_icgn[slot]->tar_img = &frame->view1_img;
+				view1_icgn[slot]->prepareTar();
+				view2_icgn[slot]->tar_img = &frame->view2_img;
+				view2_icgn[slot]->prepareTar();
+			}
+
+			frame->prepare_time = omp_get_wtime();
+			prepared_queue->push(frame);
+		}
+
+		prepare_closed = true;
+	}
+
+	void StereoStream::matchStage()
+	{
+		omp_set_num_threads(match_threads);
+
+		StreamFrame* frame = nullptr;
+		int idle_count = 0;
+		while (true)
+		{
+			bool closed = prepare_closed.load();
+			if (!prepared_queue->pop(frame))
+			{
+				if (closed)
+				{
+					break;
+				}
+				idle(idle_count);
+				continue;
+			}
+			idle_count = 0;
+
+			double deadline = latency_budget > 0 ? frame->ingest_time + latency_budget : std::numeric_limits<double>::max();
+			if (!frame->dropped && omp_get_wtime() > deadline)
+			{
+				frame->dropped = true;
+			}
+
+			if (!frame->dropped)
+			{
+				//start from the results of last frame
+				frame->view1_queue = view1_state;
+				frame->view2_queue = view2_state;
+				ICGN2D1* view1_engine = view1_icgn[frame->slot];
+				ICGN2D1* view2_engine = view2_icgn[frame->slot];
+
+				int queue_length = (int)view1_state.size();
+#pragma omp parallel for schedule(dynamic)
+				for (int i = 0; i < queue_length; i++)
+				{
+					//POIs are skipped rather than delaying the whole stream
+					if (omp_get_wtime() > deadline)
+					{
+						frame->view1_queue[i].result.zncc = -6;
+						frame->view2_queue[i].result.zncc = -6;
+						continue;
+					}
+					view1_engine->compute(&frame->view1_queue[i]);
+					view2_engine->compute(&frame->view2_queue[i]);
+				}
+
+				//update the initial guess of next frame with reliable results
+				for (int i = 0; i < queue_length; i++)
+				{
+					if (frame->view1_queue[i].result.zncc == -6)
+					{
+						frame->dropped_pois++;
+						continue;
+					}
+					if (frame->view1_queue[i].result.zncc >= zncc_threshold)
+					{
+						view1_state[i] = frame->view1_queue[i];
+					}
+					if (frame->view2_queue[i].result.zncc >= zncc_threshold)
+					{
+						view2_state[i] = frame->view2_queue[i];
+					}
+				}
+			}
+
+			//release the slot for the preparation of next frame
+			if (frame->slot >= 0)
+			{
+				slot_queue->push(frame->slot);
+			}
+
+			frame->match_time = omp_get_wtime();
+			matched_queue->push(frame);
+		}
+
+		match_closed = true;
+	}
+
+	void StereoStream::outputStage()
+	{
+		omp_set_num_threads(output_threads);
+
+		StreamFrame* frame = nullptr;
+		int idle_count = 0;
+		while (true)
+		{
+			bool closed = match_closed.load();
+			if (!matched_queue->pop(frame))
+			{
+				if (closed)
+				{
+					break;
+				}
+				idle(idle_count);
+				continue;
+			}
+			idle_count = 0;
+
+			if (frame->dropped)
+			{
+				stage_dropped++;
+			}
+			else
+			{
+				//matched coordinates, the POIs failed in either view are set as NaN
+				int queue_length = (int)frame->view1_queue.size();
+				frame->view1_x.resize(queue_length);
+				frame->view1_y.resize(queue_length);
+				frame->view2_x.resize(queue_length);
+				frame->view2_y.resize(queue_length);
+				for (int i = 0; i < queue_length; i++)
+				{
+					POI2D& view1_poi = frame->view1_queue[i];
+					POI2D& view2_poi = frame->view2_queue[i];
+					bool valid = view1_poi.result.zncc >= 0 && view2_poi.result.zncc >= 0;
+					float nan = std::numeric_limits<float>::quiet_NaN();
+					frame->view1_x[i] = valid ? view1_poi.x + view1_poi.deformation.u : nan;
+					frame->view1_y[i] = valid ? view1_poi.y + view1_poi.deformation.v : nan;
+					frame->view2_x[i] = valid ? view2_poi.x + view2_poi.deformation.u : nan;
+					frame->view2_y[i] = valid ? view2_poi.y + view2_poi.deformation.v : nan;
+				}
+
+				if (stereovision != nullptr)
+				{
+					stereovision->reconstruct(frame->view1_x, frame->view1_y, frame->view2_x, frame->view2_y,
+						frame->space_x, frame->space_y, frame->space_z);
+				}
+
+				frame->output_time = omp_get_wtime();
+				if (output)
+				{
+					output(*frame);
+				}
+
+				dropped_pois += frame->dropped_pois;
+				latency_record.push_back(frame->output_time - frame->ingest_time);
+				last_output_time = frame->output_time;
+			}
+
+			free_queue->push(frame);
+		}
+	}
+
+	StreamStatistics StereoStream::getStatistics() const
+	{
+		StreamStatistics statistics;
+		statistics.pushed_frames = pushed_frames;
+		statistics.completed_frames = (int)latency_record.size();
+		statistics.dropped_frames = ingest_dropped + stage_dropped;
+		statistics.dropped_pois = dropped_pois;
+		statistics.throughput = 0.;
+		statistics.latency_mean = 0.;
+		statistics.latency_p50 = 0.;
+		statistics.latency_p90 = 0.;
+		statistics.latency_p99 = 0.;
+		statistics.latency_max = 0.;
+
+		int completed = statistics.completed_frames;
+		if (completed == 0)
+		{
+			return statistics;
+		}
+
+		if (last_output_time > first_ingest_time)
+		{
+			statistics.throughput = completed / (last_output_time - first_ingest_time);
+		}
+
+		std::vector<double> latency = latency_record;
+		std::sort(latency.begin(), latency.end());
+		double latency_sum = 0.;
+		for (auto& value : latency)
+		{
+			latency_sum += value;
+		}
+		statistics.latency_mean = latency_sum / completed;
+		statistics.latency_p50 = latency[(size_t)(0.50 * (completed - 1) + 0.5)];
+		statistics.latency_p90 = latency[(size_t)(0.90 * (completed - 1) + 0.5)];
+		statistics.latency_p99 = latency[(size_t)(0.99 * (completed - 1) + 0.5)];
+		statistics.latency_max = latency[completed - 1];
+
+		return statistics;
+	}
+
+}//namespace opencorr
@@ -0,0 +1,182 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _STEREO_STREAM_H_
+#define _STEREO_STREAM_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "oc_array.h"
+#include "oc_icgn.h"
+#include "oc_image.h"
+#include "oc_poi.h"
+#include "oc_stereovision.h"
+
+namespace opencorr
+{
+	//bounded lock-free queue with a single producer thread and a single consumer thread
+	template <typename T>
+	class SPSCQueue
+	{
+	private:
+		std::vector<T> buffer;
+		size_t mask;
+		std::atomic<size_t> head; //written by consumer only
+		char padding[64]; //keep the two indices in different cache lines
+		std::atomic<size_t> tail; //written by producer only
+
+	public:
+		SPSCQueue(int capacity)
+		{
+			size_t size = 1;
+			while (size < (size_t)capacity)
+			{
+				size <<= 1;
+			}
+			buffer.resize(size);
+			mask = size - 1;
+			head.store(0);
+			tail.store(0);
+		}
+
+		bool push(const T& item)
+		{
+			size_t cur_tail = tail.load(std::memory_order_relaxed);
+			if (cur_tail - head.load(std::memory_order_acquire) == buffer.size())
+			{
+				return false;
+			}
+			buffer[cur_tail & mask] = item;
+			tail.store(cur_tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(T& item)
+		{
+			size_t cur_head = head.load(std::memory_order_relaxed);
+			if (cur_head == tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			item = buffer[cur_head & mask];
+			head.store(cur_head + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool empty() const //called by consumer
+		{
+			return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+		}
+	};
+
+	//a pair of images and the results computed from them
+	class StreamFrame
+	{
+	public:
+		int index; //index of frame in the order of pushing
+		bool dropped; //true if the frame is dropped due to latency budget
+		int dropped_pois; //number of POIs skipped due to latency budget, with ZNCC set as -6
+		int slot; //slot of ICGN instances holding the interpolation of this frame, -1 if not assigned
+
+		Image2D view1_img, view2_img; //target images of the two views
+		std::vector<POI2D> view1_queue, view2_queue; //POIs in ref image of view1, matched to target images of view1 and view2
+		std::vector<float> view1_x, view1_y, view2_x, view2_y; //matched coordinates in the two views
+		std::vector<float> space_x, space_y, space_z; //reconstructed coordinates, available if Stereovision is set
+
+		double ingest_time, prepare_time, match_time, output_time; //time stamps obtained with omp_get_wtime()
+
+		StreamFrame(int width, int height);
+		~StreamFrame() = default;
+	};
+
+	struct StreamStatistics
+	{
+		int pushed_frames; //frames fed into push()
+		int completed_frames; //frames passed through all stages
+		int dropped_frames; //frames dropped at ingest, preparation or matching
+		long long dropped_pois; //POIs skipped in the completed frames
+		double throughput; //completed frames per second
+		double latency_mean, latency_p50, latency_p90, latency_p99, latency_max; //latency from push() to output, in seconds
+	};
+
+	class StereoStream
+	{
+	protected:
+		int subset_radius_x, subset_radius_y;
+		int prepare_threads; //OpenMP threads used by the stage preparing interpolation of target images
+		int match_threads; //OpenMP threads used by the stage of ICGN
+		int output_threads; //OpenMP threads used by the stage of reconstruction and output
+		int frame_number; //number of frames in flight, i.e. the capacity of queues
+		double latency_budget; //in seconds, non-positive value disables the budget
+		float zncc_threshold; //POIs with ZNCC above this threshold update the initial guess of next frame
+
+		Image2D* ref_img = nullptr; //ref image of view1
+		std::vector<POI2D> view1_state, view2_state; //latest results used as the initial guess of next frame
+		Stereovision* stereovision = nullptr;
+		std::function<void(StreamFrame&)> output;
+
+		//two slots of ICGN instances, the target images of next frame are prepared while current frame is matched
+		ICGN2D1* view1_icgn[2];
+		ICGN2D1* view2_icgn[2];
+
+		std::vector<StreamFrame*> frame_pool;
+		SPSCQueue<StreamFrame*>* free_queue = nullptr; //output -> push()
+		SPSCQueue<StreamFrame*>* ingest_queue = nullptr; //push() -> prepare
+		SPSCQueue<StreamFrame*>* prepared_queue = nullptr; //prepare -> match
+		SPSCQueue<StreamFrame*>* matched_queue = nullptr; //match -> output
+		SPSCQueue<int>* slot_queue = nullptr; //match -> prepare
+
+		std::thread prepare_thread, match_thread, output_thread;
+		std::atomic<bool> ingest_closed, prepare_closed, match_closed;
+		bool running;
+
+		int pushed_frames, ingest_dropped; //counted in the thread calling push()
+		int stage_dropped; //counted in output stage
+		long long dropped_pois;
+		double first_ingest_time, last_output_time;
+		std::vector<double> latency_record;
+
+		void idle(int& idle_count); //wait for the next item in queue
+		void prepareStage();
+		void matchStage();
+		void outputStage();
+		void releaseFrames();
+
+	public:
+		StereoStream(int subset_radius_x, int subset_radius_y, float conv_criterion, float stop_condition,
+			int prepare_threads, int match_threads, int output_threads, int frame_number);
+		~StereoStream();
+
+		void setLatencyBudget(double latency_budget);
+		void setTracking(float zncc_threshold);
+		void setStereovision(Stereovision* stereovision); //the cameras should be prepared for undistortion
+		void setOutput(std::function<void(StreamFrame&)> output); //called in output stage for each completed frame
+
+		//set ref image of view1 and the initial guess of POIs in the two views, the reference side is prepared here once
+		void setReference(Image2D& ref_img, std::vector<POI2D>& view1_queue, std::vector<POI2D>& view2_queue);
+
+		void start();
+		bool push(Image2D& view1_img, Image2D& view2_img); //return false if the frame is dropped at ingest, call it in one thread
+		void finish(); //wait until all pushed frames are processed
+
+		StreamStatistics getStatistics() const; //valid after finish()
+	};
+
+}//namespace opencorr
+
+#endif //_STEREO_STREAM_H_
@@ -0,0 +1,241 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include "oc_stereorectification.h"
+
+namespace opencorr
+{
+	Stereorectification::Stereorectification(Calibration* view1_cam, Calibration* view2_cam, int thread_number)
+	{
+		this->view1_cam = view1_cam;
+		this->view2_cam = view2_cam;
+		this->thread_number = thread_number;
+		height = 0;
+		width = 0;
+	}
+
+	Stereorectification::~Stereorectification() {}
+
+	void Stereorectification::updateCameras(Calibration* view1_cam, Calibration* view2_cam)
+	{
+		this->view1_cam = view1_cam;
+		this->view2_cam = view2_cam;
+	}
+
+	void Stereorectification::prepare(int height, int width)
+	{
+		this->height = height;
+		this->width = width;
+
+		view1_cam->updateMatrices();
+		view2_cam->updateMatrices();
+
+		//optical centers of the two cameras in world coordinate system
+		Eigen::Vector3f view1_center = -view1_cam->rotation_matrix.transpose() * view1_cam->translation_vector;
+		Eigen::Vector3f view2_center = -view2_cam->rotation_matrix.transpose() * view2_cam->translation_vector;
+
+		//x axis of rectified cameras goes along the baseline, y axis is perpendicular to the average optical axis
+		Eigen::Vector3f axis_x = (view2_center - view1_center).normalized();
+		Eigen::Vector3f optical_axis = (view1_cam->rotation_matrix.row(2) + view2_cam->rotation_matrix.row(2)).transpose();
+		Eigen::Vector3f axis_y = optical_axis.cross(axis_x).normalized();
+		Eigen::Vector3f axis_z = axis_x.cross(axis_y);
+
+		rectified_rotation.row(0) = axis_x.transpose();
+		rectified_rotation.row(1) = axis_y.transpose();
+		rectified_rotation.row(2) = axis_z.transpose();
+
+		//rotations from the original camera systems to the rectified camera systems
+		Eigen::Matrix3f view1_rotation = rectified_rotation * view1_cam->rotation_matrix.transpose();
+		Eigen::Matrix3f view2_rotation = rectified_rotation * view2_cam->rotation_matrix.transpose();
+
+		//the two rectified cameras share the focal lengths without skew
+		float focal_x = 0.5f * (view1_cam->intrinsics.fx + view2_cam->intrinsics.fx);
+		float focal_y = 0.5f * (view1_cam->intrinsics.fy + view2_cam->intrinsics.fy);
+
+		//principal points are set to keep the centers of original images at the centers of rectified images,
+		//cy is shared by the two views to align the rows
+		Eigen::Vector3f image_center((width - 1) * 0.5f, (height - 1) * 0.5f, 1.f);
+		Eigen::Vector3f view1_ray = view1_rotation * view1_cam->intrinsic_matrix.inverse() * image_center;
+		Eigen::Vector3f view2_ray = view2_rotation * view2_cam->intrinsic_matrix.inverse() * image_center;
+		float view1_cx = image_center(0) - focal_x * view1_ray(0) / view1_ray(2);
+		float view2_cx = image_center(0) - focal_x * view2_ray(0) / view2_ray(2);
+		float shared_cy = image_center(1) - 0.5f * focal_y * (view1_ray(1) / view1_ray(2) + view2_ray(1) / view2_ray(2));
+
+		CameraIntrinsics rectified_intrinsics;
+		for (int i = 0; i < 13; i++)
+		{
+			rectified_intrinsics.cam_i[i] = 0.f;
+		}
+		rectified_intrinsics.fx = focal_x;
+		rectified_intrinsics.fy = focal_y;
+		rectified_intrinsics.cy = shared_cy;
+
+		//the rectified primary camera is taken as the world coordinate system
+		CameraExtrinsics rectified_extrinsics;
+		for (int i = 0; i < 6; i++)
+		{
+			rectified_extrinsics.cam_e[i] = 0.f;
+		}
+		rectified_intrinsics.cx = view1_cx;
+		view1_rectified_cam.updateCalibration(rectified_intrinsics, rectified_extrinsics);
+
+		Eigen::Vector3f view2_translation = rectified_rotation * (view1_center - view2_center);
+		rectified_extrinsics.tx = view2_translation(0);
+		rectified_extrinsics.ty = view2_translation(1);
+		rectified_extrinsics.tz = view2_translation(2);
+		rectified_intrinsics.cx = view2_cx;
+		view2_rectified_cam.updateCalibration(rectified_intrinsics, rectified_extrinsics);
+
+		//homographies from undistorted pixels in original views to pixels in rectified views
+		view1_homography = view1_rectified_cam.intrinsic_matrix * view1_rotation * view1_cam->intrinsic_matrix.inverse();
+		view2_homography = view2_rectified_cam.intrinsic_matrix * view2_rotation * view2_cam->intrinsic_matrix.inverse();
+		view1_inv_homography = view1_homography.inverse();
+		view2_inv_homography = view2_homography.inverse();
+
+		//remap tables with the distortion of original cameras folded in
+		view1_map_x.resize(height, width);
+		view1_map_y.resize(height, width);
+		view2_map_x.resize(height, width);
+		view2_map_y.resize(height, width);
+
+#pragma omp parallel for
+		for (int r = 0; r < height; r++)
+		{
+			std::vector<float> row_x(width), row_y(width);
+			rectifiedRowToView(view1_cam, view1_inv_homography, r, row_x, row_y);
+			for (int c = 0; c < width; c++)
+			{
+				view1_map_x(r, c) = row_x[c];
+				view1_map_y(r, c) = row_y[c];
+			}
+			rectifiedRowToView(view2_cam, view2_inv_homography, r, row_x, row_y);
+			for (int c = 0; c < width; c++)
+			{
+				view2_map_x(r, c) = row_x[c];
+				view2_map_y(r, c) = row_y[c];
+			}
+		}
+	}
+
+	void Stereorectification::rectifiedRowToView(Calibration* view_cam, Eigen::Matrix3f& inv_homography, int row, std::vector<float>& view_x, std::vector<float>& view_y)
+	{
+		//undistorted image coordinates of the pixels in the row
+		CameraIntrinsics& intrinsics = view_cam->intrinsics;
+		std::vector<float> image_x(width), image_y(width);
+		for (int c = 0; c < width; c++)
+		{
+			Eigen::Vector3f view_vector = inv_homography * Eigen::Vector3f((float)c, (float)row, 1.f);
+			float sensor_x = view_vector(0) / view_vector(2);
+			float sensor_y = view_vector(1) / view_vector(2);
+			image_y[c] = (sensor_y - intrinsics.cy) / intrinsics.fy;
+			image_x[c] = (sensor_x - intrinsics.cx - intrinsics.fs * image_y[c]) / intrinsics.fx;
+		}
+
+		//impose the distortion of original camera on the whole row, then convert to sensor coordinates
+		view_cam->distort(image_x.data(), image_y.data(), view_x.data(), view_y.data(), width);
+		for (int c = 0; c < width; c++)
+		{
+			float distorted_x = view_x[c];
+			float distorted_y = view_y[c];
+			view_y[c] = distorted_y * intrinsics.fy + intrinsics.cy;
+			view_x[c] = distorted_x * intrinsics.fx + distorted_y * intrinsics.fs + intrinsics.cx;
+		}
+	}
+
+	Point2D Stereorectification::rectifiedToView(Calibration* view_cam, Eigen::Matrix3f& inv_homography, Point2D& point)
+	{
+		Eigen::Vector3f rectified_vector(point.x, point.y, 1.f);
+		Eigen::Vector3f view_vector = inv_homography * rectified_vector;
+
+		//impose the distortion of original camera in image coordinate system
+		Point2D undistorted_point(view_vector(0) / view_vector(2), view_vector(1) / view_vector(2));
+		Point2D image_coordinate = view_cam->sensor_to_image(undistorted_point);
+		Point2D distorted_coordinate = view_cam->distort(image_coordinate);
+
+		return view_cam->image_to_sensor(distorted_coordinate);
+	}
+
+	Point2D Stereorectification::viewToRectified(Calibration* view_cam, Eigen::Matrix3f& homography, Point2D& point)
+	{
+		if (view_cam->map_x.rows() == 0 || view_cam->map_y.rows() == 0)
+		{
+			throw std::string("Undistortion map of camera is not prepared");
+		}
+
+		Point2D undistorted_point = view_cam->undistort(point);
+
+		Eigen::Vector3f view_vector(undistorted_point.x, undistorted_point.y, 1.f);
+		Eigen::Vector3f rectified_vector = homography * view_vector;
+
+		Point2D rectified_point(rectified_vector(0) / rectified_vector(2), rectified_vector(1) / rectified_vector(2));
+		return rectified_point;
+	}
+
+	void Stereorectification::remap(Image2D& view_img, Eigen::MatrixXf& map_x, Eigen::MatrixXf& map_y, Image2D& rectified_img)
+	{
+		if (view_img.height != height || view_img.width != width)
+		{
+			throw std::string("Image dimensions differ from the prepared remap tables");
+		}
+
+		rectified_img.height = height;
+		rectified_img.width = width;
+		rectified_img.eg_mat = Eigen::MatrixXf::Zero(height, width);
+
+		BicubicBspline* view_interp = new BicubicBspline(view_img);
+		view_interp->prepare();
+
+#pragma omp parallel for
+		for (int r = 0; r < height; r++)
+		{
+			for (int c = 0; c < width; c++)
+			{
+				Point2D location(map_x(r, c), map_y(r, c));
+				if (location.x >= 0 && location.y >= 0 && location.x <= width - 1 && location.y <= height - 1)
+				{
+					rectified_img.eg_mat(r, c) = view_interp->compute(location);
+				}
+			}
+		}
+
+		delete view_interp;
+	}
+
+	void Stereorectification::rectify(Image2D& view1_img, Image2D& view2_img, Image2D& view1_rectified_img, Image2D& view2_rectified_img)
+	{
+		remap(view1_img, view1_map_x, view1_map_y, view1_rectified_img);
+		remap(view2_img, view2_map_x, view2_map_y, view2_rectified_img);
+	}
+
+	Point2D Stereorectification::view1ToRectified(Point2D& point)
+	{
+		return viewToRectified(view1_cam, view1_homography, point);
+	}
+
+	Point2D Stereorectification::view2ToRectified(Point2D& point)
+	{
+		return viewToRectified(view2_cam, view2_homography, point);
+	}
+
+	Point2D Stereorectification::rectifiedToView1(Point2D& point)
+	{
+		return rectifiedToView(view1_cam, view1_inv_homography, point);
+	}
+
+	Point2D Stereorectification::rectifiedToView2(Point2D& point)
+	{
+		return rectifiedToView(view2_cam, view2_inv_homography, point);
+	}
+
+}//namespace opencorr
\ No newline at end of file
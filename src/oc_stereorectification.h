@@ -0,0 +1,86 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _STEREORECTIFICATION_H_
+#define _STEREORECTIFICATION_H_
+
+#include "oc_array.h"
+#include "oc_calibration.h"
+#include "oc_cubic_bspline.h"
+#include "oc_image.h"
+#include "oc_point.h"
+
+namespace opencorr
+{
+	//this module is the implementation of
+	//A. Fusiello et al, Machine Vision and Applications (2000) 12: 16-22.
+	//https://doi.org/10.1007/s001380050003
+
+	class Stereorectification
+	{
+	protected:
+		Calibration* view1_cam = nullptr; //intrinsics and extrinsics of the primary camera
+		Calibration* view2_cam = nullptr; //intrinsics and extrinsics of the secondary camera
+		int height, width; //dimensions of original images, also used for rectified images
+		int thread_number; //CPU thread number
+		Eigen::Matrix3f view1_inv_homography, view2_inv_homography; //inversed homographies for back-mapping
+
+		//project a pixel in rectified view to the distorted coordinates in original view
+		Point2D rectifiedToView(Calibration* view_cam, Eigen::Matrix3f& inv_homography, Point2D& point);
+
+		//project a row of pixels in rectified view to the distorted coordinates in original view
+		void rectifiedRowToView(Calibration* view_cam, Eigen::Matrix3f& inv_homography, int row, std::vector<float>& view_x, std::vector<float>& view_y);
+
+		//project a pixel in original view to rectified view
+		Point2D viewToRectified(Calibration* view_cam, Eigen::Matrix3f& homography, Point2D& point);
+
+		//resample an original image according to the remap tables
+		void remap(Image2D& view_img, Eigen::MatrixXf& map_x, Eigen::MatrixXf& map_y, Image2D& rectified_img);
+
+	public:
+		Eigen::Matrix3f rectified_rotation; //rotation from world coordinate system to the rectified camera systems
+		Eigen::Matrix3f view1_homography, view2_homography; //homographies from undistorted original pixels to rectified pixels
+
+		//distorted coordinates in the original views corresponding to the pixels in rectified views
+		Eigen::MatrixXf view1_map_x, view1_map_y;
+		Eigen::MatrixXf view2_map_x, view2_map_y;
+
+		//rectified cameras without distortion, the primary one is taken as world coordinate system
+		Calibration view1_rectified_cam;
+		Calibration view2_rectified_cam;
+
+		Stereorectification(Calibration* view1_cam, Calibration* view2_cam, int thread_number);
+		~Stereorectification();
+
+		void updateCameras(Calibration* view1_cam, Calibration* view2_cam);
+
+		//compute the rectified cameras, homographies and remap tables for the images of given dimensions
+		void prepare(int height, int width);
+
+		//rectify a pair of images, the results are stored in eg_mat of rectified images
+		void rectify(Image2D& view1_img, Image2D& view2_img, Image2D& view1_rectified_img, Image2D& view2_rectified_img);
+
+		//map the points between original views and rectified views,
+		//the points mapped back to original views can be directly fed into Stereovision::reconstruct
+		Point2D view1ToRectified(Point2D& point);
+		Point2D view2ToRectified(Point2D& point);
+		Point2D rectifiedToView1(Point2D& point);
+		Point2D rectifiedToView2(Point2D& point);
+	};
+
+}//namespace opencorr
+
+#endif //_STEREORECTIFICATION_H_
\ No newline at end of file
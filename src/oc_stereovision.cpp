@@ -12,6 +12,8 @@
  * More information about OpenCorr can be found at https://www.opencorr.org/
  */
 
+#include <algorithm>
+
 #include "oc_stereovision.h"
 
 namespace opencorr
@@ -65,6 +67,121 @@ namespace opencorr
 		updateFundementalMatrix();
 	}
 
+	//linear triangulation over the views selected by mask, through the closed-form solution of the 3x3 normal equations,
+	//each view contributes two rows: (x * P(2, 0:2) - P(0, 0:2)) * X = P(0, 3) - x * P(2, 3), same for y
+	bool Stereovision::triangulateViews(const double* projection, const double* image_x, const double* image_y,
+		int view_number, unsigned int mask, double* space_coor)
+	{
+		double n00 = 0, n01 = 0, n02 = 0, n11 = 0, n12 = 0, n22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		for (int i = 0; i < view_number; i++)
+		{
+			if ((mask >> i & 1u) == 0)
+			{
+				continue;
+			}
+
+			const double* P = projection + 12 * i;
+			double image_coor[2] = { image_x[i], image_y[i] };
+			for (int k = 0; k < 2; k++)
+			{
+				double r0 = image_coor[k] * P[8] - P[4 * k];
+				double r1 = image_coor[k] * P[9] - P[4 * k + 1];
+				double r2 = image_coor[k] * P[10] - P[4 * k + 2];
+				double r3 = image_coor[k] * P[11] - P[4 * k + 3];
+				n00 += r0 * r0;
+				n01 += r0 * r1;
+				n02 += r0 * r2;
+				n11 += r1 * r1;
+				n12 += r1 * r2;
+				n22 += r2 * r2;
+				b0 -= r0 * r3;
+				b1 -= r1 * r3;
+				b2 -= r2 * r3;
+			}
+		}
+
+		//inverse of the symmetric matrix through its adjugate
+		double c00 = n11 * n22 - n12 * n12;
+		double c01 = n02 * n12 - n01 * n22;
+		double c02 = n01 * n12 - n02 * n11;
+		double c11 = n00 * n22 - n02 * n02;
+		double c12 = n01 * n02 - n00 * n12;
+		double c22 = n00 * n11 - n01 * n01;
+		double determinant = n00 * c00 + n01 * c01 + n02 * c02;
+		if (determinant == 0 || std::isnan(determinant))
+		{
+			return false;
+		}
+
+		space_coor[0] = (c00 * b0 + c01 * b1 + c02 * b2) / determinant;
+		space_coor[1] = (c01 * b0 + c11 * b1 + c12 * b2) / determinant;
+		space_coor[2] = (c02 * b0 + c12 * b1 + c22 * b2) / determinant;
+		return true;
+	}
+
+	//triangulation of a point in the two views, projection holds the two 3x4 matrices in row-major order
+	inline bool triangulate(const double* projection, double x_view1, double y_view1, double x_view2, double y_view2,
+		double* space_coor, double* covariance)
+	{
+		double image_x[2] = { x_view1, x_view2 };
+		double image_y[2] = { y_view1, y_view2 };
+		if (!Stereovision::triangulateViews(projection, image_x, image_y, 2, 3u, space_coor))
+		{
+			return false;
+		}
+
+		//first-order covariance for the image coordinates with unit variance,
+		//the Jacobian of reprojection is the rows divided by the projective depth
+		if (covariance != nullptr)
+		{
+			double image_coor[4] = { x_view1, y_view1, x_view2, y_view2 };
+			double j00 = 0, j01 = 0, j02 = 0, j11 = 0, j12 = 0, j22 = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				const double* P = projection + 12 * (i / 2);
+				int row = i % 2;
+				double r0 = image_coor[i] * P[8] - P[4 * row];
+				double r1 = image_coor[i] * P[9] - P[4 * row + 1];
+				double r2 = image_coor[i] * P[10] - P[4 * row + 2];
+				double depth = P[8] * space_coor[0] + P[9] * space_coor[1] + P[10] * space_coor[2] + P[11];
+				double weight = 1. / (depth * depth);
+				j00 += r0 * r0 * weight;
+				j01 += r0 * r1 * weight;
+				j02 += r0 * r2 * weight;
+				j11 += r1 * r1 * weight;
+				j12 += r1 * r2 * weight;
+				j22 += r2 * r2 * weight;
+			}
+
+			double d00 = j11 * j22 - j12 * j12;
+			double d01 = j02 * j12 - j01 * j22;
+			double d02 = j01 * j12 - j02 * j11;
+			double j_determinant = j00 * d00 + j01 * d01 + j02 * d02;
+
+			covariance[0] = d00 / j_determinant;
+			covariance[1] = d01 / j_determinant;
+			covariance[2] = d02 / j_determinant;
+			covariance[3] = (j00 * j22 - j02 * j02) / j_determinant;
+			covariance[4] = (j01 * j02 - j00 * j12) / j_determinant;
+			covariance[5] = (j00 * j11 - j01 * j01) / j_determinant;
+		}
+
+		return true;
+	}
+
+	void Stereovision::getProjection(double* projection) const
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				projection[4 * r + c] = (double)view1_cam->projection_matrix(r, c);
+				projection[12 + 4 * r + c] = (double)view2_cam->projection_matrix(r, c);
+			}
+		}
+	}
+
 	Point3D Stereovision::reconstruct(Point2D& view1_2d_point, Point2D& view2_2d_point)
 	{
 		if (std::isnan(view1_2d_point.x) || std::isnan(view1_2d_point.y) || std::isnan(view2_2d_point.x) || std::isnan(view2_2d_point.y))
@@ -77,45 +194,17 @@ namespace opencorr
 			Point2D view1_coor = view1_cam->undistort(view1_2d_point);
 			Point2D view2_coor = view2_cam->undistort(view2_2d_point);
 
-			float x_view1 = view1_coor.x;
-			float y_view1 = view1_coor.y;
-			float x_view2 = view2_coor.x;
-			float y_view2 = view2_coor.y;
-
-			//left side of equations
-			Eigen::MatrixXf left_matrix(4, 3);
-			//column 1
-			left_matrix(0, 0) = x_view1 * view1_cam->projection_matrix(2, 0) - view1_cam->projection_matrix(0, 0);
-			left_matrix(1, 0) = y_view1 * view1_cam->projection_matrix(2, 0) - view1_cam->projection_matrix(1, 0);
-			left_matrix(2, 0) = x_view2 * view2_cam->projection_matrix(2, 0) - view2_cam->projection_matrix(0, 0);
-			left_matrix(3, 0) = y_view2 * view2_cam->projection_matrix(2, 0) - view2_cam->projection_matrix(1, 0);
-
-			//column 2
-			left_matrix(0, 1) = x_view1 * view1_cam->projection_matrix(2, 1) - view1_cam->projection_matrix(0, 1);
-			left_matrix(1, 1) = y_view1 * view1_cam->projection_matrix(2, 1) - view1_cam->projection_matrix(1, 1);
-			left_matrix(2, 1) = x_view2 * view2_cam->projection_matrix(2, 1) - view2_cam->projection_matrix(0, 1);
-			left_matrix(3, 1) = y_view2 * view2_cam->projection_matrix(2, 1) - view2_cam->projection_matrix(1, 1);
-
-			//column 3
-			left_matrix(0, 2) = x_view1 * view1_cam->projection_matrix(2, 2) - view1_cam->projection_matrix(0, 2);
-			left_matrix(1, 2) = y_view1 * view1_cam->projection_matrix(2, 2) - view1_cam->projection_matrix(1, 2);
-			left_matrix(2, 2) = x_view2 * view2_cam->projection_matrix(2, 2) - view2_cam->projection_matrix(0, 2);
-			left_matrix(3, 2) = y_view2 * view2_cam->projection_matrix(2, 2) - view2_cam->projection_matrix(1, 2);
-
-			//right side of equations
-			Eigen::Vector4f right_matrix;
-			right_matrix(0) = view1_cam->projection_matrix(0, 3) - x_view1 * view1_cam->projection_matrix(2, 3);
-			right_matrix(1) = view1_cam->projection_matrix(1, 3) - y_view1 * view1_cam->projection_matrix(2, 3);
-			right_matrix(2) = view2_cam->projection_matrix(0, 3) - x_view2 * view2_cam->projection_matrix(2, 3);
-			right_matrix(3) = view2_cam->projection_matrix(1, 3) - y_view2 * view2_cam->projection_matrix(2, 3);
-
-			//determine the world coordinates by solving the equations
-			Eigen::Vector3f world_coor = left_matrix.colPivHouseholderQr().solve(right_matrix);
+			double projection[24];
+			getProjection(projection);
 
 			Point3D space_3d_point;
-			space_3d_point.x = world_coor(0);
-			space_3d_point.y = world_coor(1);
-			space_3d_point.z = world_coor(2);
+			double world_coor[3];
+			if (triangulate(projection, view1_coor.x, view1_coor.y, view2_coor.x, view2_coor.y, world_coor, nullptr))
+			{
+				space_3d_point.x = (float)world_coor[0];
+				space_3d_point.y = (float)world_coor[1];
+				space_3d_point.z = (float)world_coor[2];
+			}
 
 			return space_3d_point;
 		}
@@ -130,4 +219,72 @@ namespace opencorr
 		}
 	}
 
+	void Stereovision::reconstruct(std::vector<float>& view1_x, std::vector<float>& view1_y, std::vector<float>& view2_x, std::vector<float>& view2_y,
+		std::vector<float>& space_x, std::vector<float>& space_y, std::vector<float>& space_z, std::vector<float>* covariance)
+	{
+		int queue_length = (int)view1_x.size();
+		if ((int)view1_y.size() != queue_length || (int)view2_x.size() != queue_length || (int)view2_y.size() != queue_length)
+		{
+			throw std::string("Mismatched length of coordinate arrays");
+		}
+
+		space_x.resize(queue_length);
+		space_y.resize(queue_length);
+		space_z.resize(queue_length);
+		if (covariance != nullptr)
+		{
+			covariance->resize(6 * (size_t)queue_length);
+		}
+
+		//the projection matrices are fetched once for the whole batch
+		double projection[24];
+		getProjection(projection);
+
+		//the points are undistorted in chunks through the batch interface of Calibration
+		const int chunk_size = 1024;
+		int chunk_number = (queue_length + chunk_size - 1) / chunk_size;
+
+#pragma omp parallel for
+		for (int k = 0; k < chunk_number; k++)
+		{
+			int chunk_begin = k * chunk_size;
+			int chunk_length = std::min(chunk_size, queue_length - chunk_begin);
+
+			float view1_undistorted_x[chunk_size], view1_undistorted_y[chunk_size];
+			float view2_undistorted_x[chunk_size], view2_undistorted_y[chunk_size];
+			view1_cam->undistort(&view1_x[chunk_begin], &view1_y[chunk_begin], view1_undistorted_x, view1_undistorted_y, chunk_length);
+			view2_cam->undistort(&view2_x[chunk_begin], &view2_y[chunk_begin], view2_undistorted_x, view2_undistorted_y, chunk_length);
+
+			for (int j = 0; j < chunk_length; j++)
+			{
+				int i = chunk_begin + j;
+				space_x[i] = 0.f;
+				space_y[i] = 0.f;
+				space_z[i] = 0.f;
+				if (std::isnan(view1_x[i]) || std::isnan(view1_y[i]) || std::isnan(view2_x[i]) || std::isnan(view2_y[i]))
+				{
+					continue;
+				}
+
+				double world_coor[3];
+				double point_covariance[6];
+				double* covariance_ptr = covariance != nullptr ? point_covariance : nullptr;
+				if (triangulate(projection, view1_undistorted_x[j], view1_undistorted_y[j],
+					view2_undistorted_x[j], view2_undistorted_y[j], world_coor, covariance_ptr))
+				{
+					space_x[i] = (float)world_coor[0];
+					space_y[i] = (float)world_coor[1];
+					space_z[i] = (float)world_coor[2];
+					if (covariance != nullptr)
+					{
+						for (int m = 0; m < 6; m++)
+						{
+							(*covariance)[6 * (size_t)i + m] = (float)point_covariance[m];
+						}
+					}
+				}
+			}
+		}
+	}
+
 }//namespace opencorr
\ No newline at end of file
@@ -30,6 +30,8 @@ namespace opencorr
 		Calibration* view2_cam = nullptr; //intrinsics and extrinsics of the secondary camera
 		int thread_number; //CPU thread number
 
+		void getProjection(double* projection) const; //projection matrices of the two views, row-major in double
+
 	public:
 		Eigen::Matrix3f fundamental_matrix; //fundamental matrix of binocular stereovision system
 
@@ -42,6 +44,16 @@ namespace opencorr
 
 		Point3D reconstruct(Point2D& view1_2d_point, Point2D& view2_2d_point);
 		void reconstruct(std::vector<Point2D>& view1_2d_point_queue, std::vector<Point2D>& view2_2d_point_queue, std::vector<Point3D>& space_3d_point_queue);
+
+		//batch reconstruction over arrays of coordinates, covariance (optional) stores six elements per point,
+		//i.e. xx, xy, xz, yy, yz, zz, corresponding to the unit variance of image coordinates
+		void reconstruct(std::vector<float>& view1_x, std::vector<float>& view1_y, std::vector<float>& view2_x, std::vector<float>& view2_y,
+			std::vector<float>& space_x, std::vector<float>& space_y, std::vector<float>& space_z, std::vector<float>* covariance = nullptr);
+
+		//linear triangulation over the views selected by mask (bit i for view i), projection holds the 3x4 matrices
+		//of view_number views in row-major order, false if the selected views do not determine the point, shared with Multiview
+		static bool triangulateViews(const double* projection, const double* image_x, const double* image_y,
+			int view_number, unsigned int mask, double* space_coor);
 	};
 
 }//namespace opencorr
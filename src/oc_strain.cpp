@@ -16,16 +16,6 @@
 
 namespace opencorr
 {
-	NearestNeighbor* Strain::getInstance(int tid)
-	{
-		if (tid >= (int)instance_pool.size())
-		{
-			throw std::string("CPU thread ID over limit");
-		}
-
-		return instance_pool[tid];
-	}
-
 	Strain::Strain(float subregion_radius, int min_neighbor_num, int thread_number)
 	{
 		setSubregionRadius(subregion_radius);
@@ -36,20 +26,10 @@ namespace opencorr
 		setApproximation(1);
 
 		this->thread_number = thread_number;
-		for (int i = 0; i < thread_number; i++)
-		{
-			NearestNeighbor* instance = new NearestNeighbor();
-			instance_pool.push_back(instance);
-		}
 	}
 
 	Strain::~Strain()
 	{
-		for (auto& instance : instance_pool)
-		{
-			delete instance;
-		}
-		instance_pool.clear();
 	}
 
 	float Strain::getSubregionRadius() const
@@ -104,14 +84,10 @@ namespace opencorr
 			pt_queue[i].y = poi_queue[i].y;
 		}
 
-#pragma omp parallel for
-		for (int i = 0; i < thread_number; i++)
-		{
-			instance_pool[i]->assignPoints(pt_queue);
-			instance_pool[i]->setSearchRadius(subregion_radius);
-			instance_pool[i]->setSearchK(min_neighbor_num);
-			instance_pool[i]->constructKdTree();
-		}
+		neighbor_search.assignPoints(pt_queue);
+		neighbor_search.setSearchRadius(subregion_radius);
+		neighbor_search.setSearchK(min_neighbor_num);
+		neighbor_search.constructKdTree();
 	}
 
 	void Strain::prepare(std::vector<POI2DS>& poi_queue)
@@ -126,14 +102,10 @@ namespace opencorr
 			pt_queue[i].y = poi_queue[i].y;
 		}
 
-#pragma omp parallel for
-		for (int i = 0; i < thread_number; i++)
-		{
-			instance_pool[i]->assignPoints(pt_queue);
-			instance_pool[i]->setSearchRadius(subregion_radius);
-			instance_pool[i]->setSearchK(min_neighbor_num);
-			instance_pool[i]->constructKdTree();
-		}
+		neighbor_search.assignPoints(pt_queue);
+		neighbor_search.setSearchRadius(subregion_radius);
+		neighbor_search.setSearchK(min_neighbor_num);
+		neighbor_search.constructKdTree();
 	}
 
 	void Strain::prepare(std::vector<POI3D>& poi_queue)
@@ -149,21 +121,14 @@ namespace opencorr
 			pt_queue[i].z = poi_queue[i].z;
 		}
 
-#pragma omp parallel for
-		for (int i = 0; i < thread_number; i++)
-		{
-			instance_pool[i]->assignPoints(pt_queue);
-			instance_pool[i]->setSearchRadius(subregion_radius);
-			instance_pool[i]->setSearchK(min_neighbor_num);
-			instance_pool[i]->constructKdTree();
-		}
+		neighbor_search.assignPoints(pt_queue);
+		neighbor_search.setSearchRadius(subregion_radius);
+		neighbor_search.setSearchK(min_neighbor_num);
+		neighbor_search.constructKdTree();
 	}
 
 	void Strain::compute(POI2D* poi, std::vector<POI2D>& poi_queue)
 	{
-		//get instance of NearestNeighbor according to thread id
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
-
 		//3D point for approximation of nearest neighbors
 		Point3D current_point(poi->x, poi->y, 0.f);
 
@@ -172,7 +137,7 @@ namespace opencorr
 
 		//search the neighbor POIs in a subregion of given radius
 		std::vector<nanoflann::ResultItem<uint32_t, float>> current_matches;
-		int neighbor_num = neighbor_search->radiusSearch(current_point, current_matches);
+		int neighbor_num = neighbor_search.radiusSearch(current_point, current_matches);
 		if (neighbor_num >= min_neighbor_num)
 		{
 			for (int i = 0; i < neighbor_num; i++)
@@ -189,7 +154,7 @@ namespace opencorr
 
 			std::vector<uint32_t> k_neighbors_idx;
 			std::vector<float> squared_distance;
-			neighbor_num = neighbor_search->knnSearch(current_point, k_neighbors_idx, squared_distance);
+			neighbor_num = neighbor_search.knnSearch(current_point, k_neighbors_idx, squared_distance);
 
 			for (int i = 0; i < neighbor_num; i++)
 			{
@@ -277,19 +242,11 @@ namespace opencorr
 
 	void Strain::compute(std::vector<POI2D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i], poi_queue);
-		}
+		scheduler.run(poi_queue, [this, &poi_queue](POI2D* poi) { compute(poi, poi_queue); });
 	}
 
 	void Strain::compute(POI2DS* poi, std::vector<POI2DS>& poi_queue)
 	{
-		//get instance of NearestNeighbor according to thread id
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
-
 		//3D point for approximation of nearest neighbors
 		Point3D current_point(poi->x, poi->y, 0.f);
 
@@ -298,7 +255,7 @@ namespace opencorr
 
 		//search the neighbor keypoints in a subregion of given radius
 		std::vector<nanoflann::ResultItem<uint32_t, float>> current_matches;
-		int neighbor_num = neighbor_search->radiusSearch(current_point, current_matches);
+		int neighbor_num = neighbor_search.radiusSearch(current_point, current_matches);
 		if (neighbor_num >= min_neighbor_num)
 		{
 			for (int i = 0; i < neighbor_num; i++)
@@ -317,7 +274,7 @@ namespace opencorr
 
 			std::vector<uint32_t> k_neighbors_idx;
 			std::vector<float> squared_distance;
-			neighbor_num = neighbor_search->knnSearch(current_point, k_neighbors_idx, squared_distance);
+			neighbor_num = neighbor_search.knnSearch(current_point, k_neighbors_idx, squared_distance);
 
 			for (int i = 0; i < neighbor_num; i++)
 			{
@@ -424,19 +381,11 @@ namespace opencorr
 
 	void Strain::compute(std::vector<POI2DS>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i], poi_queue);
-		}
+		scheduler.run(poi_queue, [this, &poi_queue](POI2DS* poi) { compute(poi, poi_queue); });
 	}
 
 	void Strain::compute(POI3D* poi, std::vector<POI3D>& poi_queue)
 	{
-		//get instance of NearestNeighbor according to thread id
-		NearestNeighbor* neighbor_search = getInstance(omp_get_thread_num());
-
 		//3D point for approximation of nearest neighbors
 		Point3D current_point(poi->x, poi->y, poi->z);
 
@@ -445,7 +394,7 @@ namespace opencorr
 
 		//search the neighbor keypoints in a subregion of given radius
 		std::vector<nanoflann::ResultItem<uint32_t, float>> current_matches;
-		int neighbor_num = neighbor_search->radiusSearch(current_point, current_matches);
+		int neighbor_num = neighbor_search.radiusSearch(current_point, current_matches);
 		if (neighbor_num >= min_neighbor_num)
 		{
 			for (int i = 0; i < neighbor_num; i++)
@@ -462,7 +411,7 @@ namespace opencorr
 
 			std::vector<uint32_t> k_neighbors_idx;
 			std::vector<float> squared_distance;
-			neighbor_num = neighbor_search->knnSearch(current_point, k_neighbors_idx, squared_distance);
+			neighbor_num = neighbor_search.knnSearch(current_point, k_neighbors_idx, squared_distance);
 
 			for (int i = 0; i < neighbor_num; i++)
 			{
@@ -564,12 +513,7 @@ namespace opencorr
 
 	void Strain::compute(std::vector<POI3D>& poi_queue)
 	{
-		int queue_length = (int)poi_queue.size();
-#pragma omp parallel for
-		for (int i = 0; i < queue_length; i++)
-		{
-			compute(&poi_queue[i], poi_queue);
-		}
+		scheduler.run(poi_queue, [this, &poi_queue](POI3D* poi) { compute(poi, poi_queue); });
 	}
 
 
@@ -21,6 +21,7 @@
 #include "oc_nearest_neighbor.h"
 #include "oc_poi.h"
 #include "oc_point.h"
+#include "oc_scheduler.h"
 
 namespace opencorr
 {
@@ -34,8 +35,7 @@ namespace opencorr
 	class Strain
 	{
 	private:
-		std::vector<NearestNeighbor*> instance_pool;
-		NearestNeighbor* getInstance(int tid);
+		NearestNeighbor neighbor_search; //kd-tree shared by all the threads
 
 	protected:
 		float subregion_radius; //radius of subregion
@@ -46,6 +46,7 @@ namespace opencorr
 		int thread_number; //CPU thread number
 
 	public:
+		Scheduler scheduler; //distribution of POIs among threads in batch processing
 
 		Strain(float subregion_radius, int min_neighbor_num, int thread_number);
 		~Strain();
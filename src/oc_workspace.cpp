@@ -0,0 +1,94 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#include <atomic>
+
+#include "oc_workspace.h"
+
+namespace opencorr
+{
+	namespace
+	{
+		//the recently used instances of a thread, a cache hit avoids locking the pool of workspace
+		struct WorkspaceCacheEntry
+		{
+			uint64_t workspace_id;
+			void* instance;
+		};
+
+		const int WORKSPACE_CACHE_SIZE = 8;
+		thread_local WorkspaceCacheEntry workspace_cache[WORKSPACE_CACHE_SIZE] = {};
+		thread_local int workspace_cache_next = 0;
+
+		//0 is never used, thus the empty entries of cache never match
+		std::atomic<uint64_t> workspace_counter(0);
+
+		uint64_t newWorkspaceID()
+		{
+			return ++workspace_counter;
+		}
+
+		void cacheInstance(uint64_t workspace_id, void* instance)
+		{
+			workspace_cache[workspace_cache_next].workspace_id = workspace_id;
+			workspace_cache[workspace_cache_next].instance = instance;
+			workspace_cache_next = (workspace_cache_next + 1) % WORKSPACE_CACHE_SIZE;
+		}
+	}
+
+	WorkspaceBase::WorkspaceBase() : workspace_id(newWorkspaceID()) {}
+
+	void* WorkspaceBase::find()
+	{
+		//the id is only renewed when no thread is using the workspace
+		uint64_t current_id = workspace_id;
+		for (int i = 0; i < WORKSPACE_CACHE_SIZE; i++)
+		{
+			if (workspace_cache[i].workspace_id == current_id)
+			{
+				return workspace_cache[i].instance;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		auto item = pool.find(std::this_thread::get_id());
+		if (item == pool.end())
+		{
+			return nullptr;
+		}
+
+		cacheInstance(workspace_id, item->second);
+		return item->second;
+	}
+
+	void WorkspaceBase::insert(void* instance)
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pool[std::this_thread::get_id()] = instance;
+		cacheInstance(workspace_id, instance);
+	}
+
+	void WorkspaceBase::renew()
+	{
+		pool.clear();
+		workspace_id = newWorkspaceID();
+	}
+
+	int WorkspaceBase::getInstanceNumber() const
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		return (int)pool.size();
+	}
+
+}//namespace opencorr
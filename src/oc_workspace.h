@@ -0,0 +1,108 @@
+/*
+ * This file is part of OpenCorr, an open source C++ library for
+ * study and development of 2D, 3D/stereo and volumetric
+ * digital image correlation.
+ *
+ * Copyright (C) 2021, Zhenyu Jiang <zhenyujiang@scut.edu.cn>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one from http://mozilla.org/MPL/2.0/.
+ *
+ * More information about OpenCorr can be found at https://www.opencorr.org/
+ */
+
+#pragma once
+
+#ifndef _WORKSPACE_H_
+#define _WORKSPACE_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace opencorr
+{
+	//instances of a workspace without their type, one for each thread that has accessed the workspace
+	class WorkspaceBase
+	{
+	protected:
+		uint64_t workspace_id; //unique in process and renewed by clear(), keys the cache in each thread
+		mutable std::mutex pool_mutex;
+		std::unordered_map<std::thread::id, void*> pool;
+
+		WorkspaceBase();
+		~WorkspaceBase() = default;
+
+		void* find(); //instance of calling thread, nullptr if not created yet
+		void insert(void* instance); //set the instance of calling thread
+		void renew(); //forget all the instances, called with pool_mutex locked
+
+	public:
+		WorkspaceBase(const WorkspaceBase&) = delete;
+		WorkspaceBase& operator=(const WorkspaceBase&) = delete;
+
+		int getInstanceNumber() const;
+	};
+
+	//thread local working memory of an engine, e.g. subsets and Hessian matrix of IC-GN. An instance is created
+	//by the factory when a thread accesses the workspace for the first time, and reused by the thread in later
+	//calls until clear(). Any threads can be used, including OpenMP teams, nested teams and thread pools of
+	//caller, and the number of instances equals to the number of threads that have run the engine
+	template <class T>
+	class Workspace : public WorkspaceBase
+	{
+	private:
+		std::function<T*()> create_instance;
+		std::function<void(T*)> destroy_instance;
+
+	public:
+		Workspace(std::function<T*()> create_instance, std::function<void(T*)> destroy_instance)
+			: create_instance(create_instance), destroy_instance(destroy_instance) {}
+
+		~Workspace()
+		{
+			clear();
+		}
+
+		//the instance of calling thread, which must not be passed to other threads
+		T* local()
+		{
+			void* instance = find();
+			if (instance == nullptr)
+			{
+				T* created_instance = create_instance();
+				insert(created_instance);
+				instance = created_instance;
+			}
+
+			return (T*)instance;
+		}
+
+		//apply an operation to all the instances, not to be called during parallel processing
+		void forEach(std::function<void(T*)> operation)
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			for (auto& item : pool)
+			{
+				operation((T*)item.second);
+			}
+		}
+
+		//release all the instances, not to be called during parallel processing
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			for (auto& item : pool)
+			{
+				destroy_instance((T*)item.second);
+			}
+			renew();
+		}
+	};
+
+}//namespace opencorr
+
+#endif //_WORKSPACE_H_
@@ -17,11 +17,15 @@
 #ifndef _OPENCORR_
 #define _OPENCORR_
 
+#include "oc_archive.h"
 #include "oc_array.h"
 #include "oc_calibration.h"
+#include "oc_columnar.h"
 #include "oc_cubic_bspline.h"
 #include "oc_deformation.h"
 #include "oc_dic.h"
+#include "oc_distributed.h"
+#include "oc_epipolar_icgn.h"
 #include "oc_epipolar_search.h"
 #include "oc_feature.h"
 #include "oc_feature_affine.h"
@@ -31,13 +35,22 @@
 #include "oc_image.h"
 #include "oc_interpolation.h"
 #include "oc_io.h"
+#include "oc_multiview.h"
 #include "oc_nearest_neighbor.h"
 #include "oc_nr.h"
+#include "oc_numa.h"
+#include "oc_pipeline.h"
 #include "oc_poi.h"
 #include "oc_point.h"
+#include "oc_result_stream.h"
+#include "oc_scheduler.h"
+#include "oc_sgm.h"
 #include "oc_sift.h"
+#include "oc_stereo_stream.h"
+#include "oc_stereorectification.h"
 #include "oc_stereovision.h"
 #include "oc_strain.h"
 #include "oc_subset.h"
+#include "oc_workspace.h"
 
 #endif //_OPENCORR_